@@ -0,0 +1,17 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Benchmark helpers shared by the bench_*.c suites
+double bench_now(void);
+char* bench_temp_dir(void);
+void bench_remove_dir(const char *path);
+void bench_report(const char *name, double seconds, size_t bytes, int iterations);
+
+#define BENCH_SUITE(name) \
+    printf("\n=== Benchmark: %s ===\n", name)
+
+#endif // BENCH_H
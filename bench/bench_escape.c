@@ -0,0 +1,44 @@
+#include "bench.h"
+#include "../include/ciary.h"
+
+// Escape kernels over a large buffer of journal-like text, with a special
+// character roughly every 200 bytes
+void run_escape_bench(void) {
+    BENCH_SUITE("HTML Escape Kernels");
+
+    size_t size = 64 * 1024 * 1024;
+    char *text = malloc(size);
+    output_sink_t out;
+    if (!text || !output_init_memory(&out)) {
+        free(text);
+        return;
+    }
+
+    static const char filler[] = "Walked along the river after work and watched the light fade. ";
+    static const char specials[] = "<>&\"'";
+    for (size_t i = 0; i < size; i++) {
+        text[i] = (i % 199 == 198) ? specials[(i / 199) % 5] : filler[i % (sizeof(filler) - 1)];
+    }
+    printf("\nBuffer: %.1f MB\n", size / (1024.0 * 1024.0));
+
+    const char *original = html_escape_kernel_name();
+    const char *kernels[] = {"scalar", "sse2", "avx2"};
+    for (int k = 0; k < 3; k++) {
+        if (!select_html_escape_kernel(kernels[k])) {
+            printf("  %-32s (not supported)\n", kernels[k]);
+            continue;
+        }
+
+        int iterations = 5;
+        double start = bench_now();
+        for (int i = 0; i < iterations; i++) {
+            output_reset(&out);
+            write_html_escaped(&out, text, size);
+        }
+        bench_report(kernels[k], bench_now() - start, size, iterations);
+    }
+    select_html_escape_kernel(original);
+
+    free(text);
+    output_close(&out);
+}
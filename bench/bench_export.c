@@ -0,0 +1,293 @@
+#include "bench.h"
+#include "../include/ciary.h"
+
+#define JOURNAL_DAYS 50000
+
+// The HTML writer export_to_html used before the output sink: stdio with
+// one fprintf/fputc call per escaped character and per line of CSS
+static void legacy_write_html_escaped(FILE *output, const char *text, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        switch (text[i]) {
+            case '<': fprintf(output, "&lt;"); break;
+            case '>': fprintf(output, "&gt;"); break;
+            case '&': fprintf(output, "&amp;"); break;
+            default: fputc(text[i], output); break;
+        }
+    }
+}
+
+static void legacy_write_html_lines(FILE *output, const char *p, const char *end) {
+    while (p < end) {
+        const char *line_end = memchr(p, '\n', end - p);
+        if (!line_end) line_end = end;
+        size_t len = line_end - p;
+
+        if (len > 0) {
+            if (len >= 3 && strncmp(p, "```", 3) == 0) {
+                fprintf(output, "<pre><code>");
+            } else {
+                fprintf(output, "<p>");
+                legacy_write_html_escaped(output, p, len);
+                fprintf(output, "</p>\n");
+            }
+        }
+
+        p = line_end + 1;
+    }
+}
+
+static int legacy_export_to_html(const char *output_file, const entry_list_t *entries) {
+    FILE *output = fopen(output_file, "w");
+    if (!output) return 0;
+
+    fprintf(output, "<!DOCTYPE html>\n<html>\n<head>\n");
+    fprintf(output, "<meta charset=\"UTF-8\">\n");
+    fprintf(output, "<title>%s</title>\n", "Ciary Export");
+    fprintf(output, "<style>\n");
+    fprintf(output, "body { font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', Roboto, sans-serif; ");
+    fprintf(output, "max-width: 800px; margin: 40px auto; padding: 20px; line-height: 1.6; }\n");
+    fprintf(output, "h1 { color: #333; border-bottom: 3px solid #007acc; padding-bottom: 10px; }\n");
+    fprintf(output, "h2 { color: #555; margin-top: 30px; }\n");
+    fprintf(output, "h3 { color: #777; margin-top: 20px; }\n");
+    fprintf(output, "</style>\n");
+    fprintf(output, "</head>\n<body>\n");
+
+    for (int i = 0; i < entries->count; i++) {
+        const char *path = entries->items[i].path;
+        mapped_file_t file;
+        if (!map_file(path, &file)) continue;
+
+        const char *filename = strrchr(path, '/');
+        filename = filename ? filename + 1 : path;
+        fprintf(output, "<div class=\"entry-date\">\n");
+        fprintf(output, "<h2>%s</h2>\n", filename);
+
+        const char *data = file.data;
+        const char *end = data + file.length;
+        const char *p = data;
+        int in_time_section = 0;
+        while (p < end) {
+            int kind;
+            const char *header = find_next_header(data, p, end, &kind);
+            legacy_write_html_lines(output, p, header);
+            if (kind == HEADER_NONE) break;
+
+            const char *line_end = memchr(header, '\n', end - header);
+            if (!line_end) line_end = end;
+            if (kind == HEADER_SECTION) {
+                if (in_time_section) fprintf(output, "</div>\n");
+                fprintf(output, "<div class=\"entry-time\">\n");
+                fprintf(output, "<h3>");
+                legacy_write_html_escaped(output, header + 3, line_end - (header + 3));
+                fprintf(output, "</h3>\n");
+                in_time_section = 1;
+            }
+            p = (line_end < end) ? line_end + 1 : end;
+        }
+
+        if (in_time_section) fprintf(output, "</div>\n");
+        fprintf(output, "</div>\n");
+        unmap_file(&file);
+    }
+
+    fprintf(output, "</body>\n</html>\n");
+    fclose(output);
+    return 1;
+}
+
+// The Markdown export loop before splicing: fgets/fputs through a
+// 256-byte line buffer
+static int legacy_export_to_markdown(const char *output_file, const entry_list_t *entries) {
+    FILE *output = fopen(output_file, "w");
+    if (!output) return 0;
+
+    fprintf(output, "# Ciary Export\n\n---\n\n");
+    for (int i = 0; i < entries->count; i++) {
+        FILE *input = fopen(entries->items[i].path, "r");
+        if (!input) continue;
+
+        char line[MAX_LINE_SIZE];
+        while (fgets(line, sizeof(line), input)) {
+            fputs(line, output);
+        }
+        fclose(input);
+        fprintf(output, "\n---\n\n");
+    }
+
+    fclose(output);
+    return 1;
+}
+
+static size_t file_size(const char *path) {
+    struct stat st;
+    return (stat(path, &st) == 0) ? (size_t)st.st_size : 0;
+}
+
+// Write JOURNAL_DAYS consecutive day files of four sections each, with
+// the occasional character that needs escaping. Returns the journal size.
+static size_t generate_journal(const char *dir, entry_list_t *entries, date_t *first, date_t *last) {
+    static const char *paragraphs[] = {
+        "Walked to the market and bought bread, cheese and a bag of apples for the week.",
+        "Meeting ran long again; agreed that Q3 > Q2 & the roadmap needs <fewer> items.",
+        "Read two chapters before bed. The plot is finally picking up after a slow start.",
+        "Fixed the bike's rear brake & oiled the chain, then rode along the river for an hour.",
+    };
+
+    config_t config;
+    memset(&config, 0, sizeof(config));
+    snprintf(config.journal_directory, sizeof(config.journal_directory), "%s", dir);
+
+    date_t date = {1900, 1, 1};
+    *first = date;
+    size_t total = 0;
+    char path[MAX_PATH_SIZE];
+
+    for (int day = 0; day < JOURNAL_DAYS; day++) {
+        get_entry_path(date, path, &config);
+        FILE *file = fopen(path, "w");
+        if (!file) return 0;
+
+        fprintf(file, "# %d-%02d-%02d\n\n", date.year, date.month, date.day);
+        for (int s = 0; s < 4; s++) {
+            fprintf(file, "## %02d:%02d:00\n\n%s\n%s\n\n", 7 + s * 4, (day + s) % 60,
+                    paragraphs[(day + s) % 4], paragraphs[(day + s + 1) % 4]);
+        }
+        total += (size_t)ftell(file);
+        fclose(file);
+
+        add_entry_file(entries, date, path);
+        *last = date;
+        date_add_days(&date, 1);
+    }
+    return total;
+}
+
+void run_export_bench(void) {
+    BENCH_SUITE("HTML Export");
+
+    char *dir = bench_temp_dir();
+    if (!dir) {
+        printf("⚠ Skipping benchmark - could not create temp directory\n");
+        return;
+    }
+
+    entry_list_t entries;
+    init_entry_list(&entries);
+    date_t first, last;
+    size_t journal_bytes = generate_journal(dir, &entries, &first, &last);
+    if (journal_bytes == 0) {
+        printf("⚠ Skipping benchmark - could not write journal\n");
+        free_entry_list(&entries);
+        bench_remove_dir(dir);
+        return;
+    }
+    printf("\nJournal: %d day files, %.1f MB\n", entries.count, journal_bytes / (1024.0 * 1024.0));
+
+    export_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.start_date = first;
+    options.end_date = last;
+    options.format = EXPORT_FORMAT_HTML;
+    snprintf(options.output_path, sizeof(options.output_path), "%s", dir);
+
+    config_t config;
+    memset(&config, 0, sizeof(config));
+    snprintf(config.journal_directory, sizeof(config.journal_directory), "%s", dir);
+
+    char legacy_file[MAX_PATH_SIZE];
+    char output_file[MAX_PATH_SIZE];
+    snprintf(legacy_file, sizeof(legacy_file), "%s/legacy.html", dir);
+    snprintf(output_file, sizeof(output_file), "%s/ciary_export_%d-%02d-%02d_to_%d-%02d-%02d.html", dir,
+             first.year, first.month, first.day, last.year, last.month, last.day);
+
+    // Throughput is measured against the HTML produced
+    int iterations = 3;
+    double start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        legacy_export_to_html(legacy_file, &entries);
+    }
+    bench_report("stdio fprintf (legacy)", bench_now() - start, file_size(legacy_file), iterations);
+
+    // Scaling with the export worker pool; the fragment cache is cleared
+    // before each run so every day is rendered
+    char cache_dir[MAX_PATH_SIZE];
+    snprintf(cache_dir, sizeof(cache_dir), "%s/%s", dir, EXPORT_CACHE_DIR);
+    int worker_counts[] = {1, 2, 4, 8};
+    for (int w = 0; w < 4; w++) {
+        export_set_worker_count(worker_counts[w]);
+        double elapsed = 0;
+        for (int i = 0; i < iterations; i++) {
+            bench_remove_dir(cache_dir);
+            start = bench_now();
+            export_to_html(&options, &config, &entries);
+            elapsed += bench_now() - start;
+        }
+        char label[64];
+        snprintf(label, sizeof(label), "export_to_html (%d worker%s)", worker_counts[w],
+                 worker_counts[w] == 1 ? "" : "s");
+        bench_report(label, elapsed, file_size(output_file), iterations);
+    }
+    export_set_worker_count(0);
+    printf("  (%ld CPUs online)\n", sysconf(_SC_NPROCESSORS_ONLN));
+
+    // Repeat exports: nothing changed, then one day changed each time
+    export_to_html(&options, &config, &entries);
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        export_to_html(&options, &config, &entries);
+    }
+    bench_report("export_to_html (all cached)", bench_now() - start, file_size(output_file), iterations);
+
+    double elapsed = 0;
+    for (int i = 0; i < iterations; i++) {
+        FILE *file = fopen(entries.items[entries.count - 1].path, "a");
+        if (file) {
+            fprintf(file, "Appended line %d\n", i);
+            fclose(file);
+        }
+        start = bench_now();
+        export_to_html(&options, &config, &entries);
+        elapsed += bench_now() - start;
+    }
+    bench_report("export_to_html (one day changed)", elapsed, file_size(output_file), iterations);
+
+    printf("\nMarkdown export of the same journal\n");
+    snprintf(legacy_file, sizeof(legacy_file), "%s/legacy.md", dir);
+    snprintf(output_file, sizeof(output_file), "%s/ciary_export_%d-%02d-%02d_to_%d-%02d-%02d.md", dir,
+             first.year, first.month, first.day, last.year, last.month, last.day);
+
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        legacy_export_to_markdown(legacy_file, &entries);
+    }
+    bench_report("fgets/fputs (legacy)", bench_now() - start, file_size(legacy_file), iterations);
+
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        export_to_markdown(&options, &config, &entries);
+    }
+    bench_report("export_to_markdown (spliced)", bench_now() - start, file_size(output_file), iterations);
+
+    // No external converter is involved; throughput is against the journal
+    printf("\nPDF export of the same journal\n");
+    snprintf(output_file, sizeof(output_file), "%s/ciary_export_%d-%02d-%02d_to_%d-%02d-%02d.pdf", dir,
+             first.year, first.month, first.day, last.year, last.month, last.day);
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        export_to_pdf(&options, &config, &entries);
+    }
+    bench_report("export_to_pdf (built-in writer)", bench_now() - start, journal_bytes, iterations);
+    printf("  (%.1f MB of PDF)\n", file_size(output_file) / (1024.0 * 1024.0));
+
+    printf("\nNDJSON export of the same journal\n");
+    snprintf(output_file, sizeof(output_file), "%s/ciary_export_%d-%02d-%02d_to_%d-%02d-%02d.ndjson", dir,
+             first.year, first.month, first.day, last.year, last.month, last.day);
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        export_to_ndjson(&options, &config, &entries);
+    }
+    bench_report("export_to_ndjson (streamed)", bench_now() - start, file_size(output_file), iterations);
+
+    free_entry_list(&entries);
+    bench_remove_dir(dir);
+}
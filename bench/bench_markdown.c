@@ -0,0 +1,110 @@
+#include "bench.h"
+#include "../include/ciary.h"
+
+// The line converter export_to_html used before the Markdown renderer:
+// each line becomes its own <p>, fences only ever open
+static void legacy_write_html_lines(output_sink_t *output, const char *p, const char *end) {
+    while (p < end) {
+        const char *line_end = memchr(p, '\n', end - p);
+        if (!line_end) line_end = end;
+        size_t len = line_end - p;
+
+        if (len > 0) {
+            if (len >= 3 && strncmp(p, "```", 3) == 0) {
+                output_puts(output, "<pre><code>");
+            } else {
+                output_puts(output, "<p>");
+                write_html_escaped(output, p, len);
+                output_puts(output, "</p>\n");
+            }
+        }
+
+        p = line_end + 1;
+    }
+}
+
+// Journal-style Markdown: prose paragraphs with some emphasis and links,
+// lists and the odd code block
+static size_t generate_markdown(char *buffer, size_t size) {
+    static const char *blocks[] = {
+        "Walked to the market and bought bread, cheese and apples. The weather was *finally* warm\n"
+        "enough to sit outside, so I read for an hour by the river.\n\n",
+        "### Work\n"
+        "- Reviewed the **quarterly** plan & sent notes\n"
+        "- Fixed the `export` bug from [the tracker](https://example.com/issues/42)\n"
+        "- Lunch with Sam\n\n",
+        "Long day. Slept badly, then spent the morning on emails and the afternoon on the\n"
+        "garden. Need to remember to order more seeds for the _spring_ beds.\n\n",
+        "```\nmake test 2>&1 | tail -5\n```\n\n",
+        "1. Call the bank\n2. Book dentist\n3. Finish the chapter on caching\n\n",
+    };
+
+    size_t used = 0;
+    for (int i = 0;; i++) {
+        const char *block = blocks[i % 5];
+        size_t length = strlen(block);
+        if (used + length > size) break;
+        memcpy(buffer + used, block, length);
+        used += length;
+    }
+    return used;
+}
+
+void run_markdown_bench(void) {
+    BENCH_SUITE("Markdown Renderer");
+
+    size_t size = 64 * 1024 * 1024;
+    char *text = malloc(size);
+    if (!text) return;
+    size_t length = generate_markdown(text, size);
+    printf("\nInput: %.1f MB of Markdown\n", length / (1024.0 * 1024.0));
+
+    output_sink_t sink;
+    if (!output_init_memory(&sink)) {
+        free(text);
+        return;
+    }
+
+    int iterations = 5;
+    double start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        output_reset(&sink);
+        legacy_write_html_lines(&sink, text, text + length);
+    }
+    bench_report("line converter (legacy)", bench_now() - start, length, iterations);
+
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        output_reset(&sink);
+        markdown_render(&sink, text, length);
+    }
+    bench_report("markdown_render (one call)", bench_now() - start, length, iterations);
+
+    // Same input streamed in 4 KB chunks
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        output_reset(&sink);
+        markdown_renderer_t md;
+        markdown_init(&md, &sink);
+        for (size_t offset = 0; offset < length; offset += 4096) {
+            markdown_feed(&md, text + offset, (length - offset < 4096) ? length - offset : 4096);
+        }
+        markdown_finish(&md);
+    }
+    bench_report("markdown_feed (4 KB chunks)", bench_now() - start, length, iterations);
+
+    // One 16 MB line, which the old converter's callers read in fragments
+    size_t line_length = 16 * 1024 * 1024;
+    for (size_t i = 0; i < line_length; i++) {
+        text[i] = (i % 9 == 8) ? ' ' : 'a' + (i % 26);
+    }
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        output_reset(&sink);
+        markdown_render(&sink, text, line_length);
+    }
+    bench_report("markdown_render (16 MB line)", bench_now() - start, line_length, iterations);
+
+    output_close(&sink);
+    free(text);
+}
@@ -0,0 +1,94 @@
+#define _GNU_SOURCE
+#include "bench.h"
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Forward declarations for benchmark suites
+void run_scanner_bench(void);
+void run_export_bench(void);
+void run_escape_bench(void);
+void run_markdown_bench(void);
+void run_search_bench(void);
+
+double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+char* bench_temp_dir(void) {
+    static char temp_path[256];
+    snprintf(temp_path, sizeof(temp_path), "/tmp/ciary_bench_%ld_%d", (long)time(NULL), getpid());
+    
+    if (mkdir(temp_path, 0755) == 0) {
+        return temp_path;
+    }
+    return NULL;
+}
+
+void bench_remove_dir(const char *path) {
+    if (path == NULL) return;
+    
+    char command[512];
+    snprintf(command, sizeof(command), "rm -rf \"%s\"", path);
+    if (system(command) != 0) {
+        fprintf(stderr, "warning: could not remove %s\n", path);
+    }
+}
+
+// Print one result line: time per iteration and throughput
+void bench_report(const char *name, double seconds, size_t bytes, int iterations) {
+    double per_iteration = seconds / iterations;
+    double mb_per_second = (bytes / (1024.0 * 1024.0)) * iterations / seconds;
+    printf("  %-32s %10.3f ms/iter %10.1f MB/s\n", name, per_iteration * 1000.0, mb_per_second);
+}
+
+void print_usage(const char* program_name) {
+    printf("Usage: %s [benchmark]\n", program_name);
+    printf("\nBenchmarks:\n");
+    printf("  scanner        Section scanner vs. fgets line reader\n");
+    printf("  export         HTML export writer on a generated 50k-day journal\n");
+    printf("  escape         HTML escape kernels on a 64 MB buffer\n");
+    printf("  markdown       Markdown renderer on large inputs\n");
+    printf("  search         Search index on a generated 10-year journal\n");
+    printf("  all            Run all benchmarks (default)\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* suite = (argc > 1) ? argv[1] : "all";
+    
+    printf("=====================================\n");
+    printf("       CIARY BENCHMARKS\n");
+    printf("=====================================\n");
+    
+    if (strcmp(suite, "all") == 0) {
+        run_scanner_bench();
+        run_export_bench();
+        run_escape_bench();
+        run_markdown_bench();
+        run_search_bench();
+    }
+    else if (strcmp(suite, "scanner") == 0) {
+        run_scanner_bench();
+    }
+    else if (strcmp(suite, "export") == 0) {
+        run_export_bench();
+    }
+    else if (strcmp(suite, "escape") == 0) {
+        run_escape_bench();
+    }
+    else if (strcmp(suite, "markdown") == 0) {
+        run_markdown_bench();
+    }
+    else if (strcmp(suite, "search") == 0) {
+        run_search_bench();
+    }
+    else {
+        printf("Unknown benchmark: %s\n", suite);
+        print_usage(argv[0]);
+        return 1;
+    }
+    
+    return 0;
+}
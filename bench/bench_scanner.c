@@ -0,0 +1,155 @@
+#include "bench.h"
+#include "../include/ciary.h"
+
+// The count_entries implementation this replaced: fgets into a
+// MAX_LINE_SIZE buffer, so long lines are read in fragments
+static int legacy_count_entries(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) return 0;
+    
+    int count = 0;
+    char line[MAX_LINE_SIZE];
+    
+    while (fgets(line, sizeof(line), file)) {
+        if (strncmp(line, "## ", 3) == 0) {
+            count++;
+        }
+    }
+    
+    fclose(file);
+    return count;
+}
+
+// Write a day file of long paragraphs; roughly one in three paragraphs has
+// "## " where a 256-byte reader would start a new fragment
+static size_t write_day_file(const char *path, int sections, int paragraph_length) {
+    FILE *file = fopen(path, "w");
+    if (!file) return 0;
+    
+    char *paragraph = malloc(paragraph_length + 1);
+    if (!paragraph) {
+        fclose(file);
+        return 0;
+    }
+    
+    for (int i = 0; i < paragraph_length; i++) {
+        paragraph[i] = (i % 7 == 6) ? ' ' : 'a' + (i % 26);
+    }
+    paragraph[paragraph_length] = '\0';
+    
+    fprintf(file, "# 2024-07-15\n\n");
+    for (int i = 0; i < sections; i++) {
+        int split = (i % 3 == 0) && paragraph_length > MAX_LINE_SIZE + 3;
+        if (split) memcpy(paragraph + MAX_LINE_SIZE - 1, "## ", 3);
+        fprintf(file, "## %02d:%02d:%02d\n\n%s\n\n", (i / 3600) % 24, (i / 60) % 60, i % 60, paragraph);
+        if (split) memcpy(paragraph + MAX_LINE_SIZE - 1, "abc", 3);
+    }
+    
+    long size = ftell(file);
+    fclose(file);
+    free(paragraph);
+    return (size_t)size;
+}
+
+static void bench_day_file(const char *dir, const char *label, int sections, int paragraph_length,
+                           int iterations) {
+    config_t config;
+    memset(&config, 0, sizeof(config));
+    snprintf(config.journal_directory, sizeof(config.journal_directory), "%s", dir);
+    
+    date_t date = {2024, 7, 15};
+    char path[MAX_PATH_SIZE];
+    get_entry_path(date, path, &config);
+    
+    size_t bytes = write_day_file(path, sections, paragraph_length);
+    if (bytes == 0) return;
+    
+    printf("\n%s: %d sections, %d-byte paragraphs, %.1f KB\n", label, sections, paragraph_length,
+           bytes / 1024.0);
+    
+    int legacy = 0, current = 0;
+    double start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        legacy = legacy_count_entries(path);
+    }
+    bench_report("fgets (legacy)", bench_now() - start, bytes, iterations);
+    
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        current = count_entries(date, &config);
+    }
+    bench_report("count_entries (scanner)", bench_now() - start, bytes, iterations);
+    
+    section_list_t list;
+    memset(&list, 0, sizeof(list));
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        scan_entry_file(path, &list);
+    }
+    bench_report("scan_entry_file", bench_now() - start, bytes, iterations);
+    free_section_list(&list);
+    
+    printf("  sections counted: legacy=%d scanner=%d (actual %d)\n", legacy, current, sections);
+}
+
+// Whole-archive pass: count headers in one big in-memory buffer with each
+// header kernel
+static void bench_header_kernels(size_t size, int iterations) {
+    char *buffer = malloc(size);
+    if (!buffer) return;
+    
+    // ~70-character lines with a time header every 20 lines and a date
+    // header every 200
+    size_t pos = 0;
+    int line = 0;
+    while (pos + 128 < size) {
+        if (line % 200 == 0) {
+            pos += (size_t)sprintf(buffer + pos, "# 2024-07-15\n\n");
+        } else if (line % 20 == 0) {
+            pos += (size_t)sprintf(buffer + pos, "## %02d:%02d:00\n\n", line % 24, line % 60);
+        } else {
+            pos += (size_t)sprintf(buffer + pos, "Line %d of the journal, with #tags and plain text filler.\n", line);
+        }
+        line++;
+    }
+    
+    printf("\nHeader kernels: %.1f MB buffer\n", pos / (1024.0 * 1024.0));
+    
+    const char *original = header_kernel_name();
+    const char *kernels[] = {"scalar", "sse2", "avx2"};
+    for (int k = 0; k < 3; k++) {
+        if (!select_header_kernel(kernels[k])) {
+            printf("  %-32s (not supported)\n", kernels[k]);
+            continue;
+        }
+        
+        int count = 0;
+        double start = bench_now();
+        for (int i = 0; i < iterations; i++) {
+            count = count_sections(buffer, pos);
+        }
+        char label[64];
+        snprintf(label, sizeof(label), "%s (%d sections)", kernels[k], count);
+        bench_report(label, bench_now() - start, pos, iterations);
+    }
+    select_header_kernel(original);
+    
+    free(buffer);
+}
+
+void run_scanner_bench(void) {
+    BENCH_SUITE("Section Scanner");
+    
+    char *dir = bench_temp_dir();
+    if (!dir) {
+        printf("⚠ Skipping benchmark - could not create temp directory\n");
+        return;
+    }
+    
+    bench_day_file(dir, "Typical day", 8, 200, 2000);
+    bench_day_file(dir, "Long paragraphs", 2000, 2048, 20);
+    bench_day_file(dir, "Huge day file", 500, 64 * 1024, 10);
+    bench_header_kernels(256 * 1024 * 1024, 5);
+    
+    bench_remove_dir(dir);
+}
@@ -0,0 +1,363 @@
+#define _GNU_SOURCE
+#include "bench.h"
+#include "../include/ciary.h"
+#include <dirent.h>
+#include <utime.h>
+
+#define SEARCH_DAYS (10 * 365)
+
+// A made-up word from a few syllables; word n for n up to about 25k
+static void make_word(unsigned int n, char *word) {
+    static const char *syllables[] = {
+        "ka", "lo", "mi", "ne", "ru", "sa", "ti", "vo", "zen", "pha", "qui", "bor",
+        "dal", "fen", "gro", "hul", "jas", "kel", "mor", "nip", "orb", "pel", "rak", "sul",
+    };
+    word[0] = '\0';
+    do {
+        strcat(word, syllables[n % 24]);
+        n /= 24;
+    } while (n > 0);
+}
+
+static unsigned int next_random(unsigned int *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return (*seed >> 8) & 0xffffff;
+}
+
+// Ten years of day files, three sections of about 80 words each. Returns
+// the journal size.
+static size_t generate_journal(const config_t *config) {
+    date_t date = {2010, 1, 1};
+    unsigned int seed = 42;
+    size_t total = 0;
+    char path[MAX_PATH_SIZE];
+    char word[64];
+
+    for (int day = 0; day < SEARCH_DAYS; day++) {
+        get_entry_path(date, path, config);
+        FILE *file = fopen(path, "w");
+        if (!file) return 0;
+
+        fprintf(file, "# %d-%02d-%02d\n\n", date.year, date.month, date.day);
+        for (int s = 0; s < 3; s++) {
+            fprintf(file, "## %02d:%02d:00\n\n", 8 + s * 5, (day * 7 + s) % 60);
+            for (int w = 0; w < 80; w++) {
+                // Cubing skews the vocabulary: low words are common, high ones rare
+                unsigned long long u = next_random(&seed) % 100000;
+                make_word((unsigned int)(u * u * u / 40000000000ULL), word);
+                fprintf(file, (w % 12 == 11) ? "%s.\n" : "%s ", word);
+            }
+            fputs("\n\n", file);
+        }
+        // Now and then a link, for fragment searches
+        if (day % 10 == 0) {
+            fprintf(file, "See https://tracker.example.org/issue/%d\n", day * 7);
+        }
+        total += (size_t)ftell(file);
+        fclose(file);
+        date_add_days(&date, 1);
+    }
+    return total;
+}
+
+// What searching meant before the index: open every day file and look
+// for the word
+static int legacy_grep(const config_t *config, const char *word) {
+    DIR *dir = opendir(config->journal_directory);
+    if (!dir) return 0;
+
+    int matches = 0;
+    struct dirent *dirent;
+    char path[MAX_PATH_SIZE];
+    char line[MAX_LINE_SIZE];
+    while ((dirent = readdir(dir)) != NULL) {
+        date_t date;
+        if (!parse_date_from_filename(dirent->d_name, &date)) continue;
+        if (snprintf(path, sizeof(path), "%s/%s", config->journal_directory, dirent->d_name) >= (int)sizeof(path)) {
+            continue;
+        }
+        FILE *file = fopen(path, "r");
+        if (!file) continue;
+        while (fgets(line, sizeof(line), file)) {
+            if (strcasestr(line, word)) matches++;
+        }
+        fclose(file);
+    }
+    closedir(dir);
+    return matches;
+}
+
+static void report_query(const search_index_t *index, const char *query, int iterations) {
+    search_hit_t hits[100];
+    int total = 0;
+    double start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        total = search_index_query(index, query, hits, 100);
+    }
+    double elapsed = bench_now() - start;
+    printf("  query %-26s %10.3f ms/iter %8d sections\n", query, elapsed * 1000.0 / iterations, total);
+}
+
+static int count_match(const grep_match_t *match, void *context) {
+    (void)match;
+    (void)context;
+    return 1;
+}
+
+static void report_grep(const trigram_index_t *index, const config_t *config, const char *text, int flags) {
+    grep_pattern_t pattern;
+    char error[256];
+    if (!grep_pattern_compile(&pattern, text, flags, error, sizeof(error))) return;
+
+    uint32_t *days;
+    int candidates = 0;
+    if (trigram_index_candidates(index, &pattern, &days, &candidates)) free(days);
+
+    int iterations = 20;
+    int matches = 0;
+    double start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        matches = grep_journal(index, &pattern, config, 0, count_match, NULL);
+    }
+    double elapsed = bench_now() - start;
+    printf("  grep %-27s %10.3f ms/iter %5d files %6d lines\n", text, elapsed * 1000.0 / iterations,
+           candidates, matches);
+    grep_pattern_free(&pattern);
+}
+
+// The same search without an index: every file on the worker pool
+static void report_scan(const config_t *config, const char *text, int flags) {
+    grep_pattern_t pattern;
+    char error[256];
+    output_sink_t output;
+    if (!grep_pattern_compile(&pattern, text, flags, error, sizeof(error))) return;
+    if (!output_init_memory(&output)) {
+        grep_pattern_free(&pattern);
+        return;
+    }
+
+    int iterations = 10;
+    int matches = 0;
+    double start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        output_reset(&output);
+        matches = grep_scan_journal(&pattern, config, &output);
+    }
+    double elapsed = bench_now() - start;
+    printf("  scan %-27s %10.3f ms/iter %2d threads %6d lines\n", text, elapsed * 1000.0 / iterations,
+           export_worker_count(), matches);
+    output_close(&output);
+    grep_pattern_free(&pattern);
+}
+
+static void report_rank(const search_index_t *index, const char *query, int iterations) {
+    search_hit_t hits[100];
+    int total = 0;
+    double start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        total = search_index_rank(index, query, hits, 100);
+    }
+    double elapsed = bench_now() - start;
+    printf("  rank %-27s %10.3f ms/iter %8d sections\n", query, elapsed * 1000.0 / iterations, total);
+}
+
+// Poll the search panel as run_app does until its hits are current
+static void wait_for_panel(app_state_t *state) {
+    search_panel_poll(state);
+    while (search_panel_waiting(state)) {
+        usleep(100);
+        search_panel_poll(state);
+    }
+}
+
+// Type text into the search panel a key at a time. Reports the most a key
+// cost the UI thread, and how long the hits took to follow: per key when
+// waiting for each, and for the last key when typing straight through.
+static void report_typing(app_state_t *state, const char *text) {
+    double worst = 0, latency = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        handle_search_input(state, 21);  // Ctrl-U
+        double start = 0;
+        for (const char *p = text; *p; p++) {
+            start = bench_now();
+            handle_search_input(state, (unsigned char)*p);
+            double cost = bench_now() - start;
+            if (cost > worst) worst = cost;
+            if (pass == 0) {
+                wait_for_panel(state);
+                latency += bench_now() - start;
+            }
+        }
+        if (pass == 1) wait_for_panel(state);
+        if (pass == 0) latency /= strlen(text);
+        else printf("  type %-27s %10.3f ms/key   %8.3f ms to hits %8.3f ms typed straight\n", text,
+                    worst * 1000.0, latency * 1000.0, (bench_now() - start) * 1000.0);
+    }
+}
+
+void run_search_bench(void) {
+    BENCH_SUITE("Full-Text Search");
+
+    char *dir = bench_temp_dir();
+    if (!dir) {
+        printf("⚠ Skipping benchmark - could not create temp directory\n");
+        return;
+    }
+
+    config_t config;
+    memset(&config, 0, sizeof(config));
+    snprintf(config.journal_directory, sizeof(config.journal_directory), "%s", dir);
+
+    size_t journal_bytes = generate_journal(&config);
+    if (journal_bytes == 0) {
+        printf("⚠ Skipping benchmark - could not write journal\n");
+        bench_remove_dir(dir);
+        return;
+    }
+
+    journal_index_t journal;
+    journal_index_init(&journal);
+    journal_index_open(&journal, &config);
+    printf("\nJournal: %d day files, %.1f MB\n", journal.count, journal_bytes / (1024.0 * 1024.0));
+
+    // A common word, a mid-frequency one and a rare one
+    char common[64], middle[64], rare[64], query[256];
+    make_word(1, common);
+    make_word(400, middle);
+    make_word(10000, rare);
+
+    double start = bench_now();
+    int matches = legacy_grep(&config, middle);
+    printf("  %-32s %10.3f ms      %8d lines\n", "fgets + strcasestr (legacy)",
+           (bench_now() - start) * 1000.0, matches);
+
+    search_index_t index;
+    search_index_init(&index);
+    start = bench_now();
+    search_index_update(&index, &journal, &config);
+    bench_report("build index", bench_now() - start, journal_bytes, 1);
+    start = bench_now();
+    search_index_save(&index, &config);
+    printf("  %-32s %10.3f ms      %d terms, %zu postings\n", "save index", (bench_now() - start) * 1000.0,
+           index.term_count, index.posting_count);
+
+    int iterations = 20;
+    search_index_t loaded;
+    search_index_init(&loaded);
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        search_index_load(&loaded, &config);
+    }
+    printf("  %-32s %10.3f ms/iter\n", "load index", (bench_now() - start) * 1000.0 / iterations);
+
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        search_index_update(&loaded, &journal, &config);
+    }
+    printf("  %-32s %10.3f ms/iter\n", "update (nothing changed)", (bench_now() - start) * 1000.0 / iterations);
+
+    // One edited day: everything else is carried over
+    char path[MAX_PATH_SIZE];
+    date_t edited = journal.entries[journal.count / 2].date;
+    get_entry_path(edited, path, &config);
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        struct utimbuf times = {(time_t)(1000 + i), (time_t)(1000 + i)};
+        utime(path, &times);
+        journal_index_update_day(&journal, edited, &config);
+        search_index_update(&loaded, &journal, &config);
+    }
+    printf("  %-32s %10.3f ms/iter\n", "update (one day edited)", (bench_now() - start) * 1000.0 / iterations);
+
+    iterations = 1000;
+    printf("\n");
+    report_query(&loaded, common, iterations);
+    report_query(&loaded, middle, iterations);
+    report_query(&loaded, rare, iterations);
+    snprintf(query, sizeof(query), "%s %s", common, middle);
+    report_query(&loaded, query, iterations);
+    snprintf(query, sizeof(query), "%s %s %s", common, middle, rare);
+    report_query(&loaded, query, iterations);
+
+    // Ranked top 100 out of every section with any of the words
+    iterations = 200;
+    report_rank(&loaded, common, iterations);
+    report_rank(&loaded, middle, iterations);
+    snprintf(query, sizeof(query), "%s %s", common, middle);
+    report_rank(&loaded, query, iterations);
+    snprintf(query, sizeof(query), "%s %s %s", common, middle, rare);
+    report_rank(&loaded, query, iterations);
+
+    // Fragments and regexes through the trigram index
+    printf("\n");
+    trigram_index_t trigrams;
+    trigram_index_init(&trigrams);
+    start = bench_now();
+    trigram_index_update(&trigrams, &journal, &config);
+    bench_report("build trigram index", bench_now() - start, journal_bytes, 1);
+    start = bench_now();
+    trigram_index_save(&trigrams, &config);
+    printf("  %-32s %10.3f ms      %d trigrams, %zu postings\n", "save trigram index",
+           (bench_now() - start) * 1000.0, trigrams.term_count, trigrams.posting_count);
+
+    iterations = 20;
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        trigram_index_load(&trigrams, &config);
+    }
+    printf("  %-32s %10.3f ms/iter\n", "load trigram index", (bench_now() - start) * 1000.0 / iterations);
+
+    start = bench_now();
+    for (int i = 0; i < iterations; i++) {
+        struct utimbuf times = {(time_t)(2000 + i), (time_t)(2000 + i)};
+        utime(path, &times);
+        journal_index_update_day(&journal, edited, &config);
+        trigram_index_update(&trigrams, &journal, &config);
+    }
+    printf("  %-32s %10.3f ms/iter\n", "trigram update (one day edited)",
+           (bench_now() - start) * 1000.0 / iterations);
+
+    printf("\n");
+    char fragment[64];
+    snprintf(fragment, sizeof(fragment), "%.5s", rare + 1);
+    report_grep(&trigrams, &config, rare, GREP_FIXED);
+    report_grep(&trigrams, &config, fragment, GREP_FIXED | GREP_IGNORE_CASE);
+    report_grep(&trigrams, &config, middle, GREP_FIXED);
+    snprintf(query, sizeof(query), "%s [a-z]+ %s", middle, common);
+    report_grep(&trigrams, &config, query, 0);
+    report_grep(&trigrams, &config, "issue/1967", GREP_FIXED);
+    report_grep(&trigrams, &config, "[a-z]+lo\\.$", 0);
+
+    printf("\n");
+    report_scan(&config, rare, GREP_FIXED);
+    report_scan(&config, fragment, GREP_FIXED | GREP_IGNORE_CASE);
+    report_scan(&config, "issue/1967", GREP_FIXED);
+    report_scan(&config, "[a-z]+lo\\.$", 0);
+
+    // The search panel: queries on its worker while keys keep coming
+    printf("\n");
+    app_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.config = config;
+    state.index = journal;
+    search_index_init(&state.search);
+    trigram_index_init(&state.trigram);
+    open_search_panel(&state);
+    if (state.panel) {
+        report_typing(&state, "x");  // Loads the index
+        snprintf(query, sizeof(query), "%s %s", middle, common);
+        report_typing(&state, query);
+        snprintf(query, sizeof(query), "\"%s\"", fragment);
+        report_typing(&state, query);
+        report_typing(&state, "/[a-z]+lo\\.$/");
+        search_panel_free(&state);
+    }
+    trigram_index_free(&state.trigram);
+    search_index_free(&state.search);
+
+    trigram_index_free(&trigrams);
+    search_index_free(&loaded);
+    search_index_free(&index);
+    journal_index_free(&journal);
+    bench_remove_dir(dir);
+}
@@ -6,9 +6,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
+#include <stdint.h>
+#include <regex.h>
+#include <pthread.h>
 
 #define MAX_CONTENT_SIZE 8192
 #define MAX_PATH_SIZE 1024
@@ -17,12 +21,26 @@
 #define CIARY_CONFIG_DIR ".config/ciary"
 #define CIARY_DATA_DIR ".local/share/ciary"
 #define CONFIG_FILE "config.conf"
+#define JOURNAL_INDEX_FILE ".ciary-index"
+#define EXPORT_CACHE_DIR ".ciary-cache"
+#define SEARCH_INDEX_FILE ".ciary-search"
+#define TRIGRAM_INDEX_FILE ".ciary-trigram"
+
+// SSE2/AVX2 kernels are built for x86 with GCC or Clang; which one runs
+// is decided at run time through cpu_supports_kernel
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CIARY_X86_SIMD 1
+#endif
+
+// Flags for spawn_in_terminal
+#define SPAWN_PAUSE 0x1  // Wait for Enter before returning to curses
 
 // Removed view modes - only month view now
 
 typedef enum {
     MODE_CALENDAR,
-    MODE_HELP
+    MODE_HELP,
+    MODE_SEARCH
 } app_mode_t;
 
 typedef struct {
@@ -43,9 +61,19 @@ typedef struct {
 typedef enum {
     EXPORT_FORMAT_HTML,
     EXPORT_FORMAT_PDF,
-    EXPORT_FORMAT_MARKDOWN
+    EXPORT_FORMAT_MARKDOWN,
+    EXPORT_FORMAT_HTML_SITE,  // Directory of month pages with an index
+    EXPORT_FORMAT_NDJSON      // One JSON object per time section, per line
 } export_format_t;
 
+// Outcome of run_export
+typedef enum {
+    EXPORT_OK,
+    EXPORT_NO_ENTRIES,
+    EXPORT_COLLECT_FAILED,  // Journal directory couldn't be read
+    EXPORT_FAILED           // Writing the export failed
+} export_status_t;
+
 typedef enum {
     DATE_RANGE_ALL,
     DATE_RANGE_LAST_7_DAYS,
@@ -54,6 +82,106 @@ typedef enum {
     DATE_RANGE_CUSTOM
 } date_range_preset_t;
 
+// Bump allocator for strings that share a lifetime
+typedef struct {
+    struct arena_block *head;
+    size_t total;  // Bytes allocated from the system
+} arena_t;
+
+// One day file selected for export
+typedef struct {
+    date_t date;
+    const char *path;  // Points into the owning list's arena
+} entry_file_t;
+
+// Chronological list of day files; grows without a cap and keeps all paths
+// in a single arena
+typedef struct {
+    entry_file_t *items;
+    int count;
+    int capacity;
+    arena_t paths;
+} entry_list_t;
+
+// Buffered writer over a file descriptor; output is staged in user space
+// and handed to the kernel with write()/writev() only when the buffer fills.
+// A memory sink (fd -1) keeps growing instead of flushing.
+typedef struct {
+    int fd;
+    char *buffer;
+    size_t used;
+    size_t capacity;
+    int failed;    // Set on the first write or allocation error
+    int close_fd;  // Whether output_close owns the descriptor
+} output_sink_t;
+
+// Streaming Markdown renderer state; fixed size whatever the input
+#define MARKDOWN_PREFIX_MAX 16
+#define MARKDOWN_LINK_TEXT_MAX 256
+#define MARKDOWN_LINK_URL_MAX 1024
+
+typedef struct {
+    output_sink_t *output;
+    int block;          // Open block (paragraph, list item, heading, code)
+    int list;           // Open list, if any
+    int line_state;
+    int heading_level;
+    char prefix[MARKDOWN_PREFIX_MAX];  // Start of the line, until classified
+    int prefix_length;
+    unsigned char spans[4];  // Open inline spans, innermost last
+    int span_count;
+    char pending;       // '*' or '_' run waiting for the next byte
+    int pending_count;
+    unsigned char last; // Previous inline byte
+    int escaped;        // Previous byte was a backslash
+    int link_state;
+    char link_text[MARKDOWN_LINK_TEXT_MAX];
+    size_t link_text_length;
+    char link_url[MARKDOWN_LINK_URL_MAX];
+    size_t link_url_length;
+} markdown_renderer_t;
+
+// Streaming PDF writer: pages are laid out one at a time and written as
+// soon as they fill, so only the current page is held in memory
+#define PDF_LINE_MAX 512
+
+// Text styles for pdf_text
+typedef enum {
+    PDF_STYLE_BODY,
+    PDF_STYLE_CODE,
+    PDF_STYLE_NOTE,
+    PDF_STYLE_TITLE,
+    PDF_STYLE_DAY,
+    PDF_STYLE_TIME,
+    PDF_STYLE_HEADING
+} pdf_style_t;
+
+typedef struct {
+    output_sink_t *output;
+    uint64_t written;         // Bytes written to output so far
+    uint64_t *offsets;        // File offset of each object, for the xref table
+    int object_capacity;
+    int page_count;
+    int page_open;
+    output_sink_t content;    // Content stream of the open page
+    double y;                 // Baseline of the next line
+    int after_blank;          // Last output was vertical space
+    char line[PDF_LINE_MAX];  // Laid-out text not yet placed on the page
+    size_t line_length;
+    double line_width;
+    int failed;
+} pdf_writer_t;
+
+// Renders day index of an export into a memory sink. Called from export
+// worker threads, so it must not touch curses or shared state.
+typedef void (*export_render_fn)(output_sink_t *output, const entry_file_t *entry, int index,
+                                 void *context);
+
+// Called on the writing thread, in order, after each day's output has
+// been written
+typedef void (*export_written_fn)(const entry_file_t *entry, int index, const char *data,
+                                  size_t length, void *context);
+
 typedef struct {
     date_t start_date;
     date_t end_date;
@@ -62,11 +190,271 @@ typedef struct {
     int include_empty_days;
 } export_options_t;
 
+// Header kinds reported by find_next_header
+#define HEADER_NONE 0
+#define HEADER_DATE 1     // "# YYYY-MM-DD"
+#define HEADER_SECTION 2  // "## HH:MM:SS"
+
+// A whole file in memory: mmap'd when large, read() into a buffer when small
+typedef struct {
+    const char *data;
+    size_t length;
+    int mapped;
+} mapped_file_t;
+
+// Cache of rendered export fragments, one pack file per renderer under
+// EXPORT_CACHE_DIR in the journal directory
+typedef struct {
+    char path[MAX_PATH_SIZE];
+    uint32_t version;  // Renderer version; packs from others are ignored
+    int enabled;
+    mapped_file_t pack;
+    const struct fragment_record *records;
+    int record_count;
+    struct fragment_slot *slots;  // One per entry of the running export
+    int slot_count;
+    output_sink_t update;         // Replacement pack being written
+    size_t update_size;
+    int writing;
+    int write_failed;
+} fragment_cache_t;
+
+// One "## HH:MM:SS" section of a day file
+typedef struct {
+    int hour;       // -1 if the header isn't a time
+    int minute;
+    int second;
+    size_t offset;  // Offset of the "## " line
+    size_t length;  // Bytes up to the next section or end of file
+} entry_section_t;
+
+typedef struct {
+    entry_section_t *sections;
+    int count;
+    int capacity;
+} section_list_t;
+
+// Metadata for one day file, kept in the journal index
+typedef struct {
+    date_t date;
+    time_t mtime;
+    off_t size;
+    int section_count;
+    int word_count;
+    uint32_t *section_offsets;  // Byte offset of each "## " header
+} index_entry_t;
+
+// Persistent journal metadata index (JOURNAL_INDEX_FILE in the journal
+// directory). Entries are kept sorted by date.
+typedef struct {
+    index_entry_t *entries;
+    int count;
+    int capacity;
+    int dirty;
+} journal_index_t;
+
+// Full-text search index (SEARCH_INDEX_FILE in the journal directory):
+// every token maps to the "## " sections it occurs in. The structs are
+// also the on-disk records, hence the fixed-width fields.
+#define SEARCH_TOKEN_MAX 32  // Longer words are cut to this many bytes
+
+typedef struct {
+    int64_t mtime;
+    int64_t size;
+    uint32_t first_section;
+    uint32_t section_count;
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint32_t reserved;
+} search_day_t;
+
+typedef struct {
+    uint32_t day;          // Into days
+    uint32_t offset;       // Of the "## " line in the day file
+    uint32_t length;       // Bytes up to the next section or end of file
+    uint32_t token_count;
+    int8_t hour;           // -1 if the header isn't a time
+    int8_t minute;
+    int8_t second;
+    uint8_t reserved;
+} search_section_t;
+
+typedef struct {
+    uint32_t text;           // Offset in strings
+    uint32_t length;
+    uint32_t first_posting;
+    uint32_t posting_count;
+} search_term_t;
+
+typedef struct {
+    uint32_t section;
+    uint32_t frequency;      // Occurrences of the term in the section
+} search_posting_t;
+
+// Days are in date order and sections are numbered in day order, so each
+// term's postings (sorted by section) are in date order too. Terms are
+// sorted by text.
+typedef struct {
+    search_day_t *days;
+    int day_count;
+    search_section_t *sections;
+    int section_count;
+    search_term_t *terms;
+    int term_count;
+    search_posting_t *postings;
+    size_t posting_count;
+    char *strings;
+    size_t strings_length;
+    uint64_t token_total;  // Sum of the sections' token counts, for ranking
+    int dirty;
+} search_index_t;
+
+// One matching section
+typedef struct {
+    date_t date;
+    uint32_t section;  // Into search_index_t sections
+    float score;       // BM25 relevance; 0 from unranked queries
+} search_hit_t;
+
+// Trigram index (TRIGRAM_INDEX_FILE in the journal directory): every run
+// of three bytes, ASCII folded to lower case, maps to the day files that
+// contain it, so substring and regex searches only read candidate files.
+// The structs are also the on-disk records.
+typedef struct {
+    int64_t mtime;
+    int64_t size;
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint32_t reserved;
+} trigram_day_t;
+
+typedef struct {
+    uint32_t trigram;        // First byte in bits 16-23, last in bits 0-7
+    uint32_t first_posting;
+    uint32_t posting_count;
+} trigram_term_t;
+
+// Days are in date order; terms are sorted by trigram and each posting
+// list holds day numbers in ascending order
+typedef struct {
+    trigram_day_t *days;
+    int day_count;
+    trigram_term_t *terms;
+    int term_count;
+    uint32_t *postings;
+    size_t posting_count;
+    int dirty;
+} trigram_index_t;
+
+// Pattern flags for grep_pattern_compile
+#define GREP_FIXED 0x1        // Plain substring instead of an extended regex
+#define GREP_IGNORE_CASE 0x2
+
+// A compiled `ciary grep` pattern
+typedef struct {
+    int flags;
+    char *text;           // The pattern as given
+    size_t length;
+    char *literals;       // Strings every match contains, folded to lower
+    int literal_count;    // case and NUL-separated; feeds the trigram filter
+    const char *anchor;   // Longest of them, or NULL: located first with memmem
+    size_t anchor_length;
+    regex_t regex;        // Unless GREP_FIXED
+} grep_pattern_t;
+
+// One matching line, reported in file order
+typedef struct {
+    date_t date;
+    int hour;             // -1 outside a "## HH:MM:SS" section
+    int minute;
+    int second;
+    int line_number;      // 1-based, within the day file
+    size_t offset;        // Of the line in the day file
+    const char *line;     // Not NUL-terminated; valid during the callback
+    size_t length;
+} grep_match_t;
+
+// Called for each matching line; returns 0 to stop the search
+typedef int (*grep_match_fn)(const grep_match_t *match, void *context);
+
+// Heading state for grep_write_match
+typedef struct {
+    date_t date;
+    int hour;
+    int minute;
+    int second;
+    int started;
+} grep_group_t;
+
+// As-you-type search (MODE_SEARCH). Queries run on a worker thread so a
+// keystroke never waits for one: each edit posts the query under a new
+// generation, the worker runs the latest, and run_app's loop picks up the
+// hits it posts back. Replies to a superseded generation are dropped, and
+// a fragment or regex search stops as soon as it is superseded.
+#define SEARCH_MAX_HITS 1000
+#define SEARCH_QUERY_SIZE 256
+#define SEARCH_SNIPPET_SIZE 256
+#define SEARCH_POLL_MS 15      // How often run_app checks for a reply
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;         // Guards the request and reply fields
+    pthread_cond_t wake;          // A new request, or quit
+    pthread_mutex_t index_lock;   // Held while the indexes are brought up to date
+    int running;                  // Without a thread, requests are served inline
+    int quit;
+    // Request, written by the UI thread
+    char request[SEARCH_QUERY_SIZE];
+    int request_ranked;
+    int prepare;                  // Catch the indexes up before querying
+    unsigned generation;          // Of the latest request
+    unsigned served;              // Latest generation the worker has taken
+    // Reply, written by the worker
+    search_hit_t *work;           // The worker's buffer while it queries
+    search_hit_t *reply;
+    int reply_total;              // -1 with reply_error set
+    char reply_error[128];
+    double reply_ms;
+    unsigned reply_generation;
+    int reply_ready;
+    // UI thread only
+    char query[SEARCH_QUERY_SIZE];
+    size_t length;
+    int ranked;
+    unsigned shown_generation;    // Of the hits on screen
+    search_hit_t *hits;
+    int total;
+    int shown;
+    int selected;
+    int top;
+    double elapsed_ms;
+    char error[128];
+    char (*snippets)[SEARCH_SNIPPET_SIZE];  // Filled as rows come into view
+    unsigned char *snippet_ready;
+} search_panel_t;
+
+// Per-month entry counts so redraws don't have to search the index
+typedef struct {
+    int year;
+    int month;
+    int valid;
+    int counts[31];
+} month_cache_t;
+
 typedef struct {
     app_mode_t mode;
     date_t current_date;
     date_t selected_date;
     config_t config;
+    journal_index_t index;
+    month_cache_t month_cache;
+    search_index_t search;
+    int search_loaded;  // The search index is read on first use
+    trigram_index_t trigram;
+    int trigram_loaded;
+    search_panel_t *panel;  // Created on the first search
 } app_state_t;
 
 // Function declarations
@@ -79,6 +467,7 @@ void draw_calendar(app_state_t *state);
 void handle_calendar_input(app_state_t *state, int ch);
 int is_leap_year(int year);
 int days_in_month(int month, int year);
+const char* month_name(int month);
 int day_of_week(int year, int month, int day);
 
 // File I/O functions
@@ -92,14 +481,148 @@ int view_entry(date_t date, const config_t *config);
 int prompt_for_time(int *hour, int *minute, int *second);
 int is_today(date_t date);
 const char* get_actual_editor(const config_t *config);
+const char* get_actual_viewer(const config_t *config);
+void resolve_programs(const config_t *config);
+int find_in_path(const char *name, char *path, size_t size);
+
+// Month entry-count cache
+void month_cache_invalidate(month_cache_t *cache);
+int month_cache_load(month_cache_t *cache, int year, int month, const journal_index_t *index);
+int month_cache_get(const month_cache_t *cache, date_t date);
+
+// Journal index functions
+void journal_index_init(journal_index_t *index);
+void journal_index_free(journal_index_t *index);
+int journal_index_load(journal_index_t *index, const config_t *config);
+int journal_index_save(journal_index_t *index, const config_t *config);
+int journal_index_refresh(journal_index_t *index, const config_t *config);
+int journal_index_open(journal_index_t *index, const config_t *config);
+int journal_index_update_day(journal_index_t *index, date_t date, const config_t *config);
+int journal_index_lower_bound(const journal_index_t *index, date_t date);
+const index_entry_t* journal_index_find(const journal_index_t *index, date_t date);
+
+// Search functions
+void search_index_init(search_index_t *index);
+void search_index_free(search_index_t *index);
+int search_index_load(search_index_t *index, const config_t *config);
+int search_index_save(search_index_t *index, const config_t *config);
+int search_index_update(search_index_t *index, const journal_index_t *journal, const config_t *config);
+int search_index_open(search_index_t *index, const journal_index_t *journal, const config_t *config);
+int search_index_query(const search_index_t *index, const char *query, search_hit_t *hits, int max_hits);
+int search_index_rank(const search_index_t *index, const char *query, search_hit_t *hits, int max_hits);
+size_t search_next_token(const char **p, const char *end, char *token);
+
+// Search panel functions
+void open_search_panel(app_state_t *state);
+void close_search_panel(app_state_t *state);
+void draw_search_panel(app_state_t *state);
+void handle_search_input(app_state_t *state, int ch);
+int search_panel_poll(app_state_t *state);
+int search_panel_waiting(const app_state_t *state);
+void search_panel_free(app_state_t *state);
+void search_lock_indexes(app_state_t *state);
+void search_unlock_indexes(app_state_t *state);
+
+// Trigram index functions
+void trigram_index_init(trigram_index_t *index);
+void trigram_index_free(trigram_index_t *index);
+int trigram_index_load(trigram_index_t *index, const config_t *config);
+int trigram_index_save(trigram_index_t *index, const config_t *config);
+int trigram_index_update(trigram_index_t *index, const journal_index_t *journal, const config_t *config);
+int trigram_index_open(trigram_index_t *index, const journal_index_t *journal, const config_t *config);
+int trigram_index_candidates(const trigram_index_t *index, const grep_pattern_t *pattern,
+                             uint32_t **days, int *count);
+
+// Grep functions
+int grep_pattern_compile(grep_pattern_t *pattern, const char *text, int flags, char *error, size_t size);
+void grep_pattern_free(grep_pattern_t *pattern);
+int grep_buffer(const grep_pattern_t *pattern, date_t date, const char *data, size_t length,
+                grep_match_fn callback, void *context, int *matches);
+int grep_journal(const trigram_index_t *index, const grep_pattern_t *pattern, const config_t *config,
+                 int newest_first, grep_match_fn callback, void *context);
+int grep_scan_journal(const grep_pattern_t *pattern, const config_t *config, output_sink_t *output);
+void grep_write_match(output_sink_t *output, grep_group_t *group, const grep_match_t *match);
+
+// Scanner functions
+int map_file(const char *path, mapped_file_t *file);
+void unmap_file(mapped_file_t *file);
+int scan_sections(const char *data, size_t length, section_list_t *list);
+int scan_entry_file(const char *path, section_list_t *list);
+void free_section_list(section_list_t *list);
+int count_sections(const char *data, size_t length);
+int count_words(const char *data, size_t length);
+const char* find_next_header(const char *data, const char *from, const char *end, int *kind);
+const char* find_next_unfenced_header(const char *data, const char *from, const char *end, int *kind,
+                                      int *in_fence);
+const char* header_kernel_name(void);
+int select_header_kernel(const char *name);
+int cpu_supports_kernel(const char *name);
+
+// Output sink functions
+int output_open(output_sink_t *sink, const char *path);
+int output_init_fd(output_sink_t *sink, int fd);
+int output_init_memory(output_sink_t *sink);
+void output_reset(output_sink_t *sink);
+void output_write(output_sink_t *sink, const char *data, size_t length);
+void output_puts(output_sink_t *sink, const char *text);
+void output_printf(output_sink_t *sink, const char *format, ...);
+int output_splice_file(output_sink_t *sink, const char *path);
+int output_flush(output_sink_t *sink);
+int output_close(output_sink_t *sink);
+
+// HTML escaping functions
+const char* find_html_special(const char *p, const char *end);
+void write_html_escaped(output_sink_t *sink, const char *text, size_t length);
+const char* html_escape_kernel_name(void);
+int select_html_escape_kernel(const char *name);
+
+// JSON escaping functions
+void write_json_escaped(output_sink_t *sink, const char *text, size_t length);
+
+// Export fragment cache functions
+int fragment_cache_open(fragment_cache_t *cache, const config_t *config, const char *kind,
+                        uint32_t version, int count);
+int fragment_cache_fetch(fragment_cache_t *cache, int index, const entry_file_t *entry,
+                         output_sink_t *output);
+void fragment_cache_store(fragment_cache_t *cache, int index, const entry_file_t *entry,
+                          const char *data, size_t length);
+void fragment_cache_close(fragment_cache_t *cache, const entry_list_t *entries);
+
+// PDF writer functions
+int pdf_open(pdf_writer_t *pdf, output_sink_t *output);
+void pdf_text(pdf_writer_t *pdf, pdf_style_t style, const char *text, size_t length);
+void pdf_space(pdf_writer_t *pdf);
+int pdf_close(pdf_writer_t *pdf, const char *title);
+
+// Markdown rendering functions
+void markdown_init(markdown_renderer_t *md, output_sink_t *output);
+void markdown_feed(markdown_renderer_t *md, const char *data, size_t length);
+void markdown_finish(markdown_renderer_t *md);
+void markdown_render(output_sink_t *output, const char *data, size_t length);
+
+// Process functions
+int spawn_and_wait(char *const argv[]);
+int spawn_in_terminal(char *const argv[], int flags);
 
 // Utility functions
 date_t get_current_date(void);
 void date_add_days(date_t *date, int days);
 int date_compare(date_t a, date_t b);
+int date_to_days(date_t date);
+date_t days_to_date(int days);
+void arena_init(arena_t *arena);
+void* arena_alloc(arena_t *arena, size_t size);
+char* arena_strdup(arena_t *arena, const char *text);
+void arena_free(arena_t *arena);
 void draw_help(void);
 void draw_status_bar(app_state_t *state);
 
+// Command-line functions
+int run_cli(int argc, char *argv[]);
+int parse_export_args(int argc, char *argv[], export_options_t *options, char *error, size_t size);
+int parse_grep_args(int argc, char *argv[], int *flags, int *scan, const char **pattern,
+                    char *error, size_t size);
+
 // Config functions
 int ensure_config_dir(void);
 char* get_config_path(char *path);
@@ -120,11 +643,24 @@ void show_personalized_goodbye(const config_t *config);
 // Export functions
 int show_export_dialog(app_state_t *state, export_options_t *options);
 int export_entries(const export_options_t *options, const config_t *config);
-int collect_entries_in_range(const export_options_t *options, const config_t *config, char ***entry_files, int *file_count);
-int export_to_html(const export_options_t *options, const config_t *config, char **entry_files, int file_count);
-int export_to_pdf(const export_options_t *options, const config_t *config, char **entry_files, int file_count);
-int export_to_markdown(const export_options_t *options, const config_t *config, char **entry_files, int file_count);
-// libharu dependency removed - PDF export now uses external tools only
+export_status_t run_export(const export_options_t *options, const config_t *config, int *count);
+const char* export_format_name(export_format_t format);
+void init_entry_list(entry_list_t *entries);
+int add_entry_file(entry_list_t *entries, date_t date, const char *path);
+void free_entry_list(entry_list_t *entries);
+int collect_entries_in_range(const export_options_t *options, const config_t *config, entry_list_t *entries);
+int export_to_html(const export_options_t *options, const config_t *config, const entry_list_t *entries);
+int export_to_pdf(const export_options_t *options, const config_t *config, const entry_list_t *entries);
+int export_to_markdown(const export_options_t *options, const config_t *config, const entry_list_t *entries);
+int export_to_html_site(const export_options_t *options, const config_t *config, const entry_list_t *entries);
+int export_to_ndjson(const export_options_t *options, const config_t *config, const entry_list_t *entries);
+int export_writes_to_stdout(const export_options_t *options);
+// PDF export uses the built-in writer in pdf.c (no libharu)
+int run_export_pipeline(const entry_list_t *entries, export_render_fn render,
+                        export_written_fn written, void *context, output_sink_t *output,
+                        const char *progress_message);
+void export_set_worker_count(int count);
+int export_worker_count(void);
 void show_progress_bar(const char *message, int current, int total);
 void calculate_date_range(date_range_preset_t preset, date_t current_date, date_t *start, date_t *end);
 bool parse_date_from_filename(const char* filename, date_t* date);
@@ -1,10 +1,5 @@
 #include "ciary.h"
 
-static const char *month_names[] = {
-    "January", "February", "March", "April", "May", "June",
-    "July", "August", "September", "October", "November", "December"
-};
-
 static const char *day_names[] = {
     "Su", "Mo", "Tu", "We", "Th", "Fr", "Sa"
 };
@@ -19,7 +14,7 @@ void draw_calendar(app_state_t *state) {
     int title_row = 2;
     char title[64];
     snprintf(title, sizeof(title), "%s %d", 
-             month_names[state->current_date.month - 1], 
+             month_name(state->current_date.month), 
              state->current_date.year);
     mvprintw(title_row, (cols - strlen(title)) / 2, "%s", title);
     
@@ -32,6 +27,10 @@ void draw_calendar(app_state_t *state) {
             mvprintw(start_row, start_col + i * 3, "%s", day_names[i]);
         }
         
+        // Entry counts come from the month cache, filled from the journal index
+        month_cache_load(&state->month_cache, state->current_date.year,
+                         state->current_date.month, &state->index);
+        
         // Calculate first day of month
         int first_day = day_of_week(state->current_date.year, state->current_date.month, 1);
         int days = days_in_month(state->current_date.month, state->current_date.year);
@@ -52,7 +51,7 @@ void draw_calendar(app_state_t *state) {
                                   state->current_date.year == state->selected_date.year);
                 
                 date_t check_date = {state->current_date.year, state->current_date.month, day};
-                int entry_count = count_entries(check_date, &state->config);
+                int entry_count = month_cache_get(&state->month_cache, check_date);
                 
                 if (is_selected) {
                     attron(A_REVERSE);
@@ -79,7 +78,7 @@ void draw_calendar(app_state_t *state) {
     const char* editor = get_actual_editor(&state->config);
     const char* new_text = (strcmp(editor, "nano") == 0) ? "Enter: New" : "n: New";
     char instructions[256];
-    snprintf(instructions, sizeof(instructions), "Arrows: Navigate  %s  v: View  h: Help  q: Quit", new_text);
+    snprintf(instructions, sizeof(instructions), "Arrows: Navigate  %s  v: View  /: Search  h: Help  q: Quit", new_text);
     mvprintw(rows - 3, 2, "%s", instructions);
     
     draw_status_bar(state);
@@ -222,6 +221,16 @@ void handle_calendar_input(app_state_t *state, int ch) {
                     open_entry_with_time(state->selected_date, hour, minute, second, &state->config);
                 }
             }
+            // The editor may have changed the day file; the index only
+            // reparses it if its mtime or size moved. The search worker may
+            // still be reading it.
+            search_lock_indexes(state);
+            if (journal_index_update_day(&state->index, state->selected_date, &state->config) &&
+                state->index.dirty) {
+                month_cache_invalidate(&state->month_cache);
+                journal_index_save(&state->index, &state->config);
+            }
+            search_unlock_indexes(state);
             break;
             
         case 'v':
@@ -229,6 +238,11 @@ void handle_calendar_input(app_state_t *state, int ch) {
             view_entry(state->selected_date, &state->config);
             break;
             
+        case '/':
+            // Full-text search as you type; picking a result moves the selection
+            open_search_panel(state);
+            break;
+            
         case 'e':
             // Export entries
             {
@@ -0,0 +1,308 @@
+#include "ciary.h"
+
+// Command-line subcommands, handled before curses is started so they run
+// without a terminal (e.g. from cron)
+
+static void print_usage(FILE *stream) {
+    fprintf(stream,
+            "Usage: ciary                Start the calendar\n"
+            "       ciary export [options]\n"
+            "       ciary grep [-F] [-i] [--scan] PATTERN\n"
+            "\n"
+            "Export options:\n"
+            "  --from YYYY-MM-DD   First day to export (default: earliest entry)\n"
+            "  --to YYYY-MM-DD     Last day to export (default: latest entry)\n"
+            "  --format FORMAT     html, md, pdf, site or ndjson (default: html)\n"
+            "  --out DIR           Directory to write to (default: the journal directory),\n"
+            "                      or - to write a single-file export to stdout\n"
+            "\n"
+            "Grep options:\n"
+            "  -F                  PATTERN is a plain string, not an extended regex\n"
+            "  -i                  Ignore case (ASCII letters for -F)\n"
+            "  --scan              Read every day file instead of using the trigram index\n"
+            "                      (the default until the index has been built)\n");
+}
+
+// Strict YYYY-MM-DD of a real date
+static int parse_cli_date(const char *text, date_t *date) {
+    char name[16];
+    if (strlen(text) != 10) return 0;
+    snprintf(name, sizeof(name), "%s.md", text);
+    return parse_date_from_filename(name, date);
+}
+
+static int parse_cli_format(const char *text, export_format_t *format) {
+    static const struct {
+        const char *name;
+        export_format_t format;
+    } formats[] = {
+        {"html", EXPORT_FORMAT_HTML},
+        {"pdf", EXPORT_FORMAT_PDF},
+        {"md", EXPORT_FORMAT_MARKDOWN},
+        {"markdown", EXPORT_FORMAT_MARKDOWN},
+        {"site", EXPORT_FORMAT_HTML_SITE},
+        {"ndjson", EXPORT_FORMAT_NDJSON},
+    };
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        if (strcmp(text, formats[i].name) == 0) {
+            *format = formats[i].format;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Parse the arguments after "export" into options. Dates that aren't
+// given are left zeroed (year 0) and the output directory empty, for the
+// caller to fill in. Returns 0 and describes the problem in error on bad
+// usage.
+int parse_export_args(int argc, char *argv[], export_options_t *options, char *error, size_t size) {
+    memset(options, 0, sizeof(*options));
+    options->format = EXPORT_FORMAT_HTML;
+
+    for (int i = 0; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--from") != 0 && strcmp(arg, "--to") != 0 &&
+            strcmp(arg, "--format") != 0 && strcmp(arg, "--out") != 0) {
+            snprintf(error, size, "unknown option '%s'", arg);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            snprintf(error, size, "%s needs a value", arg);
+            return 0;
+        }
+        const char *value = argv[++i];
+
+        if (strcmp(arg, "--from") == 0 || strcmp(arg, "--to") == 0) {
+            date_t *date = (arg[2] == 'f') ? &options->start_date : &options->end_date;
+            if (!parse_cli_date(value, date)) {
+                snprintf(error, size, "%s expects a date as YYYY-MM-DD, got '%s'", arg, value);
+                return 0;
+            }
+        } else if (strcmp(arg, "--format") == 0) {
+            if (!parse_cli_format(value, &options->format)) {
+                snprintf(error, size, "unknown format '%s' (use html, md, pdf, site or ndjson)", value);
+                return 0;
+            }
+        } else {
+            if (value[0] == '\0' || strlen(value) >= sizeof(options->output_path)) {
+                snprintf(error, size, "invalid output directory '%s'", value);
+                return 0;
+            }
+            snprintf(options->output_path, sizeof(options->output_path), "%s", value);
+        }
+    }
+
+    if (options->format == EXPORT_FORMAT_HTML_SITE && export_writes_to_stdout(options)) {
+        snprintf(error, size, "site exports write a directory and can't go to stdout");
+        return 0;
+    }
+    if (options->start_date.year != 0 && options->end_date.year != 0 &&
+        date_compare(options->start_date, options->end_date) > 0) {
+        snprintf(error, size, "--from is after --to");
+        return 0;
+    }
+    return 1;
+}
+
+static int cli_export(int argc, char *argv[]) {
+    export_options_t options;
+    char error[256];
+    if (!parse_export_args(argc, argv, &options, error, sizeof(error))) {
+        fprintf(stderr, "ciary export: %s\n", error);
+        print_usage(stderr);
+        return 2;
+    }
+
+    // Never prompts: a missing config file just means the defaults
+    config_t config;
+    if (load_config(&config) != 0) {
+        load_default_config(&config);
+    }
+    if (options.output_path[0] == '\0') {
+        snprintf(options.output_path, sizeof(options.output_path), "%s", config.journal_directory);
+    }
+
+    // An open-ended range stops at the first or last entry, which also
+    // keeps the export's file name meaningful
+    if (options.start_date.year == 0 || options.end_date.year == 0) {
+        date_t first, last;
+        calculate_date_range(DATE_RANGE_ALL, get_current_date(), &first, &last);
+
+        journal_index_t index;
+        journal_index_init(&index);
+        if (journal_index_open(&index, &config) && index.count > 0) {
+            first = index.entries[0].date;
+            last = index.entries[index.count - 1].date;
+        }
+        journal_index_free(&index);
+
+        if (options.start_date.year == 0) options.start_date = first;
+        if (options.end_date.year == 0) options.end_date = last;
+    }
+
+    int count = 0;
+    switch (run_export(&options, &config, &count)) {
+        case EXPORT_OK:
+            // When the export itself is on stdout, keep the summary out of it
+            fprintf(export_writes_to_stdout(&options) ? stderr : stdout,
+                    "Exported %d entries to %s (%s)\n", count,
+                    export_writes_to_stdout(&options) ? "stdout" : options.output_path,
+                    export_format_name(options.format));
+            return 0;
+        case EXPORT_NO_ENTRIES:
+            fprintf(stderr, "ciary export: no entries found in the specified date range\n");
+            return 1;
+        case EXPORT_COLLECT_FAILED:
+            fprintf(stderr, "ciary export: cannot read journal directory %s\n", config.journal_directory);
+            return 1;
+        case EXPORT_FAILED:
+            break;
+    }
+    fprintf(stderr, "ciary export: export to %s failed\n",
+            export_writes_to_stdout(&options) ? "stdout" : options.output_path);
+    return 1;
+}
+
+// Parse the arguments after "grep": options first, then the pattern
+int parse_grep_args(int argc, char *argv[], int *flags, int *scan, const char **pattern,
+                    char *error, size_t size) {
+    *flags = 0;
+    *scan = 0;
+    *pattern = NULL;
+
+    int i = 0;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+        if (strcmp(argv[i], "--") == 0) {
+            i++;
+            break;
+        }
+        if (strcmp(argv[i], "--scan") == 0) {
+            *scan = 1;
+            continue;
+        }
+        for (const char *c = argv[i] + 1; *c; c++) {
+            if (*c == 'F') {
+                *flags |= GREP_FIXED;
+            } else if (*c == 'i') {
+                *flags |= GREP_IGNORE_CASE;
+            } else {
+                snprintf(error, size, "unknown option '%s'", argv[i]);
+                return 0;
+            }
+        }
+    }
+
+    if (i >= argc) {
+        snprintf(error, size, "missing PATTERN");
+        return 0;
+    }
+    if (i + 1 < argc) {
+        snprintf(error, size, "unexpected argument '%s'", argv[i + 1]);
+        return 0;
+    }
+    *pattern = argv[i];
+    return 1;
+}
+
+typedef struct {
+    output_sink_t *output;
+    grep_group_t group;
+} grep_printer_t;
+
+static int print_grep_match(const grep_match_t *match, void *context) {
+    grep_printer_t *printer = context;
+    grep_write_match(printer->output, &printer->group, match);
+    return 1;
+}
+
+// Search with the trigram index, bringing it and the journal index up to
+// date first. Returns the number of matching lines, or -1.
+static int grep_with_index(trigram_index_t *index, const grep_pattern_t *pattern, const config_t *config,
+                           output_sink_t *output) {
+    journal_index_t journal;
+    journal_index_init(&journal);
+    int matches = -1;
+    if (journal_index_open(&journal, config) && trigram_index_update(index, &journal, config)) {
+        trigram_index_save(index, config);
+        grep_printer_t printer;
+        memset(&printer, 0, sizeof(printer));
+        printer.output = output;
+        matches = grep_journal(index, pattern, config, 0, print_grep_match, &printer);
+    }
+    journal_index_free(&journal);
+    return matches;
+}
+
+// Print every matching line, grouped under the day and time section it's
+// in. Like grep(1), exits 0 if something matched and 1 if nothing did.
+static int cli_grep(int argc, char *argv[]) {
+    int flags, scan;
+    const char *text;
+    char error[256];
+    if (!parse_grep_args(argc, argv, &flags, &scan, &text, error, sizeof(error))) {
+        fprintf(stderr, "ciary grep: %s\n", error);
+        print_usage(stderr);
+        return 2;
+    }
+
+    grep_pattern_t pattern;
+    if (!grep_pattern_compile(&pattern, text, flags, error, sizeof(error))) {
+        fprintf(stderr, "ciary grep: invalid pattern: %s\n", error);
+        return 2;
+    }
+
+    config_t config;
+    if (load_config(&config) != 0) {
+        load_default_config(&config);
+    }
+
+    output_sink_t output;
+    fflush(stdout);
+    if (!output_init_fd(&output, STDOUT_FILENO)) {
+        grep_pattern_free(&pattern);
+        return 2;
+    }
+
+    // The index is built by the calendar's fragment search. Until then,
+    // or when asked, every file is read on the worker pool; that needs
+    // no index at all, not even the journal's.
+    trigram_index_t index;
+    trigram_index_init(&index);
+    int matches;
+    if (!scan && trigram_index_load(&index, &config)) {
+        matches = grep_with_index(&index, &pattern, &config, &output);
+    } else {
+        matches = grep_scan_journal(&pattern, &config, &output);
+    }
+    trigram_index_free(&index);
+    grep_pattern_free(&pattern);
+
+    int written = output_close(&output);
+    if (matches < 0) {
+        fprintf(stderr, "ciary grep: cannot read journal directory %s\n", config.journal_directory);
+        return 2;
+    }
+    if (!written) return 2;
+    return matches > 0 ? 0 : 1;
+}
+
+// Run the subcommand named by argv[1]. Returns the process exit status.
+int run_cli(int argc, char *argv[]) {
+    const char *command = argv[1];
+
+    if (strcmp(command, "export") == 0) {
+        return cli_export(argc - 2, argv + 2);
+    }
+    if (strcmp(command, "grep") == 0) {
+        return cli_grep(argc - 2, argv + 2);
+    }
+    if (strcmp(command, "--help") == 0 || strcmp(command, "-h") == 0 || strcmp(command, "help") == 0) {
+        print_usage(stdout);
+        return 0;
+    }
+
+    fprintf(stderr, "ciary: unknown command '%s'\n", command);
+    print_usage(stderr);
+    return 2;
+}
@@ -0,0 +1,13 @@
+#include "ciary.h"
+
+// Whether this build and CPU can run the kernel variant called name. The
+// SIMD kernel tables (header scan, HTML escape) name their variants
+// "avx2", "sse2" and "scalar"; the scalar one runs everywhere.
+int cpu_supports_kernel(const char *name) {
+#ifdef CIARY_X86_SIMD
+    __builtin_cpu_init();
+    if (strcmp(name, "avx2") == 0) return __builtin_cpu_supports("avx2");
+    if (strcmp(name, "sse2") == 0) return __builtin_cpu_supports("sse2");
+#endif
+    return strcmp(name, "scalar") == 0;
+}
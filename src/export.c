@@ -1,29 +1,35 @@
+#define _GNU_SOURCE
 #include "../include/ciary.h"
-#include <dirent.h>
-#include <sys/wait.h>
+#include <fcntl.h>
 
-// Removed libharu dependency - using external PDF tools only
+// PDF export uses the built-in writer in pdf.c (no libharu)
 
-// Parse date from filename (YYYY-MM-DD.md format)
+// Parse date from filename (YYYY-MM-DD.md format). Only canonical names
+// of real dates are accepted, so each day maps to exactly one file.
 bool parse_date_from_filename(const char* filename, date_t* date) {
     if (!filename || !date) return false;
     
-    // Check if filename ends with .md
-    size_t len = strlen(filename);
-    if (len < 13 || strcmp(filename + len - 3, ".md") != 0) {
+    // Check for exactly YYYY-MM-DD.md
+    if (strlen(filename) != 13 || strcmp(filename + 10, ".md") != 0 ||
+        filename[4] != '-' || filename[7] != '-') {
         return false;
     }
     
-    // Parse YYYY-MM-DD format
-    int year, month, day;
-    if (sscanf(filename, "%d-%d-%d.md", &year, &month, &day) != 3) {
-        return false;
+    static const int digit_positions[] = {0, 1, 2, 3, 5, 6, 8, 9};
+    for (int i = 0; i < 8; i++) {
+        char c = filename[digit_positions[i]];
+        if (c < '0' || c > '9') return false;
     }
     
+    int year = (filename[0] - '0') * 1000 + (filename[1] - '0') * 100 +
+               (filename[2] - '0') * 10 + (filename[3] - '0');
+    int month = (filename[5] - '0') * 10 + (filename[6] - '0');
+    int day = (filename[8] - '0') * 10 + (filename[9] - '0');
+    
     // Validate date values
     if (year < 1900 || year > 3000 || 
         month < 1 || month > 12 ||
-        day < 1 || day > 31) {
+        day < 1 || day > days_in_month(month, year)) {
         return false;
     }
     
@@ -72,6 +78,17 @@ void calculate_date_range(date_range_preset_t preset, date_t current_date, date_
     }
 }
 
+const char* export_format_name(export_format_t format) {
+    switch (format) {
+        case EXPORT_FORMAT_HTML: return "HTML";
+        case EXPORT_FORMAT_PDF: return "PDF";
+        case EXPORT_FORMAT_MARKDOWN: return "Markdown";
+        case EXPORT_FORMAT_HTML_SITE: return "HTML site";
+        case EXPORT_FORMAT_NDJSON: return "NDJSON";
+    }
+    return "unknown";
+}
+
 // Show progress bar
 void show_progress_bar(const char *message, int current, int total) {
     // Check if ncurses is initialized by testing if stdscr exists
@@ -79,6 +96,9 @@ void show_progress_bar(const char *message, int current, int total) {
     if (!stdscr) {
         return;  // Skip progress bar in test environment
     }
+    if (!message) {
+        return;  // Caller doesn't want progress shown
+    }
     
     int bar_width = 40;
     float progress = (float)current / total;
@@ -185,31 +205,13 @@ int show_export_dialog(app_state_t *state, export_options_t *options) {
     
     // Format selection with dynamic availability
     mvprintw(16, 4, "Export format:");
-    mvprintw(17, 6, "1. HTML (always available)");
-    
-    // Check PDF availability (external tools only)
-    int pdf_available = 0;
-    char pdf_note[256] = "";
-    
-    // Check for external PDF tools
-    if (system("which wkhtmltopdf > /dev/null 2>&1") == 0) {
-        pdf_available = 1;
-        strcpy(pdf_note, "2. PDF (via wkhtmltopdf)");
-    } else if (system("which weasyprint > /dev/null 2>&1") == 0) {
-        pdf_available = 1;
-        strcpy(pdf_note, "2. PDF (via weasyprint)");
-    } else {
-        strcpy(pdf_note, "2. PDF (unavailable - install wkhtmltopdf or weasyprint)");
-    }
+    mvprintw(17, 6, "1. HTML");
+    mvprintw(18, 6, "2. PDF");
+    mvprintw(19, 6, "3. Markdown");
+    mvprintw(20, 6, "4. HTML site - index and one page per month");
+    mvprintw(21, 6, "5. NDJSON - one JSON object per time section");
     
-    mvprintw(18, 6, "%s", pdf_note);
-    mvprintw(19, 6, "3. Markdown (always available)");
-    
-    if (pdf_available) {
-        mvprintw(21, 4, "Format [1-3]: ");
-    } else {
-        mvprintw(21, 4, "Format [1,3] (PDF unavailable): ");
-    }
+    mvprintw(22, 4, "Format [1-5]: ");
     refresh();
     
     echo();  // Enable echo to show user input
@@ -225,18 +227,17 @@ int show_export_dialog(app_state_t *state, export_options_t *options) {
             options->format = EXPORT_FORMAT_HTML; 
             break;
         case 2: 
-            if (pdf_available) {
-                options->format = EXPORT_FORMAT_PDF;
-            } else {
-                mvprintw(23, 4, "PDF export not available. Press any key to continue...");
-                refresh();
-                getch();
-                return 0;
-            }
+            options->format = EXPORT_FORMAT_PDF;
             break;
         case 3: 
             options->format = EXPORT_FORMAT_MARKDOWN; 
             break;
+        case 4:
+            options->format = EXPORT_FORMAT_HTML_SITE;
+            break;
+        case 5:
+            options->format = EXPORT_FORMAT_NDJSON;
+            break;
         default: 
             return 0;
     }
@@ -255,8 +256,7 @@ int show_export_dialog(app_state_t *state, export_options_t *options) {
     mvprintw(27, 4, "Export %d-%02d-%02d to %d-%02d-%02d in %s format? (y/N): ",
              options->start_date.year, options->start_date.month, options->start_date.day,
              options->end_date.year, options->end_date.month, options->end_date.day,
-             (options->format == EXPORT_FORMAT_HTML) ? "HTML" :
-             (options->format == EXPORT_FORMAT_PDF) ? "PDF" : "Markdown");
+             export_format_name(options->format));
     refresh();
     
     echo();  // Enable echo to show user input
@@ -268,387 +268,806 @@ int show_export_dialog(app_state_t *state, export_options_t *options) {
     return (input[0] == 'y' || input[0] == 'Y');
 }
 
-// Helper structure for sorting entries by date
-typedef struct {
-    char *filename;
-    date_t date;
-} entry_file_t;
-
-// Comparison function for qsort to sort entries chronologically
-int compare_entry_files(const void *a, const void *b) {
-    const entry_file_t *entry_a = (const entry_file_t *)a;
-    const entry_file_t *entry_b = (const entry_file_t *)b;
-    
-    return date_compare(entry_a->date, entry_b->date);
+void init_entry_list(entry_list_t *entries) {
+    entries->items = NULL;
+    entries->count = 0;
+    entries->capacity = 0;
+    arena_init(&entries->paths);
 }
 
-// Collect all entry files in the specified date range (sorted chronologically)
-int collect_entries_in_range(const export_options_t *options, const config_t *config, 
-                           char ***entry_files, int *file_count) {
-    DIR *dir;
-    struct dirent *entry;
-    entry_file_t entries[1000];  // Reasonable limit
-    int count = 0;
+// Append a day file; the path is copied into the list's arena
+int add_entry_file(entry_list_t *entries, date_t date, const char *path) {
+    if (entries->count == entries->capacity) {
+        int capacity = entries->capacity ? entries->capacity * 2 : 64;
+        entry_file_t *items = realloc(entries->items, capacity * sizeof(entry_file_t));
+        if (!items) return 0;
+        entries->items = items;
+        entries->capacity = capacity;
+    }
     
-    // Initialize entries array to prevent undefined behavior
-    memset(entries, 0, sizeof(entries));
+    char *copy = arena_strdup(&entries->paths, path);
+    if (!copy) return 0;
     
-    dir = opendir(config->journal_directory);
-    if (!dir) {
+    entries->items[entries->count].date = date;
+    entries->items[entries->count].path = copy;
+    entries->count++;
+    return 1;
+}
+
+void free_entry_list(entry_list_t *entries) {
+    free(entries->items);
+    arena_free(&entries->paths);
+    init_entry_list(entries);
+}
+
+// Ranges up to this many days are collected by probing each candidate
+// filename instead of listing the whole journal directory
+#define PROBE_RANGE_DAYS 366
+
+// Stat YYYY-MM-DD.md for every day in the range. Days are visited in
+// order, so the result needs no sorting and readdir is never called.
+static int probe_entries_in_range(int first_day, int last_day, const config_t *config,
+                                  entry_list_t *entries) {
+    char path[MAX_PATH_SIZE];
+    char name[16];
+    
+    int dir_fd = open(config->journal_directory, O_RDONLY | O_DIRECTORY);
+    if (dir_fd < 0) {
         return 0;
     }
     
-    // Collect all valid entries with their dates
-    while ((entry = readdir(dir)) != NULL && count < 1000) {
-        // Check if it's a .md file with date format YYYY-MM-DD.md
-        if (strstr(entry->d_name, ".md") && strlen(entry->d_name) == 13) {
-            date_t file_date;
-            if (sscanf(entry->d_name, "%d-%d-%d.md", 
-                      &file_date.year, &file_date.month, &file_date.day) == 3) {
-                
-                // Check if file date is in range
-                if (date_compare(file_date, options->start_date) >= 0 &&
-                    date_compare(file_date, options->end_date) <= 0) {
-                    
-                    // Allocate memory for filename
-                    entries[count].filename = malloc(MAX_PATH_SIZE);
-                    if (entries[count].filename) {
-                        int result = snprintf(entries[count].filename, MAX_PATH_SIZE, "%s/%s", 
-                                config->journal_directory, entry->d_name);
-                        if (result > 0 && result < MAX_PATH_SIZE) {
-                            entries[count].date = file_date;
-                            count++;
-                        } else {
-                            free(entries[count].filename);
-                        }
-                    }
-                }
-            }
+    for (int day = first_day; day <= last_day; day++) {
+        date_t date = days_to_date(day);
+        snprintf(name, sizeof(name), "%04d-%02d-%02d.md", date.year, date.month, date.day);
+        
+        struct stat st;
+        if (fstatat(dir_fd, name, &st, 0) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        
+        if (get_entry_path(date, path, config) && !add_entry_file(entries, date, path)) {
+            close(dir_fd);
+            free_entry_list(entries);
+            return 0;
         }
     }
     
-    closedir(dir);
+    close(dir_fd);
+    return 1;
+}
+
+// Collect all entry files in the specified date range (sorted chronologically).
+// Short ranges probe candidate filenames directly; longer ones answer from
+// the journal index, which keeps entries in day order without sorting.
+int collect_entries_in_range(const export_options_t *options, const config_t *config, 
+                           entry_list_t *entries) {
+    journal_index_t index;
+    char path[MAX_PATH_SIZE];
+    
+    init_entry_list(entries);
     
-    if (count == 0) {
-        *entry_files = NULL;
-        *file_count = 0;
-        return 1;
+    int first_day = date_to_days(options->start_date);
+    int last_day = date_to_days(options->end_date);
+    if (last_day < first_day) {
+        // Empty range, but still fail if the journal can't be read
+        return access(config->journal_directory, R_OK | X_OK) == 0;
     }
     
-    // Sort entries chronologically
-    qsort(entries, count, sizeof(entry_file_t), compare_entry_files);
+    if (last_day - first_day < PROBE_RANGE_DAYS) {
+        return probe_entries_in_range(first_day, last_day, config, entries);
+    }
     
-    // Allocate array for return
-    *entry_files = malloc(count * sizeof(char*));
-    if (!*entry_files) {
-        // Free allocated memory on failure
-        for (int i = 0; i < count; i++) {
-            free(entries[i].filename);
-        }
+    journal_index_init(&index);
+    if (!journal_index_open(&index, config)) {
+        journal_index_free(&index);
         return 0;
     }
     
-    // Copy sorted file pointers
-    for (int i = 0; i < count; i++) {
-        (*entry_files)[i] = entries[i].filename;
+    // Index entries are sorted, so the range is one contiguous run
+    for (int i = journal_index_lower_bound(&index, options->start_date); i < index.count; i++) {
+        date_t date = index.entries[i].date;
+        if (date_compare(date, options->end_date) > 0) break;
+        
+        if (get_entry_path(date, path, config) && !add_entry_file(entries, date, path)) {
+            free_entry_list(entries);
+            journal_index_free(&index);
+            return 0;
+        }
     }
     
-    *file_count = count;
+    journal_index_free(&index);
     return 1;
 }
 
-// Export entries to HTML format
-int export_to_html(const export_options_t *options, const config_t *config, 
-                  char **entry_files, int file_count) {
-    (void)config;  // Suppress unused parameter warning
-    char output_file[MAX_PATH_SIZE];
-    FILE *output;
-    FILE *input;
-    char line[MAX_LINE_SIZE];
-    char title[256];
+// Stylesheet embedded in every HTML export
+static const char html_style[] =
+    "<style>\n"
+    "body { font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', Roboto, sans-serif; "
+    "max-width: 800px; margin: 40px auto; padding: 20px; line-height: 1.6; }\n"
+    "h1 { color: #333; border-bottom: 3px solid #007acc; padding-bottom: 10px; }\n"
+    "h2 { color: #555; margin-top: 30px; }\n"
+    "h3 { color: #777; margin-top: 20px; }\n"
+    ".entry-date { background: #f8f9fa; padding: 15px; border-left: 4px solid #007acc; margin: 20px 0; }\n"
+    ".entry-time { background: #fff; border-left: 3px solid #ddd; padding: 10px; margin: 10px 0; }\n"
+    "pre { background: #f8f9fa; padding: 10px; border-radius: 4px; overflow-x: auto; }\n"
+    "code { background: #f1f1f1; padding: 2px 4px; border-radius: 3px; }\n"
+    ".footer { margin-top: 40px; text-align: center; color: #666; font-size: 0.9em; }\n"
+    ".nav { display: flex; justify-content: space-between; margin: 20px 0; }\n"
+    "</style>\n";
+
+// Bump whenever render_html_day's output changes, so cached fragments
+// from older builds are re-rendered
+#define HTML_RENDERER_VERSION 4
+
+#define OUTPUT_LITERAL(sink, text) output_write((sink), (text), sizeof(text) - 1)
+
+// An output path of "-" sends single-file exports to stdout
+int export_writes_to_stdout(const export_options_t *options) {
+    return strcmp(options->output_path, "-") == 0;
+}
+
+// Open the sink for a single-file export: stdout for "-", otherwise
+// ciary_export_<range>.<extension> in the output directory. file is set
+// to the path written, or "" for stdout, so a failed export can be
+// removed.
+static int open_export_output(output_sink_t *output, const export_options_t *options,
+                              const char *extension, char *file) {
+    file[0] = '\0';
+    if (export_writes_to_stdout(options)) {
+        // Writes go straight to the descriptor, past stdio's buffer
+        fflush(stdout);
+        return output_init_fd(output, STDOUT_FILENO);
+    }
     
-    // Create output filename
-    int result = snprintf(output_file, MAX_PATH_SIZE, "%s/ciary_export_%d-%02d-%02d_to_%d-%02d-%02d.html",
+    int result = snprintf(file, MAX_PATH_SIZE, "%s/ciary_export_%d-%02d-%02d_to_%d-%02d-%02d.%s",
              options->output_path,
              options->start_date.year, options->start_date.month, options->start_date.day,
-             options->end_date.year, options->end_date.month, options->end_date.day);
+             options->end_date.year, options->end_date.month, options->end_date.day, extension);
     
     if (result >= MAX_PATH_SIZE) {
+        file[0] = '\0';
         return 0; // Path too long
     }
     
-    output = fopen(output_file, "w");
-    if (!output) {
-        return 0;
+    return output_open(output, file);
+}
+
+// Everything up to and including the page's <h1>
+static void write_html_head(output_sink_t *output, const char *title) {
+    OUTPUT_LITERAL(output, "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"UTF-8\">\n");
+    output_printf(output, "<title>%s</title>\n", title);
+    OUTPUT_LITERAL(output, html_style);
+    OUTPUT_LITERAL(output, "</head>\n<body>\n");
+    output_printf(output, "<h1>%s</h1>\n", title);
+}
+
+static void write_html_footer(output_sink_t *output) {
+    OUTPUT_LITERAL(output, "<div class=\"footer\">\n"
+                   "<p>Exported from Ciary - A minimalistic TUI diary application</p>\n"
+                   "</div>\n"
+                   "</body>\n</html>\n");
+}
+
+// Render one day file as an entry-date block
+static void render_html_day(output_sink_t *output, const entry_file_t *entry) {
+    const char *path = entry->path;
+    mapped_file_t file;
+    if (!map_file(path, &file)) return;
+    
+    // Extract date from filename for section header
+    const char *filename = strrchr(path, '/');
+    if (filename) filename++;
+    else filename = path;
+    
+    OUTPUT_LITERAL(output, "<div class=\"entry-date\">\n<h2>");
+    output_puts(output, filename);
+    OUTPUT_LITERAL(output, "</h2>\n");
+    
+    // Walk the file header by header; the SIMD kernel skips over content,
+    // which one renderer turns into Markdown, closing its blocks at each
+    // header. Header lines inside fenced code stay code.
+    const char *data = file.data;
+    const char *end = data + file.length;
+    const char *p = data;
+    int in_time_section = 0;
+    int in_fence = 0;
+    markdown_renderer_t md;
+    markdown_init(&md, output);
+    while (p < end) {
+        int kind;
+        const char *header = find_next_unfenced_header(data, p, end, &kind, &in_fence);
+        markdown_feed(&md, p, header - p);
+        if (kind == HEADER_NONE) break;
+        markdown_finish(&md);
+        
+        const char *line_end = memchr(header, '\n', end - header);
+        if (!line_end) line_end = end;
+        
+        // Check for time headers (## HH:MM:SS)
+        if (kind == HEADER_SECTION) {
+            if (in_time_section) {
+                OUTPUT_LITERAL(output, "</div>\n");
+            }
+            OUTPUT_LITERAL(output, "<div class=\"entry-time\">\n<h3>");
+            write_html_escaped(output, header + 3, line_end - (header + 3));
+            OUTPUT_LITERAL(output, "</h3>\n");
+            in_time_section = 1;
+        }
+        // Date headers (# YYYY-MM-DD) are skipped as we already have them
+        
+        p = (line_end < end) ? line_end + 1 : end;
     }
+    markdown_finish(&md);
+    
+    if (in_time_section) {
+        OUTPUT_LITERAL(output, "</div>\n");
+    }
+    OUTPUT_LITERAL(output, "</div>\n");
+    
+    unmap_file(&file);
+}
+
+// Render a day through the fragment cache: unchanged days are copied from
+// the cached pack, anything else is rendered
+static void render_cached_html_day(output_sink_t *output, const entry_file_t *entry, int index,
+                                   void *context) {
+    if (!fragment_cache_fetch(context, index, entry, output)) {
+        render_html_day(output, entry);
+    }
+}
+
+// Hand each written day back to the cache; only re-rendered days are saved
+static void cache_html_day(const entry_file_t *entry, int index, const char *data, size_t length,
+                           void *context) {
+    fragment_cache_store(context, index, entry, data, length);
+}
+
+// Write the whole single-page HTML document for an export
+static int write_html_export(output_sink_t *output, const export_options_t *options,
+                             const config_t *config, const entry_list_t *entries,
+                             const char *progress_message) {
+    char title[256];
     
     // Generate title
     snprintf(title, sizeof(title), "Ciary Export: %d-%02d-%02d to %d-%02d-%02d",
              options->start_date.year, options->start_date.month, options->start_date.day,
              options->end_date.year, options->end_date.month, options->end_date.day);
     
-    // Write HTML header
-    fprintf(output, "<!DOCTYPE html>\n<html>\n<head>\n");
-    fprintf(output, "<meta charset=\"UTF-8\">\n");
-    fprintf(output, "<title>%s</title>\n", title);
-    fprintf(output, "<style>\n");
-    fprintf(output, "body { font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', Roboto, sans-serif; ");
-    fprintf(output, "max-width: 800px; margin: 40px auto; padding: 20px; line-height: 1.6; }\n");
-    fprintf(output, "h1 { color: #333; border-bottom: 3px solid #007acc; padding-bottom: 10px; }\n");
-    fprintf(output, "h2 { color: #555; margin-top: 30px; }\n");
-    fprintf(output, "h3 { color: #777; margin-top: 20px; }\n");
-    fprintf(output, ".entry-date { background: #f8f9fa; padding: 15px; border-left: 4px solid #007acc; margin: 20px 0; }\n");
-    fprintf(output, ".entry-time { background: #fff; border-left: 3px solid #ddd; padding: 10px; margin: 10px 0; }\n");
-    fprintf(output, "pre { background: #f8f9fa; padding: 10px; border-radius: 4px; overflow-x: auto; }\n");
-    fprintf(output, "code { background: #f1f1f1; padding: 2px 4px; border-radius: 3px; }\n");
-    fprintf(output, ".footer { margin-top: 40px; text-align: center; color: #666; font-size: 0.9em; }\n");
-    fprintf(output, "</style>\n");
-    fprintf(output, "</head>\n<body>\n");
-    fprintf(output, "<h1>%s</h1>\n", title);
-    fprintf(output, "<p>Generated by Ciary on %s</p>\n", __DATE__);
-    
-    // Process each entry file
-    for (int i = 0; i < file_count; i++) {
-        show_progress_bar("Exporting to HTML", i + 1, file_count);
-        
-        input = fopen(entry_files[i], "r");
-        if (!input) continue;
-        
-        // Extract date from filename for section header
-        char *filename = strrchr(entry_files[i], '/');
-        if (filename) filename++;
-        else filename = entry_files[i];
-        
-        fprintf(output, "<div class=\"entry-date\">\n");
-        fprintf(output, "<h2>%s</h2>\n", filename);
-        
-        // Process file content
-        int in_time_section = 0;
-        while (fgets(line, sizeof(line), input)) {
-            // Remove newline
-            size_t len = strlen(line);
-            if (len > 0 && line[len - 1] == '\n') {
-                line[len - 1] = '\0';
-            }
-            
-            // Check for time headers (## HH:MM:SS)
-            if (strncmp(line, "## ", 3) == 0) {
-                if (in_time_section) {
-                    fprintf(output, "</div>\n");
-                }
-                fprintf(output, "<div class=\"entry-time\">\n");
-                fprintf(output, "<h3>%s</h3>\n", line + 3);
-                in_time_section = 1;
-            }
-            // Check for date headers (# YYYY-MM-DD)
-            else if (strncmp(line, "# ", 2) == 0) {
-                // Skip date headers as we already have them
-                continue;
-            }
-            // Regular content
-            else if (strlen(line) > 0) {
-                // Simple markdown to HTML conversion
-                if (strncmp(line, "```", 3) == 0) {
-                    fprintf(output, "<pre><code>");
-                } else {
-                    // Escape HTML characters and convert basic markdown
-                    fprintf(output, "<p>");
-                    for (char *c = line; *c; c++) {
-                        switch (*c) {
-                            case '<': fprintf(output, "&lt;"); break;
-                            case '>': fprintf(output, "&gt;"); break;
-                            case '&': fprintf(output, "&amp;"); break;
-                            default: fputc(*c, output); break;
-                        }
-                    }
-                    fprintf(output, "</p>\n");
-                }
-            }
-        }
-        
-        if (in_time_section) {
-            fprintf(output, "</div>\n");
-        }
-        fprintf(output, "</div>\n");
-        
-        fclose(input);
-    }
+    write_html_head(output, title);
+    output_printf(output, "<p>Generated by Ciary on %s</p>\n", __DATE__);
+    
+    // Day files are rendered in parallel and written in order; days that
+    // haven't changed since the last export come from the fragment cache
+    fragment_cache_t cache;
+    fragment_cache_open(&cache, config, "html", HTML_RENDERER_VERSION, entries->count);
+    int ok = run_export_pipeline(entries, render_cached_html_day, cache_html_day, &cache, output,
+                                 progress_message);
+    fragment_cache_close(&cache, entries);
+    
+    write_html_footer(output);
+    return ok;
+}
+
+// Export entries to HTML format
+int export_to_html(const export_options_t *options, const config_t *config, 
+                  const entry_list_t *entries) {
+    char output_file[MAX_PATH_SIZE];
+    output_sink_t sink;
+    output_sink_t *output = &sink;
     
-    // Write HTML footer
-    fprintf(output, "<div class=\"footer\">\n");
-    fprintf(output, "<p>Exported from Ciary - A minimalistic TUI diary application</p>\n");
-    fprintf(output, "</div>\n");
-    fprintf(output, "</body>\n</html>\n");
+    if (!open_export_output(output, options, "html", output_file)) {
+        return 0;
+    }
     
-    fclose(output);
+    int ok = write_html_export(output, options, config, entries, "Exporting to HTML");
+    return output_close(output) && ok;
+}
+
+// A month of a sharded HTML export: entries first .. first + count - 1
+typedef struct {
+    int year;
+    int month;
+    int first;
+    int count;
+} site_month_t;
+
+typedef struct {
+    char directory[MAX_PATH_SIZE];
+    site_month_t *months;
+    int month_count;
+    int current;         // Month whose page is open, -1 before the first
+    output_sink_t page;
+    int page_open;
+    int ok;
+    fragment_cache_t cache;
+} html_site_t;
+
+// Group the (chronological) entries into months
+static int build_site_months(html_site_t *site, const entry_list_t *entries) {
+    site->months = malloc((entries->count > 0 ? entries->count : 1) * sizeof(site_month_t));
+    if (!site->months) return 0;
+    
+    for (int i = 0; i < entries->count; i++) {
+        date_t date = entries->items[i].date;
+        site_month_t *last = site->month_count ? &site->months[site->month_count - 1] : NULL;
+        if (last && last->year == date.year && last->month == date.month) {
+            last->count++;
+        } else {
+            site->months[site->month_count++] = (site_month_t){date.year, date.month, i, 1};
+        }
+    }
     return 1;
 }
 
-// libHaru dependency removed - PDF export now uses external tools only
+// Link to a neighbouring month page, or an empty placeholder so the nav
+// bar keeps its layout
+static void write_month_link(output_sink_t *output, const html_site_t *site, int month,
+                             const char *before, const char *after) {
+    if (month < 0 || month >= site->month_count) {
+        OUTPUT_LITERAL(output, "<span></span>\n");
+        return;
+    }
+    const site_month_t *m = &site->months[month];
+    output_printf(output, "<a href=\"%04d-%02d.html\">%s%s %d%s</a>\n", m->year, m->month,
+                  before, month_name(m->month), m->year, after);
+}
 
-// Export entries to PDF using external tools only
-int export_to_pdf(const export_options_t *options, const config_t *config, 
-                 char **entry_files, int file_count) {
-    // Use external PDF conversion tools
-    char html_file[MAX_PATH_SIZE];
-    char pdf_file[MAX_PATH_SIZE];
-    char command[MAX_PATH_SIZE * 3];  // Space for command + two file paths
-    int ext_result;
-    
-    // First create HTML file
-    if (!export_to_html(options, config, entry_files, file_count)) {
+static void write_month_nav(output_sink_t *output, const html_site_t *site) {
+    OUTPUT_LITERAL(output, "<div class=\"nav\">\n");
+    write_month_link(output, site, site->current - 1, "&larr; ", "");
+    OUTPUT_LITERAL(output, "<a href=\"index.html\">Index</a>\n");
+    write_month_link(output, site, site->current + 1, "", " &rarr;");
+    OUTPUT_LITERAL(output, "</div>\n");
+}
+
+static void open_month_page(html_site_t *site) {
+    const site_month_t *m = &site->months[site->current];
+    char path[MAX_PATH_SIZE];
+    char title[64];
+    
+    int result = snprintf(path, sizeof(path), "%s/%04d-%02d.html", site->directory, m->year, m->month);
+    if (result >= (int)sizeof(path) || !output_open(&site->page, path)) {
+        site->ok = 0;
+        return;
+    }
+    site->page_open = 1;
+    
+    snprintf(title, sizeof(title), "%s %d", month_name(m->month), m->year);
+    write_html_head(&site->page, title);
+    write_month_nav(&site->page, site);
+}
+
+static void close_month_page(html_site_t *site) {
+    if (!site->page_open) return;
+    write_month_nav(&site->page, site);
+    write_html_footer(&site->page);
+    if (!output_close(&site->page)) site->ok = 0;
+    site->page_open = 0;
+}
+
+// Months with entries, grouped by year
+static int write_site_index(const html_site_t *site, const export_options_t *options) {
+    char path[MAX_PATH_SIZE];
+    char title[256];
+    output_sink_t sink;
+    output_sink_t *output = &sink;
+    
+    int result = snprintf(path, sizeof(path), "%s/index.html", site->directory);
+    if (result >= (int)sizeof(path) || !output_open(output, path)) {
         return 0;
     }
     
-    // Generate filenames
-    int html_result = snprintf(html_file, MAX_PATH_SIZE, "%s/ciary_export_%d-%02d-%02d_to_%d-%02d-%02d.html",
-             options->output_path,
+    snprintf(title, sizeof(title), "Ciary Export: %d-%02d-%02d to %d-%02d-%02d",
              options->start_date.year, options->start_date.month, options->start_date.day,
              options->end_date.year, options->end_date.month, options->end_date.day);
+    write_html_head(output, title);
+    output_printf(output, "<p>Generated by Ciary on %s</p>\n", __DATE__);
+    
+    for (int i = 0; i < site->month_count; i++) {
+        const site_month_t *m = &site->months[i];
+        if (i == 0 || site->months[i - 1].year != m->year) {
+            if (i > 0) OUTPUT_LITERAL(output, "</ul>\n");
+            output_printf(output, "<h2>%d</h2>\n<ul>\n", m->year);
+        }
+        output_printf(output, "<li><a href=\"%04d-%02d.html\">%s</a> (%d %s)</li>\n",
+                      m->year, m->month, month_name(m->month), m->count,
+                      m->count == 1 ? "entry" : "entries");
+    }
+    if (site->month_count > 0) OUTPUT_LITERAL(output, "</ul>\n");
     
-    int pdf_result = snprintf(pdf_file, MAX_PATH_SIZE, "%s/ciary_export_%d-%02d-%02d_to_%d-%02d-%02d.pdf",
+    write_html_footer(output);
+    return output_close(output);
+}
+
+static void render_site_day(output_sink_t *output, const entry_file_t *entry, int index,
+                            void *context) {
+    html_site_t *site = context;
+    render_cached_html_day(output, entry, index, &site->cache);
+}
+
+// Route each written day to its month's page, switching pages as the
+// export crosses into a new month
+static void write_site_day(const entry_file_t *entry, int index, const char *data, size_t length,
+                           void *context) {
+    html_site_t *site = context;
+    
+    int month = (site->current < 0) ? 0 : site->current;
+    while (index >= site->months[month].first + site->months[month].count) {
+        month++;
+    }
+    if (month != site->current) {
+        close_month_page(site);
+        site->current = month;
+        open_month_page(site);
+    }
+    
+    if (site->page_open) output_write(&site->page, data, length);
+    cache_html_day(entry, index, data, length, &site->cache);
+}
+
+// Export entries as a directory of HTML pages: index.html plus one page
+// per month (YYYY-MM.html) with links to the neighbouring months. Pages
+// are written as the day files stream through the export pipeline, so
+// only one is open at a time.
+int export_to_html_site(const export_options_t *options, const config_t *config,
+                        const entry_list_t *entries) {
+    if (export_writes_to_stdout(options)) {
+        return 0;  // A directory of pages can't be streamed
+    }
+    
+    html_site_t site;
+    memset(&site, 0, sizeof(site));
+    site.current = -1;
+    site.ok = 1;
+    
+    int result = snprintf(site.directory, sizeof(site.directory),
+             "%s/ciary_export_%d-%02d-%02d_to_%d-%02d-%02d",
              options->output_path,
              options->start_date.year, options->start_date.month, options->start_date.day,
              options->end_date.year, options->end_date.month, options->end_date.day);
     
-    if (html_result >= MAX_PATH_SIZE || pdf_result >= MAX_PATH_SIZE) {
+    if (result >= (int)sizeof(site.directory)) {
         return 0; // Path too long
     }
     
-    // Try wkhtmltopdf first, then weasyprint as fallback
-    if (system("which wkhtmltopdf > /dev/null 2>&1") == 0) {
-        int cmd_result = snprintf(command, sizeof(command), "wkhtmltopdf '%s' '%s' 2>/dev/null", html_file, pdf_file);
-        if (cmd_result >= (int)sizeof(command)) {
-            return 0; // Command too long
-        }
-        show_progress_bar("Converting HTML to PDF (wkhtmltopdf)", 1, 1);
-    } else if (system("which weasyprint > /dev/null 2>&1") == 0) {
-        int cmd_result = snprintf(command, sizeof(command), "weasyprint '%s' '%s' 2>/dev/null", html_file, pdf_file);
-        if (cmd_result >= (int)sizeof(command)) {
-            return 0; // Command too long
-        }
-        show_progress_bar("Converting HTML to PDF (weasyprint)", 1, 1);
-    } else {
-        // No PDF converter available - keep HTML file as fallback
+    if (mkdir(site.directory, 0755) != 0 && errno != EEXIST) {
+        return 0;
+    }
+    
+    if (!build_site_months(&site, entries)) {
         return 0;
     }
     
-    ext_result = system(command);
+    int ok = write_site_index(&site, options);
     
-    // Clean up temporary HTML file only if PDF was created successfully
-    if (ext_result == 0) {
-        unlink(html_file);
+    // Month pages share the single-file export's fragment cache
+    fragment_cache_open(&site.cache, config, "html", HTML_RENDERER_VERSION, entries->count);
+    ok = run_export_pipeline(entries, render_site_day, write_site_day, &site, NULL,
+                             "Exporting to HTML site") && ok;
+    close_month_page(&site);
+    fragment_cache_close(&site.cache, entries);
+    
+    free(site.months);
+    return ok && site.ok;
+}
+
+// Lay out one day file: a heading for the day, one per time section, and
+// the text line by line. Fenced code is set in Courier; other Markdown
+// is printed as written.
+static void render_pdf_day(pdf_writer_t *pdf, const entry_file_t *entry) {
+    mapped_file_t file;
+    if (!map_file(entry->path, &file)) return;
+    
+    static const char *weekdays[] = {
+        "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"
+    };
+    int weekday = day_of_week(entry->date.year, entry->date.month, entry->date.day);
+    char heading[64];
+    int length = snprintf(heading, sizeof(heading), "%s %d %s %d", weekdays[weekday],
+                          entry->date.day, month_name(entry->date.month), entry->date.year);
+    pdf_text(pdf, PDF_STYLE_DAY, heading, (size_t)length);
+    
+    const char *p = file.data;
+    const char *end = p + file.length;
+    int in_code = 0;
+    while (p < end) {
+        const char *line_end = memchr(p, '\n', end - p);
+        if (!line_end) line_end = end;
+        size_t len = line_end - p;
+        if (len > 0 && p[len - 1] == '\r') len--;
+        
+        if (len >= 3 && strncmp(p, "```", 3) == 0) {
+            in_code = !in_code;
+        } else if (in_code) {
+            pdf_text(pdf, PDF_STYLE_CODE, p, len);
+        } else if (len >= 3 && strncmp(p, "## ", 3) == 0) {
+            pdf_text(pdf, PDF_STYLE_TIME, p + 3, len - 3);
+        } else if (len >= 2 && strncmp(p, "# ", 2) == 0) {
+            // Date header; the day heading above already shows it
+        } else if (len > 0 && p[0] == '#') {
+            size_t level = 0;
+            while (level < len && p[level] == '#') level++;
+            if (level < len && p[level] == ' ') {
+                pdf_text(pdf, PDF_STYLE_HEADING, p + level + 1, len - level - 1);
+            } else {
+                pdf_text(pdf, PDF_STYLE_BODY, p, len);  // #hashtag
+            }
+        } else {
+            size_t indent = 0;
+            while (indent < len && (p[indent] == ' ' || p[indent] == '\t')) indent++;
+            if (indent == len) {
+                pdf_space(pdf);
+            } else {
+                pdf_text(pdf, PDF_STYLE_BODY, p, len);
+            }
+        }
+        
+        p = line_end + 1;
     }
+    pdf_space(pdf);
     
-    return (ext_result == 0);
+    unmap_file(&file);
 }
 
-// Export entries to Markdown format
-int export_to_markdown(const export_options_t *options, const config_t *config, 
-                      char **entry_files, int file_count) {
+// Export entries to PDF with the built-in writer. Pages are written as
+// they fill, so memory use doesn't grow with the size of the journal.
+int export_to_pdf(const export_options_t *options, const config_t *config, 
+                 const entry_list_t *entries) {
     (void)config;  // Suppress unused parameter warning
     char output_file[MAX_PATH_SIZE];
-    FILE *output;
-    FILE *input;
-    char line[MAX_LINE_SIZE];
+    char title[256];
+    char generated[64];
+    output_sink_t sink;
+    output_sink_t *output = &sink;
+    pdf_writer_t pdf;
     
-    // Create output filename
-    int result = snprintf(output_file, MAX_PATH_SIZE, "%s/ciary_export_%d-%02d-%02d_to_%d-%02d-%02d.md",
-             options->output_path,
+    if (!open_export_output(output, options, "pdf", output_file)) {
+        return 0;
+    }
+    
+    if (!pdf_open(&pdf, output)) {
+        output_close(output);
+        if (output_file[0]) unlink(output_file);
+        return 0;
+    }
+    
+    snprintf(title, sizeof(title), "Ciary Export: %d-%02d-%02d to %d-%02d-%02d",
              options->start_date.year, options->start_date.month, options->start_date.day,
              options->end_date.year, options->end_date.month, options->end_date.day);
+    pdf_text(&pdf, PDF_STYLE_TITLE, title, strlen(title));
+    int length = snprintf(generated, sizeof(generated), "Generated by Ciary on %s", __DATE__);
+    pdf_text(&pdf, PDF_STYLE_NOTE, generated, (size_t)length);
     
-    if (result >= MAX_PATH_SIZE) {
-        return 0; // Path too long
+    for (int i = 0; i < entries->count; i++) {
+        show_progress_bar("Exporting to PDF", i + 1, entries->count);
+        render_pdf_day(&pdf, &entries->items[i]);
     }
     
-    output = fopen(output_file, "w");
-    if (!output) {
+    int ok = pdf_close(&pdf, title);
+    ok = output_close(output) && ok;
+    if (!ok && output_file[0]) {
+        unlink(output_file);
+    }
+    return ok;
+}
+
+// Export entries to Markdown format
+int export_to_markdown(const export_options_t *options, const config_t *config, 
+                      const entry_list_t *entries) {
+    (void)config;  // Suppress unused parameter warning
+    char output_file[MAX_PATH_SIZE];
+    output_sink_t sink;
+    output_sink_t *output = &sink;
+    
+    if (!open_export_output(output, options, "md", output_file)) {
         return 0;
     }
     
     // Write header
-    fprintf(output, "# Ciary Export: %d-%02d-%02d to %d-%02d-%02d\n\n",
+    output_printf(output, "# Ciary Export: %d-%02d-%02d to %d-%02d-%02d\n\n",
              options->start_date.year, options->start_date.month, options->start_date.day,
              options->end_date.year, options->end_date.month, options->end_date.day);
-    fprintf(output, "Generated by Ciary on %s\n\n", __DATE__);
-    fprintf(output, "---\n\n");
+    output_printf(output, "Generated by Ciary on %s\n\n", __DATE__);
+    OUTPUT_LITERAL(output, "---\n\n");
+    
+    // Day files are already Markdown, so they are spliced into the output
+    // by the kernel; only the separators are written from here
+    int ok = 1;
+    for (int i = 0; i < entries->count; i++) {
+        show_progress_bar("Exporting to Markdown", i + 1, entries->count);
+        
+        if (!output_splice_file(output, entries->items[i].path)) {
+            if (output->failed) {
+                ok = 0;
+                break;
+            }
+            continue;
+        }
+        OUTPUT_LITERAL(output, "\n---\n\n");  // Separator between days
+    }
+    
+    OUTPUT_LITERAL(output, "\n*Exported from Ciary - A minimalistic TUI diary application*\n");
     
-    // Process each entry file
-    for (int i = 0; i < file_count; i++) {
-        show_progress_bar("Exporting to Markdown", i + 1, file_count);
+    return output_close(output) && ok;
+}
+
+// Narrow [*start, *stop) to drop blank lines at either end
+static void trim_blank_lines(const char **start, const char **stop) {
+    const char *p = *start;
+    const char *line = p;
+    while (p < *stop && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+        if (*p++ == '\n') line = p;
+    }
+    *start = (p == *stop) ? *stop : line;
+    
+    p = *stop;
+    while (p > *start && (p[-1] == ' ' || p[-1] == '\t' || p[-1] == '\r' || p[-1] == '\n')) {
+        p--;
+    }
+    *stop = p;
+}
+
+// Write one NDJSON record. A NULL time is text outside any time section,
+// which is only written if it isn't blank.
+static void write_ndjson_record(output_sink_t *output, const char *date, const char *time,
+                                size_t time_length, const char *text, const char *text_end) {
+    trim_blank_lines(&text, &text_end);
+    if (!time && text == text_end) return;
+    
+    OUTPUT_LITERAL(output, "{\"date\":\"");
+    output_puts(output, date);
+    if (time) {
+        OUTPUT_LITERAL(output, "\",\"time\":\"");
+        write_json_escaped(output, time, time_length);
+        OUTPUT_LITERAL(output, "\",\"text\":\"");
+    } else {
+        OUTPUT_LITERAL(output, "\",\"time\":null,\"text\":\"");
+    }
+    write_json_escaped(output, text, text_end - text);
+    OUTPUT_LITERAL(output, "\"}\n");
+}
+
+// Write a day file as one record per time section, straight from the
+// mapped file
+static int write_ndjson_day(output_sink_t *output, const entry_file_t *entry) {
+    mapped_file_t file;
+    if (!map_file(entry->path, &file)) return 0;
+    
+    char date[16];
+    snprintf(date, sizeof(date), "%04d-%02d-%02d", entry->date.year, entry->date.month, entry->date.day);
+    
+    const char *data = file.data;
+    const char *end = data + file.length;
+    const char *p = data;
+    const char *time = NULL;
+    size_t time_length = 0;
+    int in_fence = 0;
+    while (1) {
+        int kind;
+        const char *header = find_next_unfenced_header(data, p, end, &kind, &in_fence);
+        write_ndjson_record(output, date, time, time_length, p, header);
+        if (kind == HEADER_NONE) break;
         
-        input = fopen(entry_files[i], "r");
-        if (!input) continue;
+        const char *line_end = memchr(header, '\n', end - header);
+        if (!line_end) line_end = end;
         
-        // Copy file content directly (it's already in Markdown format)
-        while (fgets(line, sizeof(line), input)) {
-            fputs(line, output);
+        // Text after a date header belongs to no time section
+        time = NULL;
+        if (kind == HEADER_SECTION) {
+            time = header + 3;
+            const char *time_end = line_end;
+            trim_blank_lines(&time, &time_end);
+            time_length = time_end - time;
         }
         
-        fprintf(output, "\n---\n\n");  // Separator between days
-        fclose(input);
+        p = (line_end < end) ? line_end + 1 : end;
     }
     
-    fprintf(output, "\n*Exported from Ciary - A minimalistic TUI diary application*\n");
-    
-    fclose(output);
+    unmap_file(&file);
     return 1;
 }
 
-// Main export function
-int export_entries(const export_options_t *options, const config_t *config) {
-    char **entry_files;
-    int file_count;
-    int result = 0;
+// Export every time section as a JSON object on its own line. Records are
+// escaped straight from the mapped day files into the sink's buffer, so
+// nothing is allocated per entry and memory use stays flat.
+int export_to_ndjson(const export_options_t *options, const config_t *config,
+                     const entry_list_t *entries) {
+    (void)config;  // Suppress unused parameter warning
+    char output_file[MAX_PATH_SIZE];
+    output_sink_t sink;
+    output_sink_t *output = &sink;
     
-    // Collect entry files in range
-    if (!collect_entries_in_range(options, config, &entry_files, &file_count)) {
-        mvprintw(LINES - 2, 2, "Failed to collect entry files.");
-        refresh();
-        getch();
+    if (!open_export_output(output, options, "ndjson", output_file)) {
         return 0;
     }
     
-    if (file_count == 0) {
-        mvprintw(LINES - 2, 2, "No entries found in the specified date range.");
-        refresh();
-        getch();
-        
-        // Free memory
-        free(entry_files);
-        return 0;
+    // A day that can't be read fails the export rather than leaving a
+    // silent gap in the feed
+    int ok = 1;
+    for (int i = 0; i < entries->count; i++) {
+        show_progress_bar("Exporting to NDJSON", i + 1, entries->count);
+        if (!write_ndjson_day(output, &entries->items[i])) {
+            ok = 0;
+            break;
+        }
+        if (output->failed) break;
+    }
+    
+    return output_close(output) && ok;
+}
+
+// Collect the entries in range and export them in the chosen format. No
+// terminal interaction happens here beyond the progress bar (which is a
+// no-op without curses), so this serves the UI and the command line
+// alike. count is set to the number of day files found.
+export_status_t run_export(const export_options_t *options, const config_t *config, int *count) {
+    entry_list_t entries;
+    int result = 0;
+    
+    *count = 0;
+    if (!collect_entries_in_range(options, config, &entries)) {
+        return EXPORT_COLLECT_FAILED;
+    }
+    
+    *count = entries.count;
+    if (entries.count == 0) {
+        free_entry_list(&entries);
+        return EXPORT_NO_ENTRIES;
     }
     
     // Export based on format
     switch (options->format) {
         case EXPORT_FORMAT_HTML:
-            result = export_to_html(options, config, entry_files, file_count);
+            result = export_to_html(options, config, &entries);
             break;
         case EXPORT_FORMAT_PDF:
-            result = export_to_pdf(options, config, entry_files, file_count);
+            result = export_to_pdf(options, config, &entries);
             break;
         case EXPORT_FORMAT_MARKDOWN:
-            result = export_to_markdown(options, config, entry_files, file_count);
+            result = export_to_markdown(options, config, &entries);
+            break;
+        case EXPORT_FORMAT_HTML_SITE:
+            result = export_to_html_site(options, config, &entries);
+            break;
+        case EXPORT_FORMAT_NDJSON:
+            result = export_to_ndjson(options, config, &entries);
             break;
     }
     
-    // Clean up
-    for (int i = 0; i < file_count; i++) {
-        free(entry_files[i]);
+    free_entry_list(&entries);
+    return result ? EXPORT_OK : EXPORT_FAILED;
+}
+
+// Export from the UI and report the outcome on the status line
+int export_entries(const export_options_t *options, const config_t *config) {
+    // stdout is the curses screen here
+    if (export_writes_to_stdout(options)) {
+        mvprintw(LINES - 2, 2, "Exporting to stdout (-) is only available from the command line.");
+        refresh();
+        getch();
+        return 0;
     }
-    free(entry_files);
     
-    // Show result
-    if (result) {
-        const char *format_str = (options->format == EXPORT_FORMAT_HTML) ? "HTML" :
-                                (options->format == EXPORT_FORMAT_PDF) ? "PDF" : "Markdown";
-        mvprintw(LINES - 2, 2, "Successfully exported %d entries to %s format.", file_count, format_str);
-    } else {
-        mvprintw(LINES - 2, 2, "Export failed. Check permissions and dependencies.");
+    int file_count = 0;
+    export_status_t status = run_export(options, config, &file_count);
+    
+    switch (status) {
+        case EXPORT_OK:
+            mvprintw(LINES - 2, 2, "Successfully exported %d entries to %s format.", file_count,
+                     export_format_name(options->format));
+            break;
+        case EXPORT_NO_ENTRIES:
+            mvprintw(LINES - 2, 2, "No entries found in the specified date range.");
+            break;
+        case EXPORT_COLLECT_FAILED:
+            mvprintw(LINES - 2, 2, "Failed to collect entry files.");
+            break;
+        case EXPORT_FAILED:
+            mvprintw(LINES - 2, 2, "Export failed. Check permissions and dependencies.");
+            break;
     }
     
     refresh();
     getch();
-    return result;
-}
\ No newline at end of file
+    return status == EXPORT_OK;
+}
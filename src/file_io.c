@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include "ciary.h"
 #include <dirent.h>
 #include <stdlib.h>
@@ -58,21 +59,155 @@ int count_entries(date_t date, const config_t *config) {
     char path[MAX_PATH_SIZE];
     if (!get_entry_path(date, path, config)) return 0;
     
-    FILE *file = fopen(path, "r");
-    if (!file) return 0;
+    mapped_file_t file;
+    if (!map_file(path, &file)) return 0;
     
-    int count = 0;
-    char line[MAX_LINE_SIZE];
+    // Count lines that start with "## " (time headers)
+    int count = count_sections(file.data, file.length);
     
-    while (fgets(line, sizeof(line), file)) {
-        // Count lines that start with "## " (time headers)
-        if (strncmp(line, "## ", 3) == 0) {
-            count++;
+    unmap_file(&file);
+    return count;
+}
+
+void month_cache_invalidate(month_cache_t *cache) {
+    memset(cache, 0, sizeof(*cache));
+}
+
+// Fill the cache for a month from the journal index.
+// Does nothing if that month is already cached.
+int month_cache_load(month_cache_t *cache, int year, int month, const journal_index_t *index) {
+    if (cache->valid && cache->year == year && cache->month == month) {
+        return 0;
+    }
+    
+    month_cache_invalidate(cache);
+    cache->year = year;
+    cache->month = month;
+    
+    // Entries are sorted, so the month is one contiguous run
+    date_t first = {year, month, 1};
+    for (int i = journal_index_lower_bound(index, first); i < index->count; i++) {
+        const index_entry_t *entry = &index->entries[i];
+        if (entry->date.year != year || entry->date.month != month) break;
+        if (entry->date.day >= 1 && entry->date.day <= 31) {
+            cache->counts[entry->date.day - 1] = entry->section_count;
         }
     }
     
-    fclose(file);
-    return count;
+    cache->valid = 1;
+    return 0;
+}
+
+// Returns the cached entry count, or -1 if the date isn't in the cached month
+int month_cache_get(const month_cache_t *cache, date_t date) {
+    if (!cache->valid || cache->year != date.year || cache->month != date.month ||
+        date.day < 1 || date.day > 31) {
+        return -1;
+    }
+    return cache->counts[date.day - 1];
+}
+
+// Editors and pagers resolved once per session. Lookups search $PATH
+// in-process, so nothing here forks a shell.
+typedef struct {
+    char preference[MAX_NAME_SIZE];
+    char name[MAX_NAME_SIZE];
+    char path[MAX_PATH_SIZE];
+    int resolved;
+} resolved_program_t;
+
+static const char *editor_candidates[] = {"nvim", "vim", "nano", "emacs", "vi", NULL};
+static const char *viewer_candidates[] = {"less", "more", "cat", NULL};
+
+static resolved_program_t resolved_editor;
+static resolved_program_t resolved_viewer;
+
+// Look up an executable the same way the shell would. Names containing a
+// slash are checked as-is. Returns 1 and fills path if found.
+int find_in_path(const char *name, char *path, size_t size) {
+    struct stat st;
+    
+    if (!name || name[0] == '\0') return 0;
+    
+    if (strchr(name, '/')) {
+        if (access(name, X_OK) == 0 && stat(name, &st) == 0 && S_ISREG(st.st_mode)) {
+            snprintf(path, size, "%s", name);
+            return 1;
+        }
+        return 0;
+    }
+    
+    const char *search = getenv("PATH");
+    if (!search || search[0] == '\0') {
+        search = "/usr/bin:/bin";
+    }
+    
+    char candidate[MAX_PATH_SIZE];
+    const char *dir = search;
+    while (1) {
+        const char *sep = strchr(dir, ':');
+        int len = sep ? (int)(sep - dir) : (int)strlen(dir);
+        
+        // An empty element means the current directory
+        int result = snprintf(candidate, sizeof(candidate), "%.*s/%s",
+                              len > 0 ? len : 1, len > 0 ? dir : ".", name);
+        if (result > 0 && result < (int)sizeof(candidate) &&
+            access(candidate, X_OK) == 0 && stat(candidate, &st) == 0 && S_ISREG(st.st_mode)) {
+            snprintf(path, size, "%s", candidate);
+            return 1;
+        }
+        
+        if (!sep) break;
+        dir = sep + 1;
+    }
+    
+    return 0;
+}
+
+// Resolve a preference ("auto" or a program name) against a candidate list.
+// Only re-runs the lookup when the preference string changes.
+static const resolved_program_t* resolve_program(resolved_program_t *prog, const char *preference,
+                                                 const char **candidates) {
+    if (prog->resolved && strcmp(prog->preference, preference) == 0) {
+        return prog;
+    }
+    
+    snprintf(prog->preference, sizeof(prog->preference), "%s", preference);
+    prog->name[0] = '\0';
+    prog->path[0] = '\0';
+    
+    // If user has a specific preference, try that first
+    if (strcmp(preference, "auto") != 0 && find_in_path(preference, prog->path, sizeof(prog->path))) {
+        snprintf(prog->name, sizeof(prog->name), "%s", preference);
+    } else {
+        // Fall back to auto-detection
+        for (int i = 0; candidates[i] != NULL; i++) {
+            if (find_in_path(candidates[i], prog->path, sizeof(prog->path))) {
+                snprintf(prog->name, sizeof(prog->name), "%s", candidates[i]);
+                break;
+            }
+        }
+    }
+    
+    prog->resolved = 1;
+    return prog;
+}
+
+void resolve_programs(const config_t *config) {
+    resolve_program(&resolved_editor, config->editor_preference, editor_candidates);
+    resolve_program(&resolved_viewer, config->viewer_preference, viewer_candidates);
+}
+
+// Launch the resolved editor on a day file and restore curses afterwards
+static int launch_editor(const char *path, const config_t *config) {
+    const resolved_program_t *editor = resolve_program(&resolved_editor, config->editor_preference,
+                                                       editor_candidates);
+    if (editor->path[0] == '\0') {
+        return -1; // No suitable editor found
+    }
+    
+    char *argv[] = {(char *)editor->path, (char *)path, NULL};
+    return (spawn_in_terminal(argv, 0) == 0) ? 0 : -1;
 }
 
 int open_entry_in_editor(date_t date, const config_t *config) {
@@ -104,59 +239,7 @@ int open_entry_in_editor(date_t date, const config_t *config) {
     fprintf(file, "## %02d:%02d:%02d\n\n", tm->tm_hour, tm->tm_min, tm->tm_sec);
     fclose(file);
     
-    // Try different editors in order of preference
-    char command[MAX_PATH_SIZE + 256];  // Space for path + editor name + arguments
-    const char *editors[] = {"nvim", "vim", "nano", "emacs", "vi", NULL};
-    
-    // If user has a specific preference, try that first
-    if (strcmp(config->editor_preference, "auto") != 0) {
-        snprintf(command, sizeof(command), "which %s >/dev/null 2>&1", config->editor_preference);
-        if (system(command) == 0) {
-            int cmd_result = snprintf(command, sizeof(command), "%s \"%s\"", config->editor_preference, path);
-            if (cmd_result >= (int)sizeof(command)) {
-                return 1; // Command too long
-            }
-            
-            endwin();
-            int result = system(command);
-            
-            initscr();
-            cbreak();
-            noecho();
-            keypad(stdscr, TRUE);
-            curs_set(1);
-            
-            return (result == 0) ? 0 : -1;
-        }
-    }
-    
-    // Fall back to auto-detection
-    for (int i = 0; editors[i] != NULL; i++) {
-        // Check if editor exists
-        snprintf(command, sizeof(command), "which %s >/dev/null 2>&1", editors[i]);
-        if (system(command) == 0) {
-            // Editor found, use it
-            int cmd_result = snprintf(command, sizeof(command), "%s \"%s\"", editors[i], path);
-            if (cmd_result >= (int)sizeof(command)) {
-                continue; // Skip this editor if command too long
-            }
-            
-            // Temporarily restore terminal settings
-            endwin();
-            int result = system(command);
-            
-            // Reinitialize ncurses
-            initscr();
-            cbreak();
-            noecho();
-            keypad(stdscr, TRUE);
-            curs_set(1);
-            
-            return (result == 0) ? 0 : -1;
-        }
-    }
-    
-    return -1; // No suitable editor found
+    return launch_editor(path, config);
 }
 
 int open_entry_with_time(date_t date, int hour, int minute, int second, const config_t *config) {
@@ -185,59 +268,7 @@ int open_entry_with_time(date_t date, int hour, int minute, int second, const co
     fprintf(file, "## %02d:%02d:%02d\n\n", hour, minute, second);
     fclose(file);
     
-    // Try different editors in order of preference
-    char command[MAX_PATH_SIZE + 256];  // Space for path + editor name + arguments
-    const char *editors[] = {"nvim", "vim", "nano", "emacs", "vi", NULL};
-    
-    // If user has a specific preference, try that first
-    if (strcmp(config->editor_preference, "auto") != 0) {
-        snprintf(command, sizeof(command), "which %s >/dev/null 2>&1", config->editor_preference);
-        if (system(command) == 0) {
-            int cmd_result = snprintf(command, sizeof(command), "%s \"%s\"", config->editor_preference, path);
-            if (cmd_result >= (int)sizeof(command)) {
-                return 1; // Command too long
-            }
-            
-            endwin();
-            int result = system(command);
-            
-            initscr();
-            cbreak();
-            noecho();
-            keypad(stdscr, TRUE);
-            curs_set(1);
-            
-            return (result == 0) ? 0 : -1;
-        }
-    }
-    
-    // Fall back to auto-detection
-    for (int i = 0; editors[i] != NULL; i++) {
-        // Check if editor exists
-        snprintf(command, sizeof(command), "which %s >/dev/null 2>&1", editors[i]);
-        if (system(command) == 0) {
-            // Editor found, use it
-            int cmd_result = snprintf(command, sizeof(command), "%s \"%s\"", editors[i], path);
-            if (cmd_result >= (int)sizeof(command)) {
-                continue; // Skip this editor if command too long
-            }
-            
-            // Temporarily restore terminal settings
-            endwin();
-            int result = system(command);
-            
-            // Reinitialize ncurses
-            initscr();
-            cbreak();
-            noecho();
-            keypad(stdscr, TRUE);
-            curs_set(1);
-            
-            return (result == 0) ? 0 : -1;
-        }
-    }
-    
-    return -1; // No suitable editor found
+    return launch_editor(path, config);
 }
 
 int view_entry(date_t date, const config_t *config) {
@@ -261,92 +292,32 @@ int view_entry(date_t date, const config_t *config) {
         return 0;
     }
     
-    // Try different pagers in order of preference
-    char command[MAX_PATH_SIZE + 256];  // Space for path + pager name + arguments
-    const char *pagers[] = {"less", "more", "cat", NULL};
-    
-    // If user has a specific preference, try that first
-    if (strcmp(config->viewer_preference, "auto") != 0) {
-        snprintf(command, sizeof(command), "which %s >/dev/null 2>&1", config->viewer_preference);
-        if (system(command) == 0) {
-            int cmd_result;
-            if (strcmp(config->viewer_preference, "cat") == 0) {
-                cmd_result = snprintf(command, sizeof(command), "%s \"%s\" && echo \"\\nPress Enter to continue...\" && read", config->viewer_preference, path);
-            } else {
-                cmd_result = snprintf(command, sizeof(command), "%s \"%s\"", config->viewer_preference, path);
-            }
-            if (cmd_result >= (int)sizeof(command)) {
-                return 1; // Command too long
-            }
-            
-            endwin();
-            int result = system(command);
-            
-            initscr();
-            cbreak();
-            noecho();
-            keypad(stdscr, TRUE);
-            curs_set(1);
-            
-            return (result == 0) ? 0 : -1;
-        }
-    }
-    
-    // Fall back to auto-detection
-    for (int i = 0; pagers[i] != NULL; i++) {
-        // Check if pager exists
-        snprintf(command, sizeof(command), "which %s >/dev/null 2>&1", pagers[i]);
-        if (system(command) == 0) {
-            // Pager found, use it
-            int cmd_result;
-            if (strcmp(pagers[i], "cat") == 0) {
-                // For cat, add a pause after display
-                cmd_result = snprintf(command, sizeof(command), "%s \"%s\" && echo \"\\nPress Enter to continue...\" && read", pagers[i], path);
-            } else {
-                // For less/more, they handle their own paging
-                cmd_result = snprintf(command, sizeof(command), "%s \"%s\"", pagers[i], path);
-            }
-            if (cmd_result >= (int)sizeof(command)) {
-                continue; // Skip this pager if command too long
-            }
-            
-            // Temporarily restore terminal settings
-            endwin();
-            int result = system(command);
-            
-            // Reinitialize ncurses
-            initscr();
-            cbreak();
-            noecho();
-            keypad(stdscr, TRUE);
-            curs_set(1);
-            
-            return (result == 0) ? 0 : -1;
-        }
+    const resolved_program_t *viewer = resolve_program(&resolved_viewer, config->viewer_preference,
+                                                       viewer_candidates);
+    if (viewer->path[0] == '\0') {
+        return -1; // No suitable pager found
     }
     
-    return -1; // No suitable pager found
+    // cat doesn't page, so pause after it; less/more handle their own paging
+    char *argv[] = {(char *)viewer->path, path, NULL};
+    int flags = (strcmp(viewer->name, "cat") == 0) ? SPAWN_PAUSE : 0;
+    return (spawn_in_terminal(argv, flags) == 0) ? 0 : -1;
 }
 
 const char* get_actual_editor(const config_t *config) {
-    char command[MAX_LINE_SIZE];
-    static const char *editors[] = {"nvim", "vim", "nano", "emacs", "vi", NULL};
-    
-    // Check if a specific editor is configured and available
-    if (strcmp(config->editor_preference, "auto") != 0) {
-        snprintf(command, sizeof(command), "which %s >/dev/null 2>&1", config->editor_preference);
-        if (system(command) == 0) {
-            return config->editor_preference;
-        }
+    const resolved_program_t *editor = resolve_program(&resolved_editor, config->editor_preference,
+                                                       editor_candidates);
+    if (editor->name[0] == '\0') {
+        return "vi"; // Default fallback
     }
-    
-    // Fall back to auto-detection
-    for (int i = 0; editors[i] != NULL; i++) {
-        snprintf(command, sizeof(command), "which %s >/dev/null 2>&1", editors[i]);
-        if (system(command) == 0) {
-            return editors[i];
-        }
+    return editor->name;
+}
+
+const char* get_actual_viewer(const config_t *config) {
+    const resolved_program_t *viewer = resolve_program(&resolved_viewer, config->viewer_preference,
+                                                       viewer_candidates);
+    if (viewer->name[0] == '\0') {
+        return "cat"; // Default fallback
     }
-    
-    return "vi"; // Default fallback
-}
\ No newline at end of file
+    return viewer->name;
+}
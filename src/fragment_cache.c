@@ -0,0 +1,290 @@
+#define _GNU_SOURCE
+#include "ciary.h"
+#include <fcntl.h>
+#include <stdint.h>
+
+// Rendered export fragments for one renderer, packed into a single file
+// (EXPORT_CACHE_DIR/<kind> in the journal directory) so a repeat export
+// maps one file instead of opening one per day. Host byte order; a
+// foreign or corrupt pack is ignored and rebuilt:
+//   header:  fragment_pack_header_t
+//   data:    for each fragment, the source path then the fragment bytes
+//   records: count fragment_record_t, sorted by date
+// A fragment is reused only if the source path, mtime and size and the
+// renderer version all still match.
+#define FRAGMENT_MAGIC "CFRG"
+
+typedef struct {
+    char magic[4];
+    uint32_t version;         // Renderer version that produced the pack
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t records_offset;
+} fragment_pack_header_t;
+
+struct fragment_record {
+    int64_t mtime;
+    int64_t size;
+    uint64_t offset;       // Of the path; the fragment follows it
+    uint32_t path_length;
+    uint32_t length;       // Fragment bytes
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint32_t reserved;
+};
+
+// What one export learned about each of its entries
+struct fragment_slot {
+    int64_t mtime;
+    int64_t size;
+    int state;           // SLOT_*
+    int old_record;      // Record in the old pack for SLOT_HIT
+    uint64_t offset;     // Of the path in the new pack for SLOT_FRESH
+    uint32_t length;
+};
+
+#define SLOT_MISSING 0  // Source couldn't be read; nothing to cache
+#define SLOT_HIT 1      // Served from the old pack
+#define SLOT_STALE 2    // Rendered, waiting for fragment_cache_store
+#define SLOT_FRESH 3    // Rendered and appended to the new pack
+
+static int load_pack(fragment_cache_t *cache) {
+    if (!map_file(cache->path, &cache->pack)) return 0;
+
+    fragment_pack_header_t header;
+    if (cache->pack.length < sizeof(header)) return 0;
+    memcpy(&header, cache->pack.data, sizeof(header));
+
+    uint64_t records_size = (uint64_t)header.count * sizeof(struct fragment_record);
+    if (memcmp(header.magic, FRAGMENT_MAGIC, 4) != 0 || header.version != cache->version ||
+        header.records_offset > cache->pack.length ||
+        records_size > cache->pack.length - header.records_offset ||
+        header.records_offset % sizeof(uint64_t) != 0) {
+        return 0;
+    }
+
+    const struct fragment_record *records =
+        (const struct fragment_record *)(cache->pack.data + header.records_offset);
+    for (uint32_t i = 0; i < header.count; i++) {
+        if (records[i].offset > header.records_offset ||
+            (uint64_t)records[i].path_length + records[i].length > header.records_offset - records[i].offset) {
+            return 0;
+        }
+    }
+
+    cache->records = records;
+    cache->record_count = (int)header.count;
+    return 1;
+}
+
+// Open the cache for one renderer (e.g. "html") ahead of exporting count
+// entries. If the cache directory can't be used, the cache stays disabled
+// and every day is simply rendered.
+int fragment_cache_open(fragment_cache_t *cache, const config_t *config, const char *kind,
+                        uint32_t version, int count) {
+    memset(cache, 0, sizeof(*cache));
+    cache->version = version;
+
+    char root[MAX_PATH_SIZE];
+    int result = snprintf(root, sizeof(root), "%s/%s", config->journal_directory, EXPORT_CACHE_DIR);
+    if (result >= (int)sizeof(root)) return 0;
+    result = snprintf(cache->path, sizeof(cache->path), "%s/%s", root, kind);
+    if (result >= (int)sizeof(cache->path)) return 0;
+    if (mkdir(root, 0755) != 0 && errno != EEXIST) return 0;
+
+    cache->slots = calloc(count > 0 ? count : 1, sizeof(struct fragment_slot));
+    if (!cache->slots) return 0;
+    cache->slot_count = count;
+
+    if (!load_pack(cache)) {
+        unmap_file(&cache->pack);
+        cache->records = NULL;
+        cache->record_count = 0;
+    }
+
+    cache->enabled = 1;
+    return 1;
+}
+
+#define TEMP_PATH_SIZE (MAX_PATH_SIZE + 8)
+
+static void get_temp_path(const fragment_cache_t *cache, char *temp_path) {
+    snprintf(temp_path, TEMP_PATH_SIZE, "%s.tmp", cache->path);
+}
+
+static int date_key(int year, int month, int day) {
+    return (year * 13 + month) * 32 + day;
+}
+
+static int find_record(const fragment_cache_t *cache, date_t date) {
+    int key = date_key(date.year, date.month, date.day);
+    int low = 0, high = cache->record_count - 1;
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        const struct fragment_record *record = &cache->records[mid];
+        int mid_key = date_key(record->year, record->month, record->day);
+        if (mid_key == key) return mid;
+        if (mid_key < key) low = mid + 1;
+        else high = mid - 1;
+    }
+    return -1;
+}
+
+// Worker side: look up entry (number index of the export) and append its
+// cached fragment to output if the source is unchanged. Returns 1 on a
+// hit; on a miss the caller renders the day and the writer later passes
+// the result to fragment_cache_store. Safe to call from several threads
+// for different indexes.
+int fragment_cache_fetch(fragment_cache_t *cache, int index, const entry_file_t *entry,
+                         output_sink_t *output) {
+    if (!cache->enabled || index < 0 || index >= cache->slot_count) return 0;
+    struct fragment_slot *slot = &cache->slots[index];
+
+    struct stat st;
+    if (stat(entry->path, &st) != 0) {
+        slot->state = SLOT_MISSING;
+        return 0;
+    }
+    slot->mtime = (int64_t)st.st_mtime;
+    slot->size = (int64_t)st.st_size;
+    slot->state = SLOT_STALE;
+
+    int found = find_record(cache, entry->date);
+    if (found < 0) return 0;
+
+    const struct fragment_record *record = &cache->records[found];
+    const char *path = cache->pack.data + record->offset;
+    size_t path_length = strlen(entry->path);
+    if (record->mtime != slot->mtime || record->size != slot->size ||
+        record->path_length != path_length || memcmp(path, entry->path, path_length) != 0) {
+        return 0;
+    }
+
+    output_write(output, path + path_length, record->length);
+    slot->state = SLOT_HIT;
+    slot->old_record = found;
+    return 1;
+}
+
+// Writer side: record the fragment the export just wrote for entry. Only
+// freshly rendered days are written; they go to a new pack that replaces
+// the old one in fragment_cache_close.
+void fragment_cache_store(fragment_cache_t *cache, int index, const entry_file_t *entry,
+                          const char *data, size_t length) {
+    if (!cache->enabled || index < 0 || index >= cache->slot_count) return;
+    struct fragment_slot *slot = &cache->slots[index];
+    if (cache->write_failed || slot->state != SLOT_STALE || length > UINT32_MAX) return;
+
+    if (!cache->writing) {
+        char temp_path[TEMP_PATH_SIZE];
+        get_temp_path(cache, temp_path);
+        if (!output_open(&cache->update, temp_path)) {
+            cache->write_failed = 1;
+            return;
+        }
+        fragment_pack_header_t header;
+        memset(&header, 0, sizeof(header));
+        output_write(&cache->update, (const char *)&header, sizeof(header));
+        cache->update_size = sizeof(header);
+        cache->writing = 1;
+    }
+
+    size_t path_length = strlen(entry->path);
+    output_write(&cache->update, entry->path, path_length);
+    output_write(&cache->update, data, length);
+    slot->offset = cache->update_size;
+    slot->length = (uint32_t)length;
+    slot->state = SLOT_FRESH;
+    cache->update_size += path_length + length;
+}
+
+static void copy_old_fragment(fragment_cache_t *cache, const struct fragment_record *old,
+                              struct fragment_record *record) {
+    *record = *old;
+    record->offset = cache->update_size;
+    output_write(&cache->update, cache->pack.data + old->offset, old->path_length + old->length);
+    cache->update_size += old->path_length + old->length;
+}
+
+// Merge the fragments rendered by this export with the rest of the old
+// pack (days outside the export range keep their fragments) and replace
+// the pack. Nothing is written if every day was a cache hit.
+static int commit_pack(fragment_cache_t *cache, const entry_list_t *entries) {
+    int capacity = cache->record_count + entries->count;
+    struct fragment_record *records = calloc(capacity > 0 ? capacity : 1, sizeof(*records));
+    if (!records) return 0;
+
+    int count = 0, old = 0;
+    for (int i = 0; i <= entries->count; i++) {
+        // Old records dated before this entry (or all that remain)
+        int key = (i < entries->count) ?
+            date_key(entries->items[i].date.year, entries->items[i].date.month, entries->items[i].date.day) :
+            INT32_MAX;
+        while (old < cache->record_count &&
+               date_key(cache->records[old].year, cache->records[old].month, cache->records[old].day) < key) {
+            copy_old_fragment(cache, &cache->records[old++], &records[count++]);
+        }
+        if (old < cache->record_count &&
+            date_key(cache->records[old].year, cache->records[old].month, cache->records[old].day) == key) {
+            old++;  // Replaced by this export's result below (or dropped)
+        }
+        if (i == entries->count) break;
+
+        const struct fragment_slot *slot = &cache->slots[i];
+        const entry_file_t *entry = &entries->items[i];
+        if (slot->state == SLOT_HIT) {
+            copy_old_fragment(cache, &cache->records[slot->old_record], &records[count++]);
+        } else if (slot->state == SLOT_FRESH) {
+            struct fragment_record *record = &records[count++];
+            memset(record, 0, sizeof(*record));
+            record->mtime = slot->mtime;
+            record->size = slot->size;
+            record->offset = slot->offset;
+            record->path_length = (uint32_t)strlen(entry->path);
+            record->length = slot->length;
+            record->year = (uint16_t)entry->date.year;
+            record->month = (uint8_t)entry->date.month;
+            record->day = (uint8_t)entry->date.day;
+        }
+    }
+
+    // Records start 8-byte aligned so the pack can be read in place
+    static const char padding[8];
+    size_t pad = (8 - cache->update_size % 8) % 8;
+    output_write(&cache->update, padding, pad);
+    cache->update_size += pad;
+
+    fragment_pack_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FRAGMENT_MAGIC, 4);
+    header.version = cache->version;
+    header.count = (uint32_t)count;
+    header.records_offset = cache->update_size;
+    output_write(&cache->update, (const char *)records, count * sizeof(*records));
+    free(records);
+
+    int ok = output_flush(&cache->update) &&
+             pwrite(cache->update.fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+    return output_close(&cache->update) && ok;
+}
+
+// Finish an export: save the updated pack if anything was rendered, then
+// release the cache. entries must be the list the export ran over.
+void fragment_cache_close(fragment_cache_t *cache, const entry_list_t *entries) {
+    if (cache->writing) {
+        char temp_path[TEMP_PATH_SIZE];
+        get_temp_path(cache, temp_path);
+        if (!cache->write_failed && entries->count == cache->slot_count && commit_pack(cache, entries)) {
+            unmap_file(&cache->pack);
+            if (rename(temp_path, cache->path) != 0) unlink(temp_path);
+        } else {
+            output_close(&cache->update);
+            unlink(temp_path);
+        }
+    }
+
+    unmap_file(&cache->pack);
+    free(cache->slots);
+    memset(cache, 0, sizeof(*cache));
+}
@@ -0,0 +1,466 @@
+#define _GNU_SOURCE
+#include "ciary.h"
+#include <ctype.h>
+#include <dirent.h>
+#include <pthread.h>
+
+// Line search over day files. Patterns are plain substrings or POSIX
+// extended regexes; the strings every match must contain are pulled out
+// of the pattern at compile time, both to pick candidate files from the
+// trigram index and to find candidate lines with memmem before running
+// the regex. Without a trigram index, grep_scan_journal reads every day
+// file on the export worker pool instead.
+
+static char fold(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+static void fold_copy(char *to, const char *from, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        to[i] = fold(from[i]);
+    }
+}
+
+// Collects literal runs into pattern->literals
+typedef struct {
+    char *out;
+    size_t length;    // Of the run being built
+    int count;
+} literal_builder_t;
+
+static void end_literal(grep_pattern_t *pattern, literal_builder_t *builder) {
+    if (builder->length == 0) return;
+    builder->out[builder->length] = '\0';
+    if (builder->length > pattern->anchor_length) {
+        pattern->anchor = builder->out;
+        pattern->anchor_length = builder->length;
+    }
+    builder->out += builder->length + 1;
+    builder->length = 0;
+    builder->count++;
+}
+
+// Skip a bracket expression starting at p[0] == '['
+static const char* skip_bracket(const char *p) {
+    p++;
+    if (*p == '^') p++;
+    if (*p == ']') p++;
+    while (*p && *p != ']') {
+        if (p[0] == '[' && (p[1] == ':' || p[1] == '=' || p[1] == '.')) {
+            char close = p[1];
+            p += 2;
+            while (*p && !(p[0] == close && p[1] == ']')) p++;
+            if (*p) p += 2;
+        } else {
+            p++;
+        }
+    }
+    return *p ? p + 1 : p;
+}
+
+// Find the literal runs of an extended regex that every match contains:
+// text outside groups, cut wherever something other than a plain byte
+// follows. A '|' anywhere makes every part optional, so nothing is kept.
+// Missing a literal only weakens the filter; keeping a wrong one would
+// lose matches, so anything unusual just ends the current run.
+static void extract_regex_literals(grep_pattern_t *pattern, literal_builder_t *builder) {
+    const char *p = pattern->text;
+    if (strchr(p, '|')) return;
+
+    int depth = 0;
+    while (*p) {
+        char c = *p;
+        if (c == '[') {
+            end_literal(pattern, builder);
+            p = skip_bracket(p);
+            continue;
+        }
+        if (c == '*' || c == '?' || c == '{') {
+            // The byte before is optional: take it back out of the run
+            if (depth == 0 && builder->length > 0) builder->length--;
+            end_literal(pattern, builder);
+            if (c == '{') {
+                while (*p && *p != '}') p++;
+                if (*p) p++;
+            } else {
+                p++;
+            }
+            continue;
+        }
+        if (c == '+') {
+            // At least one of the byte before; what follows need not be adjacent
+            end_literal(pattern, builder);
+            p++;
+            continue;
+        }
+        if (c == '(' || c == ')') {
+            end_literal(pattern, builder);
+            depth += (c == '(') ? 1 : (depth > 0 ? -1 : 0);
+            p++;
+            continue;
+        }
+        if (c == '.' || c == '^' || c == '$') {
+            end_literal(pattern, builder);
+            p++;
+            continue;
+        }
+
+        char literal = c;
+        if (c == '\\') {
+            // \w, \b, \1 and friends aren't literal bytes
+            if (p[1] == '\0' || isalnum((unsigned char)p[1]) || p[1] == '<' || p[1] == '>' ||
+                p[1] == '`' || p[1] == '\'') {
+                end_literal(pattern, builder);
+                p += p[1] ? 2 : 1;
+                continue;
+            }
+            literal = p[1];
+            p++;
+        }
+        p++;
+
+        // Case-insensitive regexes may fold non-ASCII letters too, which
+        // the byte-wise filter can't follow
+        if ((pattern->flags & GREP_IGNORE_CASE) && (unsigned char)literal >= 0x80) {
+            end_literal(pattern, builder);
+        } else if (depth == 0) {
+            builder->out[builder->length++] = fold(literal);
+        }
+    }
+    end_literal(pattern, builder);
+}
+
+// Compile text for grep_buffer. Returns 0 with a message in error if the
+// regex is invalid.
+int grep_pattern_compile(grep_pattern_t *pattern, const char *text, int flags, char *error, size_t size) {
+    memset(pattern, 0, sizeof(*pattern));
+    pattern->flags = flags;
+    pattern->length = strlen(text);
+    pattern->text = strdup(text);
+    // Runs never add up to more than the pattern, plus their terminators
+    pattern->literals = malloc(pattern->length * 2 + 1);
+    if (!pattern->text || !pattern->literals) {
+        snprintf(error, size, "out of memory");
+        free(pattern->text);
+        free(pattern->literals);
+        return 0;
+    }
+
+    literal_builder_t builder = {pattern->literals, 0, 0};
+    if (flags & GREP_FIXED) {
+        fold_copy(builder.out, text, pattern->length);
+        builder.length = pattern->length;
+        end_literal(pattern, &builder);
+    } else {
+        int result = regcomp(&pattern->regex, text,
+                             REG_EXTENDED | REG_NOSUB | ((flags & GREP_IGNORE_CASE) ? REG_ICASE : 0));
+        if (result != 0) {
+            regerror(result, &pattern->regex, error, size);
+            free(pattern->text);
+            free(pattern->literals);
+            return 0;
+        }
+        extract_regex_literals(pattern, &builder);
+    }
+    pattern->literal_count = builder.count;
+    return 1;
+}
+
+void grep_pattern_free(grep_pattern_t *pattern) {
+    if (!(pattern->flags & GREP_FIXED) && pattern->text) {
+        regfree(&pattern->regex);
+    }
+    free(pattern->text);
+    free(pattern->literals);
+    memset(pattern, 0, sizeof(*pattern));
+}
+
+// Per-file state while reporting matches
+typedef struct {
+    grep_match_t match;
+    const char *data;
+    const char *counted;  // Lines are counted up to here
+    section_list_t sections;
+    int scanned;
+    int section;
+    char *line;           // NUL-terminated copy for regexec
+    size_t line_capacity;
+} file_scan_t;
+
+static int regex_matches_line(const grep_pattern_t *pattern, file_scan_t *scan, const char *line, size_t length) {
+    if (length + 1 > scan->line_capacity) {
+        size_t capacity = scan->line_capacity ? scan->line_capacity : 256;
+        while (capacity < length + 1) capacity *= 2;
+        char *grown = realloc(scan->line, capacity);
+        if (!grown) return 0;
+        scan->line = grown;
+        scan->line_capacity = capacity;
+    }
+    memcpy(scan->line, line, length);
+    scan->line[length] = '\0';
+    return regexec(&pattern->regex, scan->line, 0, NULL, 0) == 0;
+}
+
+static void locate_line(file_scan_t *scan, size_t length, const char *line, const char *line_end) {
+    // Line number: count the newlines skipped since the last match
+    for (const char *p = scan->counted; (p = memchr(p, '\n', line - p)) != NULL; p++) {
+        scan->match.line_number++;
+    }
+    scan->counted = line;
+
+    // Time section: sections are found once per file, on its first match
+    size_t offset = (size_t)(line - scan->data);
+    if (!scan->scanned) {
+        scan->scanned = 1;
+        if (!scan_sections(scan->data, length, &scan->sections)) scan->sections.count = 0;
+        scan->section = -1;
+    }
+    while (scan->section + 1 < scan->sections.count && scan->sections.sections[scan->section + 1].offset <= offset) {
+        scan->section++;
+    }
+    const entry_section_t *section = (scan->section >= 0) ? &scan->sections.sections[scan->section] : NULL;
+    scan->match.hour = section ? section->hour : -1;
+    scan->match.minute = section ? section->minute : 0;
+    scan->match.second = section ? section->second : 0;
+
+    if (line_end > line && line_end[-1] == '\r') line_end--;
+    scan->match.offset = offset;
+    scan->match.line = line;
+    scan->match.length = (size_t)(line_end - line);
+}
+
+// Report every line of data (a day file's contents) that matches pattern,
+// adding their number to *matches. Returns 0 if the callback asked to
+// stop or memory ran out.
+int grep_buffer(const grep_pattern_t *pattern, date_t date, const char *data, size_t length,
+                grep_match_fn callback, void *context, int *matches) {
+    int fixed = (pattern->flags & GREP_FIXED) != 0;
+    const char *needle = fixed ? pattern->text : pattern->anchor;
+    size_t needle_length = fixed ? pattern->length : pattern->anchor_length;
+
+    // The literals are folded, so they are looked for in a folded copy
+    const char *haystack = data;
+    char *folded = NULL;
+    if (needle && (!fixed || (pattern->flags & GREP_IGNORE_CASE))) {
+        folded = malloc(length > 0 ? length : 1);
+        if (!folded) return 0;
+        fold_copy(folded, data, length);
+        haystack = folded;
+        needle = pattern->anchor;
+        needle_length = pattern->anchor_length;
+    }
+
+    file_scan_t scan;
+    memset(&scan, 0, sizeof(scan));
+    scan.match.date = date;
+    scan.match.line_number = 1;
+    scan.data = data;
+    scan.counted = data;
+
+    const char *end = data + length;
+    const char *p = data;
+    int ok = 1;
+    while (p < end) {
+        const char *line = p;
+        const char *line_end;
+        if (needle) {
+            const char *found = memmem(haystack + (p - data), (size_t)(end - p), needle, needle_length);
+            if (!found) break;
+            const char *at = data + (found - haystack);
+            const char *previous = memrchr(p, '\n', (size_t)(at - p));
+            line = previous ? previous + 1 : p;
+            line_end = memchr(at, '\n', (size_t)(end - at));
+        } else {
+            line_end = memchr(p, '\n', (size_t)(end - p));
+        }
+        if (!line_end) line_end = end;
+
+        if (fixed || regex_matches_line(pattern, &scan, line, (size_t)(line_end - line))) {
+            locate_line(&scan, length, line, line_end);
+            (*matches)++;
+            if (!callback(&scan.match, context)) {
+                ok = 0;
+                break;
+            }
+        }
+        p = line_end + 1;
+    }
+
+    free_section_list(&scan.sections);
+    free(scan.line);
+    free(folded);
+    return ok;
+}
+
+// Report the lines of every day file that match pattern, in date order
+// or newest day first. The trigram index must be up to date with the
+// journal. Returns the number of matching lines, or -1 if memory ran out.
+int grep_journal(const trigram_index_t *index, const grep_pattern_t *pattern, const config_t *config,
+                 int newest_first, grep_match_fn callback, void *context) {
+    uint32_t *days;
+    int count;
+    if (!trigram_index_candidates(index, pattern, &days, &count)) return -1;
+
+    int matches = 0;
+    for (int i = 0; i < count; i++) {
+        const trigram_day_t *day = &index->days[days[newest_first ? count - 1 - i : i]];
+        date_t date = {day->year, day->month, day->day};
+        char path[MAX_PATH_SIZE];
+        mapped_file_t file;
+        if (!get_entry_path(date, path, config) || !map_file(path, &file)) continue;
+
+        int more = grep_buffer(pattern, date, file.data, file.length, callback, context, &matches);
+        unmap_file(&file);
+        if (!more) break;
+    }
+
+    free(days);
+    return matches;
+}
+
+// Write a match under a "YYYY-MM-DD HH:MM:SS" heading, starting a new
+// heading whenever the day or time section changes. group starts zeroed.
+void grep_write_match(output_sink_t *output, grep_group_t *group, const grep_match_t *match) {
+    if (!group->started || date_compare(group->date, match->date) != 0 || group->hour != match->hour ||
+        group->minute != match->minute || group->second != match->second) {
+        group->started = 1;
+        group->date = match->date;
+        group->hour = match->hour;
+        group->minute = match->minute;
+        group->second = match->second;
+        if (match->hour >= 0) {
+            output_printf(output, "%04d-%02d-%02d %02d:%02d:%02d\n", match->date.year, match->date.month,
+                          match->date.day, match->hour, match->minute, match->second);
+        } else {
+            output_printf(output, "%04d-%02d-%02d\n", match->date.year, match->date.month, match->date.day);
+        }
+    }
+    output_printf(output, "%6d: ", match->line_number);
+    output_write(output, match->line, match->length);
+    output_write(output, "\n", 1);
+}
+
+// Scan
+
+static int compare_entry_dates(const void *a, const void *b) {
+    return date_compare(((const entry_file_t *)a)->date, ((const entry_file_t *)b)->date);
+}
+
+// The day files of the journal directory in date order: one readdir
+// pass, and no stat until a worker opens the file
+static int list_day_files(const config_t *config, entry_list_t *entries) {
+    init_entry_list(entries);
+    DIR *dir = opendir(config->journal_directory);
+    if (!dir) return 0;
+
+    struct dirent *dirent;
+    char path[MAX_PATH_SIZE];
+    int ok = 1;
+    while (ok && (dirent = readdir(dir)) != NULL) {
+        date_t date;
+        if (!parse_date_from_filename(dirent->d_name, &date)) continue;
+        if (snprintf(path, sizeof(path), "%s/%s", config->journal_directory, dirent->d_name) >= (int)sizeof(path)) {
+            continue;
+        }
+        ok = add_entry_file(entries, date, path);
+    }
+    closedir(dir);
+
+    if (!ok) {
+        free_entry_list(entries);
+        return 0;
+    }
+    qsort(entries->items, entries->count, sizeof(entry_file_t), compare_entry_dates);
+    return 1;
+}
+
+typedef struct {
+    const grep_pattern_t *pattern;
+    pthread_key_t own_pattern;  // Per-thread copy of a regex pattern
+    pthread_mutex_t lock;
+    int matches;
+} grep_scan_t;
+
+// regexec may serialise threads sharing one compiled regex, so each
+// worker compiles its own. Fixed patterns are only read and are shared.
+static const grep_pattern_t* thread_pattern(grep_scan_t *scan) {
+    if (scan->pattern->flags & GREP_FIXED) return scan->pattern;
+
+    grep_pattern_t *own = pthread_getspecific(scan->own_pattern);
+    if (!own) {
+        char error[64];
+        own = malloc(sizeof(grep_pattern_t));
+        if (!own || !grep_pattern_compile(own, scan->pattern->text, scan->pattern->flags, error, sizeof(error))) {
+            free(own);
+            return scan->pattern;
+        }
+        pthread_setspecific(scan->own_pattern, own);
+    }
+    return own;
+}
+
+static void free_thread_pattern(void *pattern) {
+    grep_pattern_free(pattern);
+    free(pattern);
+}
+
+typedef struct {
+    output_sink_t *output;
+    grep_group_t group;
+} grep_writer_t;
+
+static int write_scan_match(const grep_match_t *match, void *context) {
+    grep_writer_t *writer = context;
+    grep_write_match(writer->output, &writer->group, match);
+    return 1;
+}
+
+// Runs on a worker thread: the matches of one day file, into output
+static void scan_day_file(output_sink_t *output, const entry_file_t *entry, int index, void *context) {
+    grep_scan_t *scan = context;
+    (void)index;
+
+    mapped_file_t file;
+    if (!map_file(entry->path, &file)) return;
+
+    grep_writer_t writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.output = output;
+    int matches = 0;
+    grep_buffer(thread_pattern(scan), entry->date, file.data, file.length, write_scan_match, &writer, &matches);
+    unmap_file(&file);
+
+    pthread_mutex_lock(&scan->lock);
+    scan->matches += matches;
+    pthread_mutex_unlock(&scan->lock);
+}
+
+// Search every day file without an index: the directory is listed once
+// and the files are mapped and scanned on the export worker pool, with
+// the grouped matches written to output in date order. Returns the
+// number of matching lines, or -1 if the journal couldn't be listed.
+int grep_scan_journal(const grep_pattern_t *pattern, const config_t *config, output_sink_t *output) {
+    entry_list_t entries;
+    if (!list_day_files(config, &entries)) return -1;
+
+    grep_scan_t scan;
+    memset(&scan, 0, sizeof(scan));
+    scan.pattern = pattern;
+    if (pthread_key_create(&scan.own_pattern, free_thread_pattern) != 0) {
+        free_entry_list(&entries);
+        return -1;
+    }
+    pthread_mutex_init(&scan.lock, NULL);
+
+    int ok = run_export_pipeline(&entries, scan_day_file, NULL, &scan, output, NULL);
+
+    // Workers free their copies as they exit; the calling thread has one
+    // too if the pool ran sequentially
+    grep_pattern_t *own = pthread_getspecific(scan.own_pattern);
+    if (own) free_thread_pattern(own);
+    pthread_key_delete(scan.own_pattern);
+    pthread_mutex_destroy(&scan.lock);
+    free_entry_list(&entries);
+
+    return ok ? scan.matches : -1;
+}
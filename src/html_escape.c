@@ -0,0 +1,151 @@
+#include "ciary.h"
+
+#ifdef CIARY_X86_SIMD
+#include <immintrin.h>
+#endif
+
+// Replacement text for bytes that must be escaped in HTML text and quoted
+// attribute values; NULL means the byte is copied through unchanged
+static const char *const html_escapes[256] = {
+    ['<'] = "&lt;",
+    ['>'] = "&gt;",
+    ['&'] = "&amp;",
+    ['"'] = "&quot;",
+    ['\''] = "&#39;",
+};
+
+static const unsigned char html_escape_lengths[256] = {
+    ['<'] = 4,
+    ['>'] = 4,
+    ['&'] = 5,
+    ['"'] = 6,
+    ['\''] = 5,
+};
+
+// Escape search kernels. Each returns the first byte in [p, end) that
+// needs escaping, or end. Journal text is mostly clean, so the vector
+// kernels reject a whole block with five compares and one movemask.
+typedef const char* (*html_special_fn)(const char *p, const char *end);
+
+static const char* find_html_special_scalar(const char *p, const char *end) {
+    while (p < end && !html_escapes[(unsigned char)*p]) {
+        p++;
+    }
+    return p;
+}
+
+#ifdef CIARY_X86_SIMD
+__attribute__((target("sse2")))
+static const char* find_html_special_sse2(const char *p, const char *end) {
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i quot = _mm_set1_epi8('"');
+    const __m128i apos = _mm_set1_epi8('\'');
+
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)p);
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, lt), _mm_cmpeq_epi8(block, gt)),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, amp), _mm_cmpeq_epi8(block, quot)),
+                         _mm_cmpeq_epi8(block, apos)));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask) {
+            return p + __builtin_ctz((unsigned int)mask);
+        }
+        p += 16;
+    }
+    return find_html_special_scalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* find_html_special_avx2(const char *p, const char *end) {
+    const __m256i lt = _mm256_set1_epi8('<');
+    const __m256i gt = _mm256_set1_epi8('>');
+    const __m256i amp = _mm256_set1_epi8('&');
+    const __m256i quot = _mm256_set1_epi8('"');
+    const __m256i apos = _mm256_set1_epi8('\'');
+
+    while (end - p >= 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)p);
+        __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, lt), _mm256_cmpeq_epi8(block, gt)),
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, amp), _mm256_cmpeq_epi8(block, quot)),
+                            _mm256_cmpeq_epi8(block, apos)));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hits);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return find_html_special_sse2(p, end);
+}
+#endif
+
+typedef struct {
+    const char *name;
+    html_special_fn fn;
+} html_escape_kernel_t;
+
+static const html_escape_kernel_t html_escape_kernels[] = {
+#ifdef CIARY_X86_SIMD
+    {"avx2", find_html_special_avx2},
+    {"sse2", find_html_special_sse2},
+#endif
+    {"scalar", find_html_special_scalar},
+    {NULL, NULL}
+};
+
+static const html_escape_kernel_t *active_kernel = NULL;
+
+// Pick the widest kernel this CPU supports (first call only)
+static const html_escape_kernel_t* get_html_escape_kernel(void) {
+    if (!active_kernel) {
+        for (const html_escape_kernel_t *kernel = html_escape_kernels; kernel->name; kernel++) {
+            if (cpu_supports_kernel(kernel->name)) {
+                active_kernel = kernel;
+                break;
+            }
+        }
+    }
+    return active_kernel;
+}
+
+const char* html_escape_kernel_name(void) {
+    return get_html_escape_kernel()->name;
+}
+
+// Force a specific kernel (for tests and benchmarks). Returns 0 if this
+// build or CPU doesn't support it.
+int select_html_escape_kernel(const char *name) {
+    for (const html_escape_kernel_t *kernel = html_escape_kernels; kernel->name; kernel++) {
+        if (strcmp(kernel->name, name) == 0 && cpu_supports_kernel(kernel->name)) {
+            active_kernel = kernel;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Return the first byte in [p, end) that needs escaping, or end
+const char* find_html_special(const char *p, const char *end) {
+    return get_html_escape_kernel()->fn(p, end);
+}
+
+// Escape text for HTML into a sink. Clean runs between special bytes are
+// copied with a single output_write.
+void write_html_escaped(output_sink_t *sink, const char *text, size_t length) {
+    html_special_fn find = get_html_escape_kernel()->fn;
+    const char *p = text;
+    const char *end = text + length;
+
+    while (p < end) {
+        const char *special = find(p, end);
+        if (special > p) output_write(sink, p, special - p);
+        if (special == end) break;
+
+        unsigned char c = (unsigned char)*special;
+        output_write(sink, html_escapes[c], html_escape_lengths[c]);
+        p = special + 1;
+    }
+}
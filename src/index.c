@@ -0,0 +1,436 @@
+#define _GNU_SOURCE
+#include "ciary.h"
+#include <dirent.h>
+#include <stdint.h>
+
+// On-disk layout of .ciary-index (host byte order; a foreign or corrupt
+// file is simply rebuilt):
+//   header:  magic "CIDX", uint32 version, uint32 entry count
+//   entries: index_record_t followed by section_count uint32 offsets
+#define INDEX_MAGIC "CIDX"
+#define INDEX_VERSION 2
+#define INDEX_MAX_SECTIONS (1 << 20)
+
+typedef struct {
+    int64_t mtime;
+    int64_t size;
+    uint32_t section_count;
+    uint32_t word_count;
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint32_t reserved;
+} index_record_t;
+
+void journal_index_init(journal_index_t *index) {
+    memset(index, 0, sizeof(*index));
+}
+
+static void free_entry(index_entry_t *entry) {
+    free(entry->section_offsets);
+    entry->section_offsets = NULL;
+    entry->section_count = 0;
+}
+
+void journal_index_free(journal_index_t *index) {
+    for (int i = 0; i < index->count; i++) {
+        free_entry(&index->entries[i]);
+    }
+    free(index->entries);
+    journal_index_init(index);
+}
+
+static char* get_index_path(char *path, const config_t *config) {
+    int result = snprintf(path, MAX_PATH_SIZE, "%s/%s", config->journal_directory, JOURNAL_INDEX_FILE);
+    return (result < MAX_PATH_SIZE) ? path : NULL;
+}
+
+static index_entry_t* append_entry(journal_index_t *index) {
+    if (index->count == index->capacity) {
+        int capacity = index->capacity ? index->capacity * 2 : 64;
+        index_entry_t *entries = realloc(index->entries, capacity * sizeof(index_entry_t));
+        if (!entries) return NULL;
+        index->entries = entries;
+        index->capacity = capacity;
+    }
+    index_entry_t *entry = &index->entries[index->count++];
+    memset(entry, 0, sizeof(*entry));
+    return entry;
+}
+
+// Put entries in date order without a comparison sort. Day files map to
+// unique day numbers, so each entry drops into its own bucket and the
+// buckets are read back in order. Duplicate days (only possible from a
+// corrupt index) keep the first entry.
+static int order_entries_by_day(journal_index_t *index) {
+    if (index->count < 2) return 1;
+    
+    int min_day = date_to_days(index->entries[0].date);
+    int max_day = min_day;
+    int ordered = 1;
+    for (int i = 1; i < index->count; i++) {
+        int day = date_to_days(index->entries[i].date);
+        if (day <= date_to_days(index->entries[i - 1].date)) ordered = 0;
+        if (day < min_day) min_day = day;
+        if (day > max_day) max_day = day;
+    }
+    if (ordered) return 1;
+    
+    size_t span = (size_t)(max_day - min_day) + 1;
+    int *buckets = malloc(span * sizeof(int));
+    index_entry_t *sorted = malloc(index->count * sizeof(index_entry_t));
+    if (!buckets || !sorted) {
+        free(buckets);
+        free(sorted);
+        return 0;
+    }
+    memset(buckets, 0xff, span * sizeof(int));  // -1: empty bucket
+    
+    for (int i = 0; i < index->count; i++) {
+        size_t bucket = (size_t)(date_to_days(index->entries[i].date) - min_day);
+        if (buckets[bucket] >= 0) {
+            free_entry(&index->entries[i]);
+            index->dirty = 1;
+            continue;
+        }
+        buckets[bucket] = i;
+    }
+    
+    int count = 0;
+    for (size_t bucket = 0; bucket < span; bucket++) {
+        if (buckets[bucket] >= 0) {
+            sorted[count++] = index->entries[buckets[bucket]];
+        }
+    }
+    
+    memcpy(index->entries, sorted, count * sizeof(index_entry_t));
+    index->count = count;
+    free(sorted);
+    free(buckets);
+    return 1;
+}
+
+// Index of the first entry on or after date (count if there is none)
+int journal_index_lower_bound(const journal_index_t *index, date_t date) {
+    int lo = 0, hi = index->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (date_compare(index->entries[mid].date, date) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+const index_entry_t* journal_index_find(const journal_index_t *index, date_t date) {
+    int pos = journal_index_lower_bound(index, date);
+    if (pos < index->count && date_compare(index->entries[pos].date, date) == 0) {
+        return &index->entries[pos];
+    }
+    return NULL;
+}
+
+// Records hold the dates of day files, so anything parse_date_from_filename
+// wouldn't accept comes from a corrupt index
+static int is_valid_record_date(const index_record_t *record) {
+    return record->year >= 1900 && record->year <= 3000 && record->month >= 1 && record->month <= 12 &&
+           record->day >= 1 && record->day <= days_in_month(record->month, record->year);
+}
+
+int journal_index_load(journal_index_t *index, const config_t *config) {
+    char path[MAX_PATH_SIZE];
+    char magic[4];
+    uint32_t version, count;
+    
+    journal_index_free(index);
+    if (!get_index_path(path, config)) return 0;
+    
+    FILE *file = fopen(path, "rb");
+    if (!file) return 0;  // No index yet
+    
+    if (fread(magic, 1, 4, file) != 4 || memcmp(magic, INDEX_MAGIC, 4) != 0 ||
+        fread(&version, sizeof(version), 1, file) != 1 || version != INDEX_VERSION ||
+        fread(&count, sizeof(count), 1, file) != 1) {
+        fclose(file);
+        return 0;
+    }
+    
+    int corrupt = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        index_record_t record;
+        if (fread(&record, sizeof(record), 1, file) != 1 ||
+            record.section_count > INDEX_MAX_SECTIONS) {
+            break;
+        }
+        
+        // Skip a record with an impossible date, offsets and all; the next
+        // save drops it
+        if (!is_valid_record_date(&record)) {
+            if (fseek(file, (long)(record.section_count * sizeof(uint32_t)), SEEK_CUR) != 0) break;
+            corrupt = 1;
+            continue;
+        }
+        
+        index_entry_t *entry = append_entry(index);
+        if (!entry) break;
+        
+        entry->date.year = record.year;
+        entry->date.month = record.month;
+        entry->date.day = record.day;
+        entry->mtime = (time_t)record.mtime;
+        entry->size = (off_t)record.size;
+        entry->word_count = (int)record.word_count;
+        
+        if (record.section_count > 0) {
+            entry->section_offsets = malloc(record.section_count * sizeof(uint32_t));
+            if (!entry->section_offsets ||
+                fread(entry->section_offsets, sizeof(uint32_t), record.section_count, file) != record.section_count) {
+                // Truncated file - drop the partial entry and keep what we have
+                free_entry(entry);
+                index->count--;
+                break;
+            }
+            entry->section_count = (int)record.section_count;
+        }
+    }
+    
+    fclose(file);
+    
+    // Entries are written sorted, but don't trust that blindly
+    index->dirty = corrupt;
+    order_entries_by_day(index);
+    return 1;
+}
+
+int journal_index_save(journal_index_t *index, const config_t *config) {
+    char path[MAX_PATH_SIZE];
+    char temp_path[MAX_PATH_SIZE];
+    
+    if (!index->dirty) return 1;
+    if (!get_index_path(path, config)) return 0;
+    if (snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= (int)sizeof(temp_path)) return 0;
+    
+    FILE *file = fopen(temp_path, "wb");
+    if (!file) return 0;
+    
+    uint32_t version = INDEX_VERSION;
+    uint32_t count = (uint32_t)index->count;
+    int ok = fwrite(INDEX_MAGIC, 1, 4, file) == 4 &&
+             fwrite(&version, sizeof(version), 1, file) == 1 &&
+             fwrite(&count, sizeof(count), 1, file) == 1;
+    
+    for (int i = 0; ok && i < index->count; i++) {
+        const index_entry_t *entry = &index->entries[i];
+        index_record_t record;
+        memset(&record, 0, sizeof(record));
+        record.mtime = (int64_t)entry->mtime;
+        record.size = (int64_t)entry->size;
+        record.section_count = (uint32_t)entry->section_count;
+        record.word_count = (uint32_t)entry->word_count;
+        record.year = (uint16_t)entry->date.year;
+        record.month = (uint8_t)entry->date.month;
+        record.day = (uint8_t)entry->date.day;
+        
+        ok = fwrite(&record, sizeof(record), 1, file) == 1 &&
+             (entry->section_count == 0 ||
+              fwrite(entry->section_offsets, sizeof(uint32_t), entry->section_count, file) ==
+                  (size_t)entry->section_count);
+    }
+    
+    if (fclose(file) != 0) ok = 0;
+    
+    // Replace the old index atomically so readers never see a partial file
+    if (!ok || rename(temp_path, path) != 0) {
+        unlink(temp_path);
+        return 0;
+    }
+    
+    index->dirty = 0;
+    return 1;
+}
+
+// Read a day file and record its section offsets and word count
+static int parse_day_file(const char *path, index_entry_t *entry) {
+    struct stat st;
+    if (stat(path, &st) != 0) return 0;
+    
+    mapped_file_t file;
+    if (!map_file(path, &file)) return 0;
+    
+    section_list_t sections;
+    memset(&sections, 0, sizeof(sections));
+    if (!scan_sections(file.data, file.length, &sections)) {
+        free_section_list(&sections);
+        unmap_file(&file);
+        return 0;
+    }
+    
+    uint32_t *offsets = NULL;
+    if (sections.count > 0) {
+        offsets = malloc(sections.count * sizeof(uint32_t));
+        if (!offsets) {
+            free_section_list(&sections);
+            unmap_file(&file);
+            return 0;
+        }
+        for (int i = 0; i < sections.count; i++) {
+            offsets[i] = (uint32_t)sections.sections[i].offset;
+        }
+    }
+    
+    free_entry(entry);
+    entry->section_offsets = offsets;
+    entry->section_count = sections.count;
+    entry->word_count = count_words(file.data, file.length);
+    entry->mtime = st.st_mtime;
+    entry->size = st.st_size;
+    
+    free_section_list(&sections);
+    unmap_file(&file);
+    return 1;
+}
+
+// Bring the index up to date with the journal directory. Only files whose
+// mtime or size changed are reopened; everything else is a readdir + stat.
+int journal_index_refresh(journal_index_t *index, const config_t *config) {
+    DIR *dir = opendir(config->journal_directory);
+    if (!dir) {
+        if (index->count > 0) {
+            journal_index_free(index);
+            index->dirty = 1;
+        }
+        return 0;
+    }
+    
+    // Track which known entries still have a file
+    char *seen = calloc(index->count > 0 ? index->count : 1, 1);
+    if (!seen) {
+        closedir(dir);
+        return 0;
+    }
+    
+    int known = index->count;
+    int added = 0;
+    struct dirent *dirent;
+    char path[MAX_PATH_SIZE];
+    
+    while ((dirent = readdir(dir)) != NULL) {
+        date_t date;
+        if (!parse_date_from_filename(dirent->d_name, &date)) {
+            continue;
+        }
+        
+        struct stat st;
+        if (fstatat(dirfd(dir), dirent->d_name, &st, 0) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        
+        if (snprintf(path, sizeof(path), "%s/%s", config->journal_directory, dirent->d_name) >= (int)sizeof(path)) {
+            continue;
+        }
+        
+        // Known entries are sorted; new ones are appended past 'known'
+        index_entry_t *entry = NULL;
+        int lo = 0, hi = known;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (date_compare(index->entries[mid].date, date) < 0) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo < known && date_compare(index->entries[lo].date, date) == 0) {
+            entry = &index->entries[lo];
+            seen[lo] = 1;
+            if (entry->mtime == st.st_mtime && entry->size == st.st_size) {
+                continue;  // Unchanged
+            }
+        } else {
+            entry = append_entry(index);
+            if (!entry) continue;
+            entry->date = date;
+            added++;
+        }
+        
+        if (parse_day_file(path, entry)) {
+            index->dirty = 1;
+        }
+    }
+    
+    closedir(dir);
+    
+    // Drop entries whose files are gone
+    int kept = 0;
+    for (int i = 0; i < index->count; i++) {
+        if (i < known && !seen[i]) {
+            free_entry(&index->entries[i]);
+            index->dirty = 1;
+            continue;
+        }
+        index->entries[kept++] = index->entries[i];
+    }
+    index->count = kept;
+    free(seen);
+    
+    if (added > 0) {
+        order_entries_by_day(index);
+    }
+    
+    return 1;
+}
+
+// Load the saved index, bring it up to date and write it back if needed
+int journal_index_open(journal_index_t *index, const config_t *config) {
+    journal_index_load(index, config);
+    int result = journal_index_refresh(index, config);
+    journal_index_save(index, config);
+    return result;
+}
+
+// Re-check a single day after it may have been edited
+int journal_index_update_day(journal_index_t *index, date_t date, const config_t *config) {
+    char path[MAX_PATH_SIZE];
+    if (!get_entry_path(date, path, config)) return 0;
+    
+    int pos = journal_index_lower_bound(index, date);
+    int found = (pos < index->count && date_compare(index->entries[pos].date, date) == 0);
+    
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        if (found) {
+            free_entry(&index->entries[pos]);
+            memmove(&index->entries[pos], &index->entries[pos + 1],
+                    (index->count - pos - 1) * sizeof(index_entry_t));
+            index->count--;
+            index->dirty = 1;
+        }
+        return 1;
+    }
+    
+    if (found) {
+        index_entry_t *entry = &index->entries[pos];
+        if (entry->mtime == st.st_mtime && entry->size == st.st_size) {
+            return 1;  // Unchanged
+        }
+        if (parse_day_file(path, entry)) {
+            index->dirty = 1;
+        }
+        return 1;
+    }
+    
+    // New day file: insert in date order
+    if (!append_entry(index)) return 0;
+    memmove(&index->entries[pos + 1], &index->entries[pos],
+            (index->count - 1 - pos) * sizeof(index_entry_t));
+    index_entry_t *entry = &index->entries[pos];
+    memset(entry, 0, sizeof(*entry));
+    entry->date = date;
+    if (!parse_day_file(path, entry)) {
+        memmove(&index->entries[pos], &index->entries[pos + 1],
+                (index->count - pos - 1) * sizeof(index_entry_t));
+        index->count--;
+        return 0;
+    }
+    index->dirty = 1;
+    return 1;
+}
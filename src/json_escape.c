@@ -0,0 +1,93 @@
+#include "ciary.h"
+
+// Short escapes for the bytes JSON names; other control characters are
+// written as \u00XX. Valid UTF-8 is copied through, and each byte that
+// isn't part of a valid sequence becomes \ufffd, so the output is always
+// valid JSON.
+static const char json_short_escapes[256] = {
+    ['"'] = '"',
+    ['\\'] = '\\',
+    ['\b'] = 'b',
+    ['\f'] = 'f',
+    ['\n'] = 'n',
+    ['\r'] = 'r',
+    ['\t'] = 't',
+};
+
+static int json_needs_escape(unsigned char c) {
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+// Length of the valid UTF-8 sequence at p, or 0 if the byte at p doesn't
+// start one. Overlong forms, surrogates and code points past U+10FFFF are
+// invalid, as are sequences cut short by end.
+static size_t utf8_sequence_length(const unsigned char *p, const unsigned char *end) {
+    unsigned char lo = 0x80, hi = 0xbf;
+    size_t length;
+    if (p[0] >= 0xc2 && p[0] <= 0xdf) {
+        length = 2;
+    } else if (p[0] >= 0xe0 && p[0] <= 0xef) {
+        length = 3;
+        if (p[0] == 0xe0) lo = 0xa0;
+        if (p[0] == 0xed) hi = 0x9f;
+    } else if (p[0] >= 0xf0 && p[0] <= 0xf4) {
+        length = 4;
+        if (p[0] == 0xf0) lo = 0x90;
+        if (p[0] == 0xf4) hi = 0x8f;
+    } else {
+        return 0;
+    }
+    if ((size_t)(end - p) < length) return 0;
+    if (p[1] < lo || p[1] > hi) return 0;
+    for (size_t i = 2; i < length; i++) {
+        if (p[i] < 0x80 || p[i] > 0xbf) return 0;
+    }
+    return length;
+}
+
+// Escape text as the inside of a JSON string. Clean runs, valid UTF-8
+// included, are copied with a single output_write; nothing is allocated.
+void write_json_escaped(output_sink_t *sink, const char *text, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+    const char *p = text;
+    const char *end = text + length;
+
+    while (p < end) {
+        // A clean run takes in valid UTF-8 sequences whole
+        const char *special = p;
+        while (special < end) {
+            unsigned char c = (unsigned char)*special;
+            if (c < 0x80) {
+                if (json_needs_escape(c)) break;
+                special++;
+            } else {
+                size_t sequence = utf8_sequence_length((const unsigned char *)special,
+                                                       (const unsigned char *)end);
+                if (!sequence) break;
+                special += sequence;
+            }
+        }
+        if (special > p) output_write(sink, p, special - p);
+        if (special == end) break;
+
+        unsigned char c = (unsigned char)*special;
+        if (c >= 0x80) {
+            output_write(sink, "\\ufffd", 6);
+            p = special + 1;
+            continue;
+        }
+
+        char escape[6] = {'\\', json_short_escapes[c]};
+        if (escape[1]) {
+            output_write(sink, escape, 2);
+        } else {
+            escape[1] = 'u';
+            escape[2] = '0';
+            escape[3] = '0';
+            escape[4] = hex[c >> 4];
+            escape[5] = hex[c & 0xf];
+            output_write(sink, escape, 6);
+        }
+        p = special + 1;
+    }
+}
@@ -67,12 +67,30 @@ void init_app(app_state_t *state) {
     // Load configuration (handles first-run setup) - before ncurses
     setup_first_run(&state->config);
     
+    // Look up editor and pager once; redraws reuse the result
+    resolve_programs(&state->config);
+    
+    // Bring the journal index up to date; only changed day files are read
+    journal_index_init(&state->index);
+    journal_index_open(&state->index, &state->config);
+    month_cache_invalidate(&state->month_cache);
+    search_index_init(&state->search);
+    state->search_loaded = 0;
+    trigram_index_init(&state->trigram);
+    state->trigram_loaded = 0;
+    state->panel = NULL;
+    
     // Initialize ncurses after config setup
     initscr();
     cbreak();
     noecho();
     keypad(stdscr, TRUE);
     curs_set(1);
+#ifdef NCURSES_VERSION
+    // Esc leaves the search panel; don't hold it back for a second in case
+    // it starts an escape sequence
+    set_escdelay(25);
+#endif
     
     // Set up signal handler for graceful Ctrl+C handling
     signal(SIGINT, handle_sigint);
@@ -96,6 +114,10 @@ void run_app(app_state_t *state) {
                 draw_help();
                 state->mode = MODE_CALENDAR;
                 continue;
+            case MODE_SEARCH:
+                search_panel_poll(state);
+                draw_search_panel(state);
+                break;
         }
         
         // Check for interrupt signal (Ctrl+C) before getting input
@@ -107,13 +129,19 @@ void run_app(app_state_t *state) {
             continue;
         }
         
+        // While a search runs in the background, wake up now and then to
+        // pick up its results; otherwise just wait for a key
+        timeout(search_panel_waiting(state) ? SEARCH_POLL_MS : -1);
         ch = getch();
+        if (ch == ERR && search_panel_waiting(state)) {
+            continue;
+        }
         
-        // Global commands
+        // Global commands; in search mode every key goes to the query
         if (ch == 'q' && state->mode == MODE_CALENDAR) {
             break;
         }
-        if (ch == 'h') {
+        if (ch == 'h' && state->mode != MODE_SEARCH) {
             state->mode = MODE_HELP;
             continue;
         }
@@ -123,6 +151,9 @@ void run_app(app_state_t *state) {
             case MODE_CALENDAR:
                 handle_calendar_input(state, ch);
                 break;
+            case MODE_SEARCH:
+                handle_search_input(state, ch);
+                break;
             default:
                 break;
         }
@@ -130,8 +161,10 @@ void run_app(app_state_t *state) {
 }
 
 int main(int argc, char *argv[]) {
-    (void)argc; // Suppress unused parameter warning
-    (void)argv;
+    // Subcommands (e.g. "ciary export") run without curses
+    if (argc > 1) {
+        return run_cli(argc, argv);
+    }
     
     app_state_t state;
     
@@ -144,6 +177,12 @@ int main(int argc, char *argv[]) {
     
     cleanup_app();
     
+    search_panel_free(&state);
+    journal_index_save(&state.index, &state.config);
+    journal_index_free(&state.index);
+    search_index_free(&state.search);
+    trigram_index_free(&state.trigram);
+    
     show_personalized_goodbye(&state.config);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,634 @@
+#include "ciary.h"
+
+// Streaming Markdown to HTML. Input arrives in arbitrary chunks and is
+// rendered as it goes; the only buffering is a short line prefix (to
+// recognise block markers) and a bounded link text/URL, so memory use
+// doesn't depend on file or line length.
+//
+// Supported: paragraphs, "#" headings, ``` fenced code, "-"/"*"/"+" and
+// "1." lists, *em*/_em_, **strong**/__strong__, `code` spans,
+// [text](url) links and backslash escapes.
+
+// Block the renderer is inside
+#define MD_BLOCK_NONE 0
+#define MD_BLOCK_PARAGRAPH 1
+#define MD_BLOCK_HEADING 2
+#define MD_BLOCK_CODE 3
+#define MD_BLOCK_ITEM 4
+
+#define MD_LIST_NONE 0
+#define MD_LIST_UL 1
+#define MD_LIST_OL 2
+
+// Where in the current line the renderer is
+#define MD_LINE_START 0  // Collecting the prefix to classify the line
+#define MD_LINE_TEXT 1   // Inline content
+#define MD_LINE_SKIP 2   // Ignoring the rest of the line (fence info string)
+#define MD_LINE_CODE 3   // Raw content of a fenced code block
+
+#define MD_LINK_NONE 0
+#define MD_LINK_TEXT 1   // After "["
+#define MD_LINK_CLOSE 2  // After "]", expecting "("
+#define MD_LINK_URL 3    // After "("
+
+// Inline spans (also the entries of the open span stack)
+#define MD_SPAN_EM 1
+#define MD_SPAN_STRONG 2
+#define MD_SPAN_CODE 3
+
+// Line prefix classifications
+#define MD_MARK_UNDECIDED 0
+#define MD_MARK_TEXT 1
+#define MD_MARK_BLANK 2
+#define MD_MARK_FENCE 3
+#define MD_MARK_HEADING 4
+#define MD_MARK_UL 5
+#define MD_MARK_OL 6
+
+// Byte classes for the inline state machine
+#define MD_PLAIN 0
+#define MD_NEWLINE 1
+#define MD_ESCAPE 2     // Needs an HTML entity
+#define MD_EMPHASIS 3   // '*' or '_'
+#define MD_BACKTICK 4
+#define MD_BACKSLASH 5
+#define MD_BRACKET 6    // '['
+
+static const unsigned char md_class[256] = {
+    ['\n'] = MD_NEWLINE,
+    ['<'] = MD_ESCAPE, ['>'] = MD_ESCAPE, ['&'] = MD_ESCAPE, ['"'] = MD_ESCAPE, ['\''] = MD_ESCAPE,
+    ['*'] = MD_EMPHASIS, ['_'] = MD_EMPHASIS,
+    ['`'] = MD_BACKTICK,
+    ['\\'] = MD_BACKSLASH,
+    ['['] = MD_BRACKET,
+};
+
+static const char *const span_open_tags[] = {NULL, "<em>", "<strong>", "<code>"};
+static const char *const span_close_tags[] = {NULL, "</em>", "</strong>", "</code>"};
+
+#define MD_LITERAL(md, text) output_write((md)->output, (text), sizeof(text) - 1)
+
+static void inline_byte(markdown_renderer_t *md, unsigned char c);
+
+void markdown_init(markdown_renderer_t *md, output_sink_t *output) {
+    memset(md, 0, sizeof(*md));
+    md->output = output;
+    md->last = '\n';
+}
+
+static int is_space(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static int is_alnum(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+static void write_text(markdown_renderer_t *md, const char *text, size_t length) {
+    write_html_escaped(md->output, text, length);
+}
+
+// Inline spans are kept on a small stack so tags always nest properly
+static int span_is_open(const markdown_renderer_t *md, int span) {
+    for (int i = 0; i < md->span_count; i++) {
+        if (md->spans[i] == span) return 1;
+    }
+    return 0;
+}
+
+static void open_span(markdown_renderer_t *md, int span) {
+    output_puts(md->output, span_open_tags[span]);
+    md->spans[md->span_count++] = (unsigned char)span;
+}
+
+// Close a span; spans opened inside it are closed and reopened around it
+static void close_span(markdown_renderer_t *md, int span) {
+    int index = md->span_count - 1;
+    while (index >= 0 && md->spans[index] != span) index--;
+    if (index < 0) return;
+
+    for (int i = md->span_count - 1; i >= index; i--) {
+        output_puts(md->output, span_close_tags[md->spans[i]]);
+    }
+    for (int i = index + 1; i < md->span_count; i++) {
+        output_puts(md->output, span_open_tags[md->spans[i]]);
+        md->spans[i - 1] = md->spans[i];
+    }
+    md->span_count--;
+}
+
+static void close_all_spans(markdown_renderer_t *md) {
+    while (md->span_count > 0) {
+        output_puts(md->output, span_close_tags[md->spans[--md->span_count]]);
+    }
+}
+
+// Decide what a run of '*' or '_' was, now that the byte after it is known
+static void resolve_emphasis(markdown_renderer_t *md, unsigned char next) {
+    char marker = md->pending;
+    int count = md->pending_count;
+    int span = (count == 2) ? MD_SPAN_STRONG : MD_SPAN_EM;
+    md->pending = 0;
+    md->pending_count = 0;
+
+    // '_' only counts at word boundaries, so snake_case stays literal
+    if (span_is_open(md, span)) {
+        if (marker == '*' || !is_alnum(next)) {
+            close_span(md, span);
+            return;
+        }
+    } else if (!is_space(next) && (marker == '*' || !is_alnum(md->last))) {
+        open_span(md, span);
+        return;
+    }
+
+    output_write(md->output, (marker == '*') ? "**" : "__", count);
+    md->last = (unsigned char)marker;
+}
+
+// Only web and mail links, and links without a scheme, are made live.
+// Browsers ignore leading spaces and control bytes, so the scheme is read
+// after them.
+static int url_is_safe(const char *url, size_t length) {
+    static const char *const schemes[] = {"http:", "https:", "mailto:"};
+    const char *end = url + length;
+    while (url < end && (unsigned char)*url <= 0x20) url++;
+
+    // A ':' after '/', '?' or '#' is part of a relative link
+    const char *colon = url;
+    while (colon < end && *colon != ':' && *colon != '/' && *colon != '?' && *colon != '#') colon++;
+    if (colon == end || *colon != ':') return 1;
+
+    size_t scheme_length = colon - url + 1;
+    for (size_t s = 0; s < sizeof(schemes) / sizeof(schemes[0]); s++) {
+        if (strlen(schemes[s]) != scheme_length) continue;
+        size_t i = 0;
+        while (i < scheme_length) {
+            char c = url[i];
+            if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+            if (c != schemes[s][i]) break;
+            i++;
+        }
+        if (i == scheme_length) return 1;
+    }
+    return 0;
+}
+
+// Give up on a link: whatever was buffered is plain text after all
+static void abort_link(markdown_renderer_t *md) {
+    int state = md->link_state;
+    md->link_state = MD_LINK_NONE;
+
+    MD_LITERAL(md, "[");
+    write_text(md, md->link_text, md->link_text_length);
+    if (state >= MD_LINK_CLOSE) MD_LITERAL(md, "]");
+    if (state == MD_LINK_URL) {
+        MD_LITERAL(md, "(");
+        write_text(md, md->link_url, md->link_url_length);
+    }
+    md->last = 'x';
+}
+
+static void finish_link(markdown_renderer_t *md) {
+    md->link_state = MD_LINK_NONE;
+    if (url_is_safe(md->link_url, md->link_url_length)) {
+        MD_LITERAL(md, "<a href=\"");
+        write_text(md, md->link_url, md->link_url_length);
+        MD_LITERAL(md, "\">");
+        write_text(md, md->link_text, md->link_text_length);
+        MD_LITERAL(md, "</a>");
+    } else {
+        write_text(md, md->link_text, md->link_text_length);
+    }
+    md->last = ')';
+}
+
+static void link_byte(markdown_renderer_t *md, unsigned char c) {
+    switch (md->link_state) {
+        case MD_LINK_TEXT:
+            if (c == ']') {
+                md->link_state = MD_LINK_CLOSE;
+            } else if (md->link_text_length < MARKDOWN_LINK_TEXT_MAX) {
+                md->link_text[md->link_text_length++] = (char)c;
+            } else {
+                abort_link(md);
+                inline_byte(md, c);
+            }
+            break;
+
+        case MD_LINK_CLOSE:
+            if (c == '(') {
+                md->link_state = MD_LINK_URL;
+                md->link_url_length = 0;
+            } else {
+                abort_link(md);
+                inline_byte(md, c);
+            }
+            break;
+
+        case MD_LINK_URL:
+            if (c == ')') {
+                finish_link(md);
+            } else if (!is_space(c) && md->link_url_length < MARKDOWN_LINK_URL_MAX) {
+                md->link_url[md->link_url_length++] = (char)c;
+            } else {
+                abort_link(md);
+                inline_byte(md, c);
+            }
+            break;
+    }
+}
+
+// One byte of inline content (never a newline)
+static void inline_byte(markdown_renderer_t *md, unsigned char c) {
+    if (md->link_state != MD_LINK_NONE) {
+        link_byte(md, c);
+        return;
+    }
+
+    int in_code = span_is_open(md, MD_SPAN_CODE);
+    int kind = md_class[c];
+
+    if (md->pending) {
+        if (kind == MD_EMPHASIS && c == (unsigned char)md->pending && md->pending_count == 1) {
+            md->pending_count = 2;
+            return;
+        }
+        resolve_emphasis(md, c);
+    }
+
+    if (md->escaped) {
+        md->escaped = 0;
+        if (kind == MD_PLAIN) MD_LITERAL(md, "\\");
+        if (kind == MD_ESCAPE) write_text(md, (const char *)&c, 1);
+        else output_write(md->output, (const char *)&c, 1);
+        md->last = c;
+        return;
+    }
+
+    switch (kind) {
+        case MD_ESCAPE:
+            write_text(md, (const char *)&c, 1);
+            break;
+
+        case MD_EMPHASIS:
+            if (in_code) {
+                output_write(md->output, (const char *)&c, 1);
+                break;
+            }
+            md->pending = (char)c;
+            md->pending_count = 1;
+            return;  // last stays the byte before the marker
+
+        case MD_BACKTICK:
+            if (in_code) close_span(md, MD_SPAN_CODE);
+            else open_span(md, MD_SPAN_CODE);
+            break;
+
+        case MD_BACKSLASH:
+            if (in_code) MD_LITERAL(md, "\\");
+            else md->escaped = 1;
+            break;
+
+        case MD_BRACKET:
+            if (in_code) {
+                MD_LITERAL(md, "[");
+                break;
+            }
+            md->link_state = MD_LINK_TEXT;
+            md->link_text_length = 0;
+            md->link_url_length = 0;
+            break;
+
+        default:
+            output_write(md->output, (const char *)&c, 1);
+            break;
+    }
+    md->last = c;
+}
+
+// Close anything inline that can't continue past this point
+static void settle_inline(markdown_renderer_t *md) {
+    if (md->link_state != MD_LINK_NONE) abort_link(md);
+    if (md->pending) resolve_emphasis(md, '\n');
+    if (md->escaped) {
+        MD_LITERAL(md, "\\");
+        md->escaped = 0;
+    }
+}
+
+static void close_block(markdown_renderer_t *md) {
+    settle_inline(md);
+    close_all_spans(md);
+
+    switch (md->block) {
+        case MD_BLOCK_PARAGRAPH:
+            MD_LITERAL(md, "</p>\n");
+            break;
+        case MD_BLOCK_ITEM:
+            MD_LITERAL(md, "</li>\n");
+            break;
+        case MD_BLOCK_HEADING:
+            output_printf(md->output, "</h%d>\n", md->heading_level);
+            break;
+        case MD_BLOCK_CODE:
+            MD_LITERAL(md, "</code></pre>\n");
+            break;
+    }
+    md->block = MD_BLOCK_NONE;
+}
+
+static void close_list(markdown_renderer_t *md) {
+    if (md->list == MD_LIST_UL) MD_LITERAL(md, "</ul>\n");
+    else if (md->list == MD_LIST_OL) MD_LITERAL(md, "</ol>\n");
+    md->list = MD_LIST_NONE;
+}
+
+static void end_line(markdown_renderer_t *md) {
+    settle_inline(md);
+    if (md->block == MD_BLOCK_HEADING) close_block(md);
+    md->line_state = MD_LINE_START;
+    md->prefix_length = 0;
+    md->last = '\n';
+}
+
+// Classify the start of a line. With complete set the prefix is the whole
+// line; otherwise more bytes may follow and the answer can be UNDECIDED.
+// *consumed is set to the length of the marker.
+static int classify_prefix(const char *prefix, int length, int complete, int *consumed) {
+    *consumed = 0;
+    int full = complete || length == MARKDOWN_PREFIX_MAX;
+
+    int spaces = 0;
+    while (spaces < length && (prefix[spaces] == ' ' || prefix[spaces] == '\t' || prefix[spaces] == '\r')) {
+        spaces++;
+    }
+    if (spaces == length) {
+        return complete ? MD_MARK_BLANK : (full ? MD_MARK_TEXT : MD_MARK_UNDECIDED);
+    }
+
+    char first = prefix[0];
+    if (first == '`') {
+        int ticks = 0;
+        while (ticks < length && prefix[ticks] == '`') ticks++;
+        if (ticks >= 3) {
+            *consumed = length;
+            return MD_MARK_FENCE;
+        }
+        return (ticks == length && !full) ? MD_MARK_UNDECIDED : MD_MARK_TEXT;
+    }
+
+    if (first == '#') {
+        int level = 0;
+        while (level < length && prefix[level] == '#') level++;
+        if (level == length) return (level <= 6 && !full) ? MD_MARK_UNDECIDED : MD_MARK_TEXT;
+        if (level <= 6 && prefix[level] == ' ') {
+            *consumed = level + 1;
+            return MD_MARK_HEADING;
+        }
+        return MD_MARK_TEXT;
+    }
+
+    if (first == '-' || first == '*' || first == '+') {
+        if (length == 1) return full ? MD_MARK_TEXT : MD_MARK_UNDECIDED;
+        if (prefix[1] == ' ') {
+            *consumed = 2;
+            return MD_MARK_UL;
+        }
+        return MD_MARK_TEXT;
+    }
+
+    if (first >= '0' && first <= '9') {
+        int digits = 0;
+        while (digits < length && prefix[digits] >= '0' && prefix[digits] <= '9') digits++;
+        if (digits > 9) return MD_MARK_TEXT;
+        if (digits == length) return full ? MD_MARK_TEXT : MD_MARK_UNDECIDED;
+        if (prefix[digits] != '.' && prefix[digits] != ')') return MD_MARK_TEXT;
+        if (digits + 1 == length) return full ? MD_MARK_TEXT : MD_MARK_UNDECIDED;
+        if (prefix[digits + 1] == ' ') {
+            *consumed = digits + 2;
+            return MD_MARK_OL;
+        }
+        return MD_MARK_TEXT;
+    }
+
+    return MD_MARK_TEXT;
+}
+
+// Feed bytes of the line that were held back while classifying it
+static void replay_prefix(markdown_renderer_t *md, int from) {
+    for (int i = from; i < md->prefix_length; i++) {
+        inline_byte(md, (unsigned char)md->prefix[i]);
+    }
+}
+
+// A line of a fenced code block has started: it either closes the block
+// or is copied through escaped
+static int start_code_line(markdown_renderer_t *md, int complete) {
+    int ticks = 0;
+    while (ticks < md->prefix_length && md->prefix[ticks] == '`') ticks++;
+    if (ticks < 3 && ticks == md->prefix_length && !complete) return 0;
+
+    if (ticks >= 3) {
+        close_block(md);
+        md->line_state = complete ? MD_LINE_START : MD_LINE_SKIP;
+    } else {
+        write_text(md, md->prefix, md->prefix_length);
+        if (complete) MD_LITERAL(md, "\n");
+        md->line_state = complete ? MD_LINE_START : MD_LINE_CODE;
+    }
+    md->prefix_length = 0;
+    return 1;
+}
+
+// Try to classify the line collected so far. Returns 0 if more bytes are
+// needed first.
+static int start_line(markdown_renderer_t *md, int complete) {
+    if (md->block == MD_BLOCK_CODE) return start_code_line(md, complete);
+
+    int consumed;
+    int mark = classify_prefix(md->prefix, md->prefix_length, complete, &consumed);
+    if (mark == MD_MARK_UNDECIDED) return 0;
+
+    switch (mark) {
+        case MD_MARK_BLANK:
+            close_block(md);
+            close_list(md);
+            md->prefix_length = 0;
+            md->line_state = MD_LINE_START;
+            return 1;
+
+        case MD_MARK_FENCE:
+            close_block(md);
+            close_list(md);
+            MD_LITERAL(md, "<pre><code>");
+            md->block = MD_BLOCK_CODE;
+            md->prefix_length = 0;
+            md->line_state = complete ? MD_LINE_START : MD_LINE_SKIP;
+            return 1;
+
+        case MD_MARK_HEADING:
+            close_block(md);
+            close_list(md);
+            md->heading_level = consumed - 1;
+            output_printf(md->output, "<h%d>", md->heading_level);
+            md->block = MD_BLOCK_HEADING;
+            break;
+
+        case MD_MARK_UL:
+        case MD_MARK_OL: {
+            int list = (mark == MD_MARK_UL) ? MD_LIST_UL : MD_LIST_OL;
+            close_block(md);
+            if (md->list != list) {
+                close_list(md);
+                if (list == MD_LIST_UL) MD_LITERAL(md, "<ul>\n");
+                else MD_LITERAL(md, "<ol>\n");
+                md->list = list;
+            }
+            MD_LITERAL(md, "<li>");
+            md->block = MD_BLOCK_ITEM;
+            break;
+        }
+
+        default:
+            // Plain text continues an open paragraph or list item
+            if (md->block == MD_BLOCK_PARAGRAPH || md->block == MD_BLOCK_ITEM) {
+                MD_LITERAL(md, "\n");
+            } else {
+                close_block(md);
+                close_list(md);
+                MD_LITERAL(md, "<p>");
+                md->block = MD_BLOCK_PARAGRAPH;
+            }
+            break;
+    }
+
+    md->line_state = MD_LINE_TEXT;
+    md->last = ' ';
+    replay_prefix(md, consumed);
+    if (complete) end_line(md);
+    return 1;
+}
+
+// Skip bytes that need no handling, eight table lookups per branch
+static const char* skip_plain(const char *p, const char *end) {
+    const unsigned char *u = (const unsigned char *)p;
+    const unsigned char *stop = (const unsigned char *)end;
+    while (stop - u >= 8) {
+        if (md_class[u[0]] | md_class[u[1]] | md_class[u[2]] | md_class[u[3]] |
+            md_class[u[4]] | md_class[u[5]] | md_class[u[6]] | md_class[u[7]]) {
+            break;
+        }
+        u += 8;
+    }
+    while (u < stop && md_class[*u] == MD_PLAIN) u++;
+    return (const char *)u;
+}
+
+// Copy link text or URL bytes up to the byte that ends it (or until the
+// buffer is full), leaving that byte to link_byte
+static const char* buffer_link_run(markdown_renderer_t *md, const char *p, const char *end) {
+    if (md->link_state == MD_LINK_TEXT) {
+        while (p < end && *p != ']' && *p != '\n' && md->link_text_length < MARKDOWN_LINK_TEXT_MAX) {
+            md->link_text[md->link_text_length++] = *p++;
+        }
+    } else {
+        while (p < end && *p != ')' && !is_space((unsigned char)*p) &&
+               md->link_url_length < MARKDOWN_LINK_URL_MAX) {
+            md->link_url[md->link_url_length++] = *p++;
+        }
+    }
+    return p;
+}
+
+// Inline content up to and including the end of the line. Runs of plain
+// bytes are copied in one write.
+static const char* render_inline(markdown_renderer_t *md, const char *p, const char *end) {
+    while (p < end) {
+        if (!md->pending && !md->escaped && md->link_state == MD_LINK_NONE) {
+            const char *run = p;
+            p = skip_plain(p, end);
+            if (p > run) {
+                output_write(md->output, run, p - run);
+                md->last = (unsigned char)p[-1];
+            }
+            if (p == end) break;
+        } else if (md->link_state == MD_LINK_TEXT || md->link_state == MD_LINK_URL) {
+            p = buffer_link_run(md, p, end);
+            if (p == end) break;
+        }
+
+        unsigned char c = (unsigned char)*p++;
+        if (c == '\n') {
+            end_line(md);
+            return p;
+        }
+        inline_byte(md, c);
+    }
+    return p;
+}
+
+// Render the next chunk of input
+void markdown_feed(markdown_renderer_t *md, const char *data, size_t length) {
+    const char *p = data;
+    const char *end = data + length;
+
+    while (p < end) {
+        switch (md->line_state) {
+            case MD_LINE_START: {
+                char c = *p++;
+                if (c == '\n') {
+                    start_line(md, 1);
+                    break;
+                }
+                md->prefix[md->prefix_length++] = c;
+                start_line(md, 0);
+                break;
+            }
+
+            case MD_LINE_TEXT:
+                p = render_inline(md, p, end);
+                break;
+
+            case MD_LINE_SKIP: {
+                const char *newline = memchr(p, '\n', end - p);
+                if (!newline) return;
+                p = newline + 1;
+                md->line_state = MD_LINE_START;
+                break;
+            }
+
+            case MD_LINE_CODE: {
+                const char *newline = memchr(p, '\n', end - p);
+                const char *line_end = newline ? newline : end;
+                write_text(md, p, line_end - p);
+                if (!newline) return;
+                MD_LITERAL(md, "\n");
+                p = newline + 1;
+                md->line_state = MD_LINE_START;
+                break;
+            }
+        }
+    }
+}
+
+// End of input: close whatever is still open
+void markdown_finish(markdown_renderer_t *md) {
+    if (md->line_state == MD_LINE_START && md->prefix_length > 0) {
+        start_line(md, 1);
+    } else if (md->line_state == MD_LINE_TEXT) {
+        end_line(md);
+    }
+    close_block(md);
+    close_list(md);
+    md->line_state = MD_LINE_START;
+    md->prefix_length = 0;
+}
+
+// Render a complete document in one call
+void markdown_render(output_sink_t *output, const char *data, size_t length) {
+    markdown_renderer_t md;
+    markdown_init(&md, output);
+    markdown_feed(&md, data, length);
+    markdown_finish(&md);
+}
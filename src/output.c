@@ -0,0 +1,276 @@
+#define _GNU_SOURCE
+#include "ciary.h"
+#include <fcntl.h>
+#include <stdarg.h>
+#include <sys/uio.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+#define OUTPUT_BUFFER_SIZE (256 * 1024)
+#define MEMORY_BUFFER_SIZE (16 * 1024)
+
+// Write every byte of an iovec array, resuming after short writes
+static int write_all(int fd, struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t written = writev(fd, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+
+        while (count > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    return 1;
+}
+
+// Attach a sink to an already open descriptor, which the caller keeps
+int output_init_fd(output_sink_t *sink, int fd) {
+    memset(sink, 0, sizeof(*sink));
+    sink->fd = fd;
+    sink->buffer = malloc(OUTPUT_BUFFER_SIZE);
+    if (!sink->buffer) {
+        sink->failed = 1;
+        return 0;
+    }
+    sink->capacity = OUTPUT_BUFFER_SIZE;
+    return 1;
+}
+
+// Start a sink that collects everything in memory. The buffer grows as
+// needed and is never flushed; output_reset empties it for reuse.
+int output_init_memory(output_sink_t *sink) {
+    memset(sink, 0, sizeof(*sink));
+    sink->fd = -1;
+    sink->buffer = malloc(MEMORY_BUFFER_SIZE);
+    if (!sink->buffer) {
+        sink->failed = 1;
+        return 0;
+    }
+    sink->capacity = MEMORY_BUFFER_SIZE;
+    return 1;
+}
+
+// Make room for length more bytes in a memory sink
+static int grow_memory(output_sink_t *sink, size_t length) {
+    size_t capacity = sink->capacity;
+    while (capacity - sink->used < length) {
+        capacity *= 2;
+    }
+    
+    char *buffer = realloc(sink->buffer, capacity);
+    if (!buffer) {
+        sink->failed = 1;
+        return 0;
+    }
+    sink->buffer = buffer;
+    sink->capacity = capacity;
+    return 1;
+}
+
+// Create or truncate a file and attach a sink to it
+int output_open(output_sink_t *sink, const char *path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        memset(sink, 0, sizeof(*sink));
+        sink->fd = -1;
+        sink->failed = 1;
+        return 0;
+    }
+
+    if (!output_init_fd(sink, fd)) {
+        close(fd);
+        sink->fd = -1;
+        return 0;
+    }
+    sink->close_fd = 1;
+    return 1;
+}
+
+// Hand buffered bytes to the kernel
+int output_flush(output_sink_t *sink) {
+    if (sink->failed) return 0;
+    if (sink->used == 0 || sink->fd < 0) return 1;
+
+    struct iovec iov = {sink->buffer, sink->used};
+    if (!write_all(sink->fd, &iov, 1)) {
+        sink->failed = 1;
+        return 0;
+    }
+    sink->used = 0;
+    return 1;
+}
+
+void output_write(output_sink_t *sink, const char *data, size_t length) {
+    if (sink->failed) return;
+
+    if (length <= sink->capacity - sink->used) {
+        memcpy(sink->buffer + sink->used, data, length);
+        sink->used += length;
+        return;
+    }
+
+    if (sink->fd < 0) {
+        if (!grow_memory(sink, length)) return;
+        memcpy(sink->buffer + sink->used, data, length);
+        sink->used += length;
+        return;
+    }
+
+    // Too big to stage: send what is buffered and the new data together
+    // in one writev() instead of copying it through the buffer
+    if (length >= sink->capacity / 2) {
+        struct iovec iov[2] = {
+            {sink->buffer, sink->used},
+            {(void *)data, length},
+        };
+        int first = sink->used ? 0 : 1;
+        if (!write_all(sink->fd, iov + first, 2 - first)) {
+            sink->failed = 1;
+            return;
+        }
+        sink->used = 0;
+        return;
+    }
+
+    if (!output_flush(sink)) return;
+    memcpy(sink->buffer, data, length);
+    sink->used = length;
+}
+
+void output_puts(output_sink_t *sink, const char *text) {
+    output_write(sink, text, strlen(text));
+}
+
+void output_printf(output_sink_t *sink, const char *format, ...) {
+    if (sink->failed) return;
+
+    va_list args;
+    va_start(args, format);
+    size_t room = sink->capacity - sink->used;
+    int length = vsnprintf(sink->buffer + sink->used, room, format, args);
+    va_end(args);
+
+    if (length < 0) {
+        sink->failed = 1;
+        return;
+    }
+    if ((size_t)length < room) {
+        sink->used += length;
+        return;
+    }
+
+    // Didn't fit; format again into a buffer of the right size
+    char *text = malloc((size_t)length + 1);
+    if (!text) {
+        sink->failed = 1;
+        return;
+    }
+    va_start(args, format);
+    vsnprintf(text, (size_t)length + 1, format, args);
+    va_end(args);
+    output_write(sink, text, (size_t)length);
+    free(text);
+}
+
+// Copy the rest of src to the sink's descriptor with read()/write(),
+// borrowing the (flushed, empty) sink buffer. started says whether part
+// of src has already been written.
+static int copy_with_buffer(output_sink_t *sink, int src, int started) {
+    for (;;) {
+        ssize_t got = read(src, sink->buffer, sink->capacity);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            // A file cut off partway can't be skipped cleanly
+            if (started) sink->failed = 1;
+            return 0;
+        }
+        if (got == 0) return 1;
+        
+        struct iovec iov = {sink->buffer, (size_t)got};
+        if (!write_all(sink->fd, &iov, 1)) {
+            sink->failed = 1;
+            return 0;
+        }
+        started = 1;
+    }
+}
+
+// Append a whole file to the sink without passing it through user space
+// where the kernel allows. Tries copy_file_range (which can share extents
+// on reflink filesystems), then sendfile, then plain read()/write(); each
+// fallback resumes at the source offset the previous one reached.
+// Returns 0 if the source couldn't be opened or read; if it was partly
+// written before a read failed, the sink is marked failed as well.
+int output_splice_file(output_sink_t *sink, const char *path) {
+    if (sink->failed) return 0;
+    
+    if (sink->fd < 0) {
+        mapped_file_t file;
+        if (!map_file(path, &file)) return 0;
+        output_write(sink, file.data, file.length);
+        unmap_file(&file);
+        return 1;
+    }
+    
+    int src = open(path, O_RDONLY | O_CLOEXEC);
+    if (src < 0) return 0;
+    
+    struct stat st;
+    if (fstat(src, &st) != 0 || !S_ISREG(st.st_mode) || !output_flush(sink)) {
+        close(src);
+        return 0;
+    }
+    
+    off_t remaining = st.st_size;
+    
+#ifdef __linux__
+    while (remaining > 0) {
+        ssize_t copied = copy_file_range(src, NULL, sink->fd, NULL, (size_t)remaining, 0);
+        if (copied < 0 && errno == EINTR) continue;
+        if (copied <= 0) break;
+        remaining -= copied;
+    }
+    
+    while (remaining > 0) {
+        ssize_t copied = sendfile(sink->fd, src, NULL, (size_t)remaining);
+        if (copied < 0 && errno == EINTR) continue;
+        if (copied <= 0) break;
+        remaining -= copied;
+    }
+#endif
+    
+    // Also picks up anything appended since fstat
+    int ok = copy_with_buffer(sink, src, remaining < st.st_size);
+    close(src);
+    return ok;
+}
+
+// Discard buffered data and clear any error so the sink can be reused
+void output_reset(output_sink_t *sink) {
+    sink->used = 0;
+    sink->failed = (sink->buffer == NULL);
+}
+
+// Flush, release the buffer and close an owned descriptor.
+// Returns 1 if every byte written through the sink reached the kernel.
+int output_close(output_sink_t *sink) {
+    int ok = output_flush(sink);
+
+    if (sink->close_fd && sink->fd >= 0) {
+        if (close(sink->fd) != 0) ok = 0;
+    }
+    free(sink->buffer);
+    sink->buffer = NULL;
+    sink->fd = -1;
+    sink->used = sink->capacity = 0;
+    return ok && !sink->failed;
+}
@@ -0,0 +1,418 @@
+#include "ciary.h"
+#include <stdarg.h>
+
+// Streaming PDF 1.4 writer on top of an output sink. Text is set in the
+// base-14 fonts with WinAnsi encoding, so no font data is embedded; UTF-8
+// input is mapped to WinAnsi where possible and to '?' otherwise. Each
+// object is written as soon as it is complete and the xref table comes
+// last, so memory use is one page of content plus eight bytes per object.
+
+#define PAGE_WIDTH 595.0   // A4, in points
+#define PAGE_HEIGHT 842.0
+#define MARGIN 56.0
+#define TEXT_WIDTH (PAGE_WIDTH - 2 * MARGIN)
+#define FOOTER_Y 30.0
+#define FOOTER_SIZE 9.0
+#define BLANK_SPACE 7.0    // Vertical gap left by pdf_space
+
+// Fixed object numbers. Page k is FIRST_PAGE_OBJECT + 2k (its content
+// stream) and FIRST_PAGE_OBJECT + 2k + 1 (the page itself).
+#define CATALOG_OBJECT 1
+#define PAGES_OBJECT 2
+#define RESOURCES_OBJECT 3
+#define FONT_OBJECT 4      // One per font, FONT_COUNT of them
+#define INFO_OBJECT 8
+#define FIRST_PAGE_OBJECT 9
+
+enum { FONT_REGULAR, FONT_BOLD, FONT_OBLIQUE, FONT_MONO, FONT_COUNT };
+
+static const char *font_names[FONT_COUNT] = {
+    "Helvetica", "Helvetica-Bold", "Helvetica-Oblique", "Courier"
+};
+
+typedef struct {
+    int font;
+    double size;
+    double leading;       // Baseline to baseline
+    double space_before;
+    double keep;          // Room to leave below the first line (keep with next)
+} text_style_t;
+
+static const text_style_t text_styles[] = {
+    [PDF_STYLE_BODY]    = {FONT_REGULAR, 11.0, 15.0, 0.0, 0.0},
+    [PDF_STYLE_CODE]    = {FONT_MONO, 9.5, 12.0, 0.0, 0.0},
+    [PDF_STYLE_NOTE]    = {FONT_OBLIQUE, 9.0, 13.0, 0.0, 0.0},
+    [PDF_STYLE_TITLE]   = {FONT_BOLD, 20.0, 26.0, 0.0, 0.0},
+    [PDF_STYLE_DAY]     = {FONT_BOLD, 16.0, 22.0, 14.0, 60.0},
+    [PDF_STYLE_TIME]    = {FONT_BOLD, 12.5, 17.0, 8.0, 45.0},
+    [PDF_STYLE_HEADING] = {FONT_BOLD, 11.0, 15.0, 4.0, 30.0},
+};
+
+// Advance widths (1/1000 em) of ' ' .. '~' from the Adobe font metrics.
+// Helvetica-Oblique shares Helvetica's widths; Courier is 600 throughout.
+static const unsigned short helvetica_widths[95] = {
+    278, 278, 355, 556, 556, 889, 667, 191, 333, 333, 389, 584, 278, 333, 278, 278,
+    556, 556, 556, 556, 556, 556, 556, 556, 556, 556, 278, 278, 584, 584, 584, 556,
+    1015, 667, 667, 722, 722, 667, 611, 778, 722, 278, 500, 667, 556, 833, 722, 778,
+    667, 778, 722, 667, 611, 722, 667, 944, 667, 667, 611, 278, 278, 278, 469, 556,
+    333, 556, 556, 500, 556, 556, 278, 556, 556, 222, 222, 500, 222, 833, 556, 556,
+    556, 556, 333, 500, 278, 556, 500, 722, 500, 500, 500, 334, 260, 334, 584
+};
+
+static const unsigned short helvetica_bold_widths[95] = {
+    278, 333, 474, 556, 556, 889, 722, 238, 333, 333, 389, 584, 278, 333, 278, 278,
+    556, 556, 556, 556, 556, 556, 556, 556, 556, 556, 333, 333, 584, 584, 584, 611,
+    975, 722, 722, 722, 722, 667, 611, 778, 722, 278, 556, 722, 611, 833, 722, 778,
+    667, 778, 722, 667, 611, 722, 667, 944, 667, 667, 611, 333, 278, 333, 584, 556,
+    333, 556, 611, 556, 611, 556, 333, 611, 611, 278, 278, 556, 278, 889, 611, 611,
+    611, 611, 389, 556, 333, 611, 556, 778, 556, 556, 500, 389, 280, 389, 584
+};
+
+static double char_width(int font, unsigned char c, double size) {
+    int width;
+    if (font == FONT_MONO) {
+        width = 600;
+    } else if (c < 32 || c > 126) {
+        width = 556;  // Accented letters and punctuation are close to this
+    } else if (font == FONT_BOLD) {
+        width = helvetica_bold_widths[c - 32];
+    } else {
+        width = helvetica_widths[c - 32];
+    }
+    return width * size / 1000.0;
+}
+
+// WinAnsi codes 0x80-0x9F, which differ from Latin-1
+static const struct {
+    unsigned short codepoint;
+    unsigned char code;
+} winansi_extras[] = {
+    {0x20AC, 0x80}, {0x201A, 0x82}, {0x0192, 0x83}, {0x201E, 0x84}, {0x2026, 0x85},
+    {0x2020, 0x86}, {0x2021, 0x87}, {0x02C6, 0x88}, {0x2030, 0x89}, {0x0160, 0x8A},
+    {0x2039, 0x8B}, {0x0152, 0x8C}, {0x017D, 0x8E}, {0x2018, 0x91}, {0x2019, 0x92},
+    {0x201C, 0x93}, {0x201D, 0x94}, {0x2022, 0x95}, {0x2013, 0x96}, {0x2014, 0x97},
+    {0x02DC, 0x98}, {0x2122, 0x99}, {0x0161, 0x9A}, {0x203A, 0x9B}, {0x0153, 0x9C},
+    {0x017E, 0x9E}, {0x0178, 0x9F},
+};
+
+// Decode one UTF-8 character into WinAnsi. Returns the bytes consumed.
+static size_t decode_char(const unsigned char *p, const unsigned char *end, unsigned char *out) {
+    if (*p < 0x80) {
+        *out = *p;
+        return 1;
+    }
+
+    size_t length = (*p >= 0xF0) ? 4 : (*p >= 0xE0) ? 3 : (*p >= 0xC2) ? 2 : 0;
+    if (length == 0 || length > 4 || (size_t)(end - p) < length) {
+        *out = '?';
+        return 1;
+    }
+
+    unsigned int codepoint = *p & (0x7F >> length);
+    for (size_t i = 1; i < length; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            *out = '?';
+            return 1;
+        }
+        codepoint = (codepoint << 6) | (p[i] & 0x3F);
+    }
+
+    *out = '?';
+    if (codepoint >= 0xA0 && codepoint <= 0xFF) {
+        *out = (unsigned char)codepoint;
+    } else {
+        for (size_t i = 0; i < sizeof(winansi_extras) / sizeof(winansi_extras[0]); i++) {
+            if (winansi_extras[i].codepoint == codepoint) {
+                *out = winansi_extras[i].code;
+                break;
+            }
+        }
+    }
+    return length;
+}
+
+// Append a non-negative length in points with two decimals. Done by hand:
+// it runs for every line, and printf would use the locale's decimal point.
+static size_t append_points(char *out, double value) {
+    unsigned long hundredths = (unsigned long)(value * 100.0 + 0.5);
+    char digits[24];
+    size_t count = 0;
+    do {
+        digits[count++] = (char)('0' + hundredths % 10);
+        hundredths /= 10;
+    } while (hundredths > 0 || count < 3);
+
+    size_t used = 0;
+    while (count > 2) out[used++] = digits[--count];
+    out[used++] = '.';
+    out[used++] = digits[1];
+    out[used++] = digits[0];
+    return used;
+}
+
+#define APPEND_LITERAL(out, used, text) \
+    (memcpy((out) + (used), (text), sizeof(text) - 1), (used) += sizeof(text) - 1)
+
+// Escape text for a PDF literal string; out needs room for 2 * length
+static size_t escape_string(char *out, const char *text, size_t length) {
+    size_t used = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] == '(' || text[i] == ')' || text[i] == '\\') {
+            out[used++] = '\\';
+        }
+        out[used++] = text[i];
+    }
+    return used;
+}
+
+static void pdf_write(pdf_writer_t *pdf, const char *data, size_t length) {
+    output_write(pdf->output, data, length);
+    pdf->written += length;
+}
+
+static void pdf_printf(pdf_writer_t *pdf, const char *format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    if (length < 0 || length >= (int)sizeof(buffer)) {
+        pdf->failed = 1;
+        return;
+    }
+    pdf_write(pdf, buffer, (size_t)length);
+}
+
+static void begin_object(pdf_writer_t *pdf, int number) {
+    if (number >= pdf->object_capacity) {
+        int capacity = pdf->object_capacity * 2;
+        while (capacity <= number) capacity *= 2;
+        uint64_t *offsets = realloc(pdf->offsets, capacity * sizeof(uint64_t));
+        if (!offsets) {
+            pdf->failed = 1;
+            return;
+        }
+        pdf->offsets = offsets;
+        pdf->object_capacity = capacity;
+    }
+    pdf->offsets[number] = pdf->written;
+    pdf_printf(pdf, "%d 0 obj\n", number);
+}
+
+static void begin_page(pdf_writer_t *pdf) {
+    output_reset(&pdf->content);
+    pdf->y = PAGE_HEIGHT - MARGIN;
+    pdf->page_open = 1;
+    pdf->after_blank = 1;  // No gap at the top of a page
+}
+
+// Add the page number, then write the page's content stream and page object
+static void end_page(pdf_writer_t *pdf) {
+    char number[16], x[24], y[24];
+    int length = snprintf(number, sizeof(number), "%d", pdf->page_count + 1);
+    double width = 0;
+    for (int i = 0; i < length; i++) {
+        width += char_width(FONT_REGULAR, (unsigned char)number[i], FOOTER_SIZE);
+    }
+    x[append_points(x, (PAGE_WIDTH - width) / 2)] = '\0';
+    y[append_points(y, FOOTER_Y)] = '\0';
+    output_printf(&pdf->content, "BT /F%d 9 Tf %s %s Td (%s) Tj ET\n", FONT_REGULAR + 1, x, y, number);
+    if (pdf->content.failed) pdf->failed = 1;
+
+    int content_object = FIRST_PAGE_OBJECT + 2 * pdf->page_count;
+    begin_object(pdf, content_object);
+    pdf_printf(pdf, "<< /Length %zu >>\nstream\n", pdf->content.used);
+    pdf_write(pdf, pdf->content.buffer, pdf->content.used);
+    pdf_printf(pdf, "\nendstream\nendobj\n");
+
+    begin_object(pdf, content_object + 1);
+    pdf_printf(pdf, "<< /Type /Page /Parent %d 0 R /MediaBox [0 0 595 842] /Resources %d 0 R "
+               "/Contents %d 0 R >>\nendobj\n", PAGES_OBJECT, RESOURCES_OBJECT, content_object);
+
+    pdf->page_count++;
+    pdf->page_open = 0;
+}
+
+// Make sure height points are left on the page, starting a new one if not
+static void ensure_room(pdf_writer_t *pdf, double height) {
+    if (!pdf->page_open) {
+        begin_page(pdf);
+    } else if (pdf->y - height < MARGIN) {
+        end_page(pdf);
+        begin_page(pdf);
+    }
+}
+
+// Set the laid-out line on the page and start an empty one
+static void place_line(pdf_writer_t *pdf, const text_style_t *style) {
+    char text[2 * PDF_LINE_MAX + 96];
+    size_t used = 0;
+
+    ensure_room(pdf, style->leading);
+    while (pdf->line_length > 0 && pdf->line[pdf->line_length - 1] == ' ') {
+        pdf->line_length--;
+    }
+
+    // BT /F<n> <size> Tf <x> <y> Td (<text>) Tj ET
+    APPEND_LITERAL(text, used, "BT /F");
+    text[used++] = (char)('1' + style->font);
+    text[used++] = ' ';
+    used += append_points(text + used, style->size);
+    APPEND_LITERAL(text, used, " Tf ");
+    used += append_points(text + used, MARGIN);
+    text[used++] = ' ';
+    used += append_points(text + used, pdf->y - style->size);
+    APPEND_LITERAL(text, used, " Td (");
+    used += escape_string(text + used, pdf->line, pdf->line_length);
+    APPEND_LITERAL(text, used, ") Tj ET\n");
+    output_write(&pdf->content, text, used);
+
+    pdf->y -= style->leading;
+    pdf->line_length = 0;
+    pdf->line_width = 0;
+    pdf->after_blank = 0;
+}
+
+// Start a PDF document on output. Returns 0 if it couldn't be set up.
+int pdf_open(pdf_writer_t *pdf, output_sink_t *output) {
+    memset(pdf, 0, sizeof(*pdf));
+    pdf->output = output;
+    if (!output_init_memory(&pdf->content)) return 0;
+
+    pdf->object_capacity = 64;
+    pdf->offsets = calloc(pdf->object_capacity, sizeof(uint64_t));
+    if (!pdf->offsets) {
+        output_close(&pdf->content);
+        return 0;
+    }
+
+    // The binary comment marks the file as 8-bit for transfer tools
+    pdf_write(pdf, "%PDF-1.4\n%\xE2\xE3\xCF\xD3\n", 15);
+
+    begin_object(pdf, CATALOG_OBJECT);
+    pdf_printf(pdf, "<< /Type /Catalog /Pages %d 0 R >>\nendobj\n", PAGES_OBJECT);
+
+    begin_object(pdf, RESOURCES_OBJECT);
+    pdf_printf(pdf, "<< /Font << /F1 %d 0 R /F2 %d 0 R /F3 %d 0 R /F4 %d 0 R >> >>\nendobj\n",
+               FONT_OBJECT, FONT_OBJECT + 1, FONT_OBJECT + 2, FONT_OBJECT + 3);
+
+    for (int i = 0; i < FONT_COUNT; i++) {
+        begin_object(pdf, FONT_OBJECT + i);
+        pdf_printf(pdf, "<< /Type /Font /Subtype /Type1 /BaseFont /%s /Encoding /WinAnsiEncoding >>\n"
+                   "endobj\n", font_names[i]);
+    }
+
+    return !pdf->failed;
+}
+
+// Lay out one line of UTF-8 text, wrapping at spaces (or anywhere, for
+// words wider than the page) and breaking pages as needed. Headings are
+// kept on the same page as the start of what follows them.
+void pdf_text(pdf_writer_t *pdf, pdf_style_t style, const char *text, size_t length) {
+    const text_style_t *st = &text_styles[style];
+
+    if (st->space_before > 0 && pdf->page_open && !pdf->after_blank) {
+        pdf->y -= st->space_before;
+    }
+    ensure_room(pdf, st->leading + st->keep);
+
+    const unsigned char *p = (const unsigned char *)text;
+    const unsigned char *end = p + length;
+    size_t word_start = 0;        // Line offset just past its last space
+    double word_start_width = 0;
+    int wrapped = 0;
+    int placed = 0;
+
+    while (p < end) {
+        unsigned char c;
+        p += decode_char(p, end, &c);
+        if (c == '\t') c = ' ';
+        if (c < 32 || c == 127) continue;
+        if (c == ' ' && wrapped && pdf->line_length == 0) continue;  // No indent after a wrap
+
+        double width = char_width(st->font, c, st->size);
+        if (pdf->line_width + width > TEXT_WIDTH || pdf->line_length == PDF_LINE_MAX) {
+            wrapped = 1;
+            placed = 1;
+            if (c == ' ') {
+                place_line(pdf, st);
+                word_start = 0;
+                word_start_width = 0;
+                continue;
+            }
+
+            // Carry the unfinished word over to the next line
+            size_t tail = (word_start > 0) ? pdf->line_length - word_start : 0;
+            double tail_width = (word_start > 0) ? pdf->line_width - word_start_width : 0;
+            pdf->line_length -= tail;
+            place_line(pdf, st);
+            memmove(pdf->line, pdf->line + word_start, tail);
+            pdf->line_length = tail;
+            pdf->line_width = tail_width;
+            word_start = 0;
+            word_start_width = 0;
+        }
+
+        pdf->line[pdf->line_length++] = (char)c;
+        pdf->line_width += width;
+        if (c == ' ') {
+            word_start = pdf->line_length;
+            word_start_width = pdf->line_width;
+        }
+    }
+
+    if (pdf->line_length > 0 || !placed) {
+        place_line(pdf, st);
+    }
+}
+
+// Leave a paragraph gap; repeated calls don't add up
+void pdf_space(pdf_writer_t *pdf) {
+    if (pdf->page_open && !pdf->after_blank) {
+        pdf->y -= BLANK_SPACE;
+        pdf->after_blank = 1;
+    }
+}
+
+// Finish the last page and write the page tree, document info, xref
+// table and trailer. Returns 0 if anything failed along the way.
+int pdf_close(pdf_writer_t *pdf, const char *title) {
+    if (pdf->page_open) {
+        end_page(pdf);
+    } else if (pdf->page_count == 0) {
+        begin_page(pdf);
+        end_page(pdf);
+    }
+
+    begin_object(pdf, PAGES_OBJECT);
+    pdf_printf(pdf, "<< /Type /Pages /Count %d /Kids [", pdf->page_count);
+    for (int i = 0; i < pdf->page_count; i++) {
+        pdf_printf(pdf, "%d 0 R ", FIRST_PAGE_OBJECT + 2 * i + 1);
+    }
+    pdf_printf(pdf, "] >>\nendobj\n");
+
+    char escaped[2 * 128];
+    size_t title_length = strlen(title);
+    if (title_length > 128) title_length = 128;
+    size_t escaped_length = escape_string(escaped, title, title_length);
+    begin_object(pdf, INFO_OBJECT);
+    pdf_printf(pdf, "<< /Producer (Ciary) /Title (");
+    pdf_write(pdf, escaped, escaped_length);
+    pdf_printf(pdf, ") >>\nendobj\n");
+
+    int object_count = FIRST_PAGE_OBJECT + 2 * pdf->page_count;
+    uint64_t xref_offset = pdf->written;
+    pdf_printf(pdf, "xref\n0 %d\n0000000000 65535 f \n", object_count);
+    for (int i = 1; i < object_count && !pdf->failed; i++) {
+        pdf_printf(pdf, "%010llu 00000 n \n", (unsigned long long)pdf->offsets[i]);
+    }
+    pdf_printf(pdf, "trailer\n<< /Size %d /Root %d 0 R /Info %d 0 R >>\nstartxref\n%llu\n%%%%EOF\n",
+               object_count, CATALOG_OBJECT, INFO_OBJECT, (unsigned long long)xref_offset);
+
+    int ok = !pdf->failed && !pdf->output->failed;
+    output_close(&pdf->content);
+    free(pdf->offsets);
+    pdf->offsets = NULL;
+    return ok;
+}
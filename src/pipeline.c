@@ -0,0 +1,187 @@
+#define _GNU_SOURCE
+#include "ciary.h"
+#include <pthread.h>
+
+// Export pipeline: worker threads render day files into per-file memory
+// sinks while the calling thread writes finished files out in list order.
+// Only WINDOW entries past the last one written may be in flight, which
+// bounds memory no matter how far ahead the workers get.
+
+#define PIPELINE_MAX_WORKERS 16
+#define PIPELINE_SLOTS_PER_WORKER 4
+
+typedef struct {
+    output_sink_t sink;
+    int ready;
+} pipeline_slot_t;
+
+typedef struct {
+    const entry_list_t *entries;
+    export_render_fn render;
+    export_written_fn written;
+    void *context;
+    pipeline_slot_t *slots;
+    int window;
+    int next_job;    // Next entry a worker will claim
+    int next_write;  // Next entry the writer will emit
+    pthread_mutex_t lock;
+    pthread_cond_t window_open;  // Workers wait here when the window is full
+    pthread_cond_t slot_ready;   // The writer waits here for the next entry
+} pipeline_t;
+
+static int configured_workers = 0;  // 0 = one per online CPU
+
+// Set the number of export worker threads; 0 restores the default
+void export_set_worker_count(int count) {
+    configured_workers = (count < 0) ? 0 : count;
+}
+
+int export_worker_count(void) {
+    int count = configured_workers;
+    if (count == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        count = (cpus > 0) ? (int)cpus : 1;
+    }
+    return (count > PIPELINE_MAX_WORKERS) ? PIPELINE_MAX_WORKERS : count;
+}
+
+static void* pipeline_worker(void *arg) {
+    pipeline_t *pipeline = arg;
+
+    pthread_mutex_lock(&pipeline->lock);
+    for (;;) {
+        while (pipeline->next_job < pipeline->entries->count &&
+               pipeline->next_job >= pipeline->next_write + pipeline->window) {
+            pthread_cond_wait(&pipeline->window_open, &pipeline->lock);
+        }
+        if (pipeline->next_job >= pipeline->entries->count) break;
+
+        int index = pipeline->next_job++;
+        pipeline_slot_t *slot = &pipeline->slots[index % pipeline->window];
+        pthread_mutex_unlock(&pipeline->lock);
+
+        pipeline->render(&slot->sink, &pipeline->entries->items[index], index, pipeline->context);
+
+        pthread_mutex_lock(&pipeline->lock);
+        slot->ready = 1;
+        pthread_cond_broadcast(&pipeline->slot_ready);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+    return NULL;
+}
+
+// Render and write entries one at a time on the calling thread
+static int run_sequential(const entry_list_t *entries, export_render_fn render,
+                          export_written_fn written, void *context, output_sink_t *output,
+                          const char *progress_message) {
+    output_sink_t buffer;
+    if (!output_init_memory(&buffer)) return 0;
+
+    int ok = 1;
+    for (int i = 0; i < entries->count; i++) {
+        show_progress_bar(progress_message, i + 1, entries->count);
+
+        output_reset(&buffer);
+        render(&buffer, &entries->items[i], i, context);
+        if (buffer.failed) ok = 0;
+        if (output) output_write(output, buffer.buffer, buffer.used);
+        if (written && !buffer.failed) {
+            written(&entries->items[i], i, buffer.buffer, buffer.used, context);
+        }
+    }
+
+    output_close(&buffer);
+    return ok && !(output && output->failed);
+}
+
+// Render every entry with the worker pool and append the results to output
+// in list order. Progress and the optional written callback run on the
+// calling thread only, so it is safe to call from the curses UI. With a
+// NULL output the written callback does the writing itself. Returns 0 if
+// any write or allocation failed.
+int run_export_pipeline(const entry_list_t *entries, export_render_fn render,
+                        export_written_fn written, void *context, output_sink_t *output,
+                        const char *progress_message) {
+    int workers = export_worker_count();
+    if (workers > entries->count) workers = entries->count;
+    if (workers <= 1) {
+        return run_sequential(entries, render, written, context, output, progress_message);
+    }
+
+    pipeline_t pipeline;
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.entries = entries;
+    pipeline.render = render;
+    pipeline.written = written;
+    pipeline.context = context;
+    pipeline.window = workers * PIPELINE_SLOTS_PER_WORKER;
+
+    pipeline.slots = calloc(pipeline.window, sizeof(pipeline_slot_t));
+    if (!pipeline.slots) return 0;
+    for (int i = 0; i < pipeline.window; i++) {
+        if (!output_init_memory(&pipeline.slots[i].sink)) {
+            for (int j = 0; j <= i; j++) output_close(&pipeline.slots[j].sink);
+            free(pipeline.slots);
+            return 0;
+        }
+    }
+
+    pthread_mutex_init(&pipeline.lock, NULL);
+    pthread_cond_init(&pipeline.window_open, NULL);
+    pthread_cond_init(&pipeline.slot_ready, NULL);
+
+    // Resolve the scanner and escape kernels before any worker uses them
+    header_kernel_name();
+    html_escape_kernel_name();
+
+    pthread_t threads[PIPELINE_MAX_WORKERS];
+    int started = 0;
+    while (started < workers &&
+           pthread_create(&threads[started], NULL, pipeline_worker, &pipeline) == 0) {
+        started++;
+    }
+
+    int ok = 1;
+    if (started == 0) {
+        ok = run_sequential(entries, render, written, context, output, progress_message);
+    } else {
+        for (int i = 0; i < entries->count; i++) {
+            pipeline_slot_t *slot = &pipeline.slots[i % pipeline.window];
+
+            pthread_mutex_lock(&pipeline.lock);
+            while (!slot->ready) {
+                pthread_cond_wait(&pipeline.slot_ready, &pipeline.lock);
+            }
+            pthread_mutex_unlock(&pipeline.lock);
+
+            if (slot->sink.failed) ok = 0;
+            if (output) output_write(output, slot->sink.buffer, slot->sink.used);
+            if (written && !slot->sink.failed) {
+                written(&entries->items[i], i, slot->sink.buffer, slot->sink.used, context);
+            }
+            output_reset(&slot->sink);
+
+            pthread_mutex_lock(&pipeline.lock);
+            slot->ready = 0;
+            pipeline.next_write++;
+            pthread_cond_broadcast(&pipeline.window_open);
+            pthread_mutex_unlock(&pipeline.lock);
+
+            show_progress_bar(progress_message, i + 1, entries->count);
+        }
+    }
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pipeline.slot_ready);
+    pthread_cond_destroy(&pipeline.window_open);
+    pthread_mutex_destroy(&pipeline.lock);
+    for (int i = 0; i < pipeline.window; i++) {
+        output_close(&pipeline.slots[i].sink);
+    }
+    free(pipeline.slots);
+
+    return ok && !(output && output->failed);
+}
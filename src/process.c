@@ -0,0 +1,80 @@
+#define _GNU_SOURCE
+#include "ciary.h"
+#include <spawn.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+// Run a program with an explicit argv and wait for it to finish. No shell
+// is involved, so paths are passed through untouched. Like system(), the
+// parent ignores SIGINT/SIGQUIT while the child runs and the child gets
+// the default dispositions back.
+// Returns the child's exit status, or -1 if it couldn't be run or was killed.
+int spawn_and_wait(char *const argv[]) {
+    posix_spawnattr_t attr;
+    struct sigaction ignore, old_int, old_quit;
+    sigset_t defaults;
+    pid_t pid;
+    int status;
+    
+    if (!argv || !argv[0]) return -1;
+    
+    posix_spawnattr_init(&attr);
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGINT);
+    sigaddset(&defaults, SIGQUIT);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF);
+    
+    memset(&ignore, 0, sizeof(ignore));
+    ignore.sa_handler = SIG_IGN;
+    sigemptyset(&ignore.sa_mask);
+    sigaction(SIGINT, &ignore, &old_int);
+    sigaction(SIGQUIT, &ignore, &old_quit);
+    
+    int spawn_result = posix_spawnp(&pid, argv[0], NULL, &attr, argv, environ);
+    
+    posix_spawnattr_destroy(&attr);
+    
+    int result = -1;
+    if (spawn_result == 0) {
+        while (waitpid(pid, &status, 0) == -1) {
+            if (errno != EINTR) {
+                status = -1;
+                break;
+            }
+        }
+        if (status != -1 && WIFEXITED(status)) {
+            result = WEXITSTATUS(status);
+        }
+    }
+    
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGQUIT, &old_quit, NULL);
+    
+    return result;
+}
+
+// Hand the terminal to a program (editor, pager) and take it back afterwards
+int spawn_in_terminal(char *const argv[], int flags) {
+    // Temporarily restore terminal settings
+    endwin();
+    
+    int result = spawn_and_wait(argv);
+    
+    if (flags & SPAWN_PAUSE) {
+        printf("\nPress Enter to continue...");
+        fflush(stdout);
+        getchar();
+    }
+    
+    // Reinitialize ncurses
+    initscr();
+    cbreak();
+    noecho();
+    keypad(stdscr, TRUE);
+    curs_set(1);
+    
+    return result;
+}
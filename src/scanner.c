@@ -0,0 +1,387 @@
+#define _GNU_SOURCE
+#include "ciary.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#ifdef CIARY_X86_SIMD
+#include <immintrin.h>
+#endif
+
+// Files smaller than this are read() into memory; mapping them costs more
+// than copying a few pages.
+#define MMAP_THRESHOLD (16 * 1024)
+
+// Map a whole file read-only. Small files fall back to a heap buffer.
+// Returns 1 on success; an empty file succeeds with length 0.
+int map_file(const char *path, mapped_file_t *file) {
+    memset(file, 0, sizeof(*file));
+    
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return 0;
+    }
+    
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        close(fd);
+        return 1;
+    }
+    
+    if (size >= MMAP_THRESHOLD) {
+        void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            close(fd);
+            file->data = data;
+            file->length = size;
+            file->mapped = 1;
+            return 1;
+        }
+        // Fall through to read() if the mapping failed
+    }
+    
+    char *buffer = malloc(size);
+    if (!buffer) {
+        close(fd);
+        return 0;
+    }
+    
+    size_t length = 0;
+    while (length < size) {
+        ssize_t n = read(fd, buffer + length, size - length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        length += (size_t)n;
+    }
+    close(fd);
+    
+    file->data = buffer;
+    file->length = length;
+    file->mapped = 0;
+    return 1;
+}
+
+void unmap_file(mapped_file_t *file) {
+    if (file->data) {
+        if (file->mapped) {
+            munmap((void *)file->data, file->length);
+        } else {
+            free((void *)file->data);
+        }
+    }
+    memset(file, 0, sizeof(*file));
+}
+
+static int is_section_header(const char *line, const char *end) {
+    return end - line >= 3 && line[0] == '#' && line[1] == '#' && line[2] == ' ';
+}
+
+static int is_date_header(const char *line, const char *end) {
+    return end - line >= 2 && line[0] == '#' && line[1] == ' ';
+}
+
+// Parse "HH:MM:SS" (or "HH:MM") after "## "; fields stay -1 otherwise
+static void parse_section_time(const char *text, const char *end, entry_section_t *section) {
+    int fields[3] = {-1, -1, 0};
+    int parsed = 0;
+    const char *p = text;
+    
+    while (parsed < 3 && end - p >= 2 && p[0] >= '0' && p[0] <= '9' && p[1] >= '0' && p[1] <= '9') {
+        fields[parsed++] = (p[0] - '0') * 10 + (p[1] - '0');
+        p += 2;
+        if (parsed < 3 && p < end && *p == ':') {
+            p++;
+        } else {
+            break;
+        }
+    }
+    
+    if (parsed >= 2 && fields[0] <= 23 && fields[1] <= 59 && fields[2] <= 59) {
+        section->hour = fields[0];
+        section->minute = fields[1];
+        section->second = fields[2];
+    } else {
+        section->hour = section->minute = section->second = -1;
+    }
+}
+
+// Header search kernels. Each returns the first '\n' in [p, end - 1) that
+// is followed by '#', or NULL. Headers are rare, so nearly every block is
+// rejected by a compare + movemask and the scan runs at memory bandwidth.
+typedef const char* (*newline_hash_fn)(const char *p, const char *end);
+
+static const char* find_newline_hash_scalar(const char *p, const char *end) {
+    while (end - p >= 2) {
+        const char *newline = memchr(p, '\n', (end - 1) - p);
+        if (!newline) return NULL;
+        if (newline[1] == '#') return newline;
+        p = newline + 1;
+    }
+    return NULL;
+}
+
+#ifdef CIARY_X86_SIMD
+__attribute__((target("sse2")))
+static const char* find_newline_hash_sse2(const char *p, const char *end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i hash = _mm_set1_epi8('#');
+    
+    // Compare each block with itself shifted by one byte, so a match needs
+    // '\n' at i and '#' at i + 1
+    while (end - p >= 17) {
+        __m128i current = _mm_loadu_si128((const __m128i *)p);
+        __m128i next = _mm_loadu_si128((const __m128i *)(p + 1));
+        int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(current, newline),
+                                                   _mm_cmpeq_epi8(next, hash)));
+        if (mask) {
+            return p + __builtin_ctz((unsigned int)mask);
+        }
+        p += 16;
+    }
+    return find_newline_hash_scalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* find_newline_hash_avx2(const char *p, const char *end) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i hash = _mm256_set1_epi8('#');
+    
+    while (end - p >= 33) {
+        __m256i current = _mm256_loadu_si256((const __m256i *)p);
+        __m256i next = _mm256_loadu_si256((const __m256i *)(p + 1));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(current, newline), _mm256_cmpeq_epi8(next, hash)));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return find_newline_hash_sse2(p, end);
+}
+#endif
+
+typedef struct {
+    const char *name;
+    newline_hash_fn fn;
+} header_kernel_t;
+
+static const header_kernel_t header_kernels[] = {
+#ifdef CIARY_X86_SIMD
+    {"avx2", find_newline_hash_avx2},
+    {"sse2", find_newline_hash_sse2},
+#endif
+    {"scalar", find_newline_hash_scalar},
+    {NULL, NULL}
+};
+
+static const header_kernel_t *active_kernel = NULL;
+
+// Pick the widest kernel this CPU supports (first call only)
+static const header_kernel_t* get_header_kernel(void) {
+    if (!active_kernel) {
+        for (const header_kernel_t *kernel = header_kernels; kernel->name; kernel++) {
+            if (cpu_supports_kernel(kernel->name)) {
+                active_kernel = kernel;
+                break;
+            }
+        }
+    }
+    return active_kernel;
+}
+
+const char* header_kernel_name(void) {
+    return get_header_kernel()->name;
+}
+
+// Force a specific kernel (for tests and benchmarks). Returns 0 if this
+// build or CPU doesn't support it.
+int select_header_kernel(const char *name) {
+    for (const header_kernel_t *kernel = header_kernels; kernel->name; kernel++) {
+        if (strcmp(kernel->name, name) == 0 && cpu_supports_kernel(kernel->name)) {
+            active_kernel = kernel;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Find the next "# " or "## " header line starting at or after from.
+// Returns the start of the header line and sets kind, or returns end with
+// kind set to HEADER_NONE.
+const char* find_next_header(const char *data, const char *from, const char *end, int *kind) {
+    newline_hash_fn find = get_header_kernel()->fn;
+    const char *p = from;
+    
+    // A header on the very first line has no newline before it
+    if (p == data || (p > data && p[-1] == '\n')) {
+        if (p < end && *p == '#') {
+            const char *line_end = memchr(p, '\n', end - p);
+            if (!line_end) line_end = end;
+            if (is_section_header(p, line_end)) { *kind = HEADER_SECTION; return p; }
+            if (is_date_header(p, line_end)) { *kind = HEADER_DATE; return p; }
+        }
+    }
+    
+    while (p < end) {
+        const char *newline = find(p, end);
+        if (!newline) break;
+        
+        const char *line = newline + 1;
+        const char *line_end = memchr(line, '\n', end - line);
+        if (!line_end) line_end = end;
+        
+        if (is_section_header(line, line_end)) { *kind = HEADER_SECTION; return line; }
+        if (is_date_header(line, line_end)) { *kind = HEADER_DATE; return line; }
+        
+        // "#tag", "### ..." and the like aren't boundaries
+        p = line;
+    }
+    
+    *kind = HEADER_NONE;
+    return end;
+}
+
+// Flip *in_fence for every ``` fence line in [from, to), where from is
+// the start of a line
+static void track_fences(const char *data, const char *from, const char *to, int *in_fence) {
+    const char *p = from;
+    while (p < to) {
+        const char *tick = memchr(p, '`', to - p);
+        if (!tick) break;
+        if ((tick == data || tick[-1] == '\n') && to - tick >= 3 && tick[1] == '`' && tick[2] == '`') {
+            *in_fence = !*in_fence;
+        }
+        p = tick + 1;
+    }
+}
+
+// find_next_header that treats header lines inside ``` fenced code as
+// content, not boundaries. Everything that splits a day into sections
+// goes through here, so they all agree. *in_fence carries the fence state from one
+// call to the next and starts out 0.
+const char* find_next_unfenced_header(const char *data, const char *from, const char *end, int *kind,
+                                      int *in_fence) {
+    const char *p = from;
+    while (1) {
+        const char *header = find_next_header(data, p, end, kind);
+        track_fences(data, p, header, in_fence);
+        if (*kind == HEADER_NONE || !*in_fence) return header;
+        
+        const char *line_end = memchr(header, '\n', end - header);
+        if (!line_end) break;
+        p = line_end + 1;
+    }
+    *kind = HEADER_NONE;
+    return end;
+}
+
+// Find every "## " time section in a day file's contents. Header lines
+// are located with the SIMD kernel, so line length doesn't matter.
+int scan_sections(const char *data, size_t length, section_list_t *list) {
+    list->count = 0;
+    
+    const char *p = data;
+    const char *end = data + length;
+    int in_fence = 0;
+    while (p < end) {
+        int kind;
+        const char *header = find_next_unfenced_header(data, p, end, &kind, &in_fence);
+        if (kind == HEADER_NONE) break;
+        
+        const char *line_end = memchr(header, '\n', end - header);
+        if (!line_end) line_end = end;
+        
+        if (kind == HEADER_SECTION) {
+            if (list->count == list->capacity) {
+                int capacity = list->capacity ? list->capacity * 2 : 8;
+                entry_section_t *grown = realloc(list->sections, capacity * sizeof(entry_section_t));
+                if (!grown) return 0;
+                list->sections = grown;
+                list->capacity = capacity;
+            }
+            
+            entry_section_t *section = &list->sections[list->count];
+            section->offset = (size_t)(header - data);
+            parse_section_time(header + 3, line_end, section);
+            
+            // The previous section runs up to this header
+            if (list->count > 0) {
+                entry_section_t *previous = &list->sections[list->count - 1];
+                previous->length = section->offset - previous->offset;
+            }
+            list->count++;
+        }
+        
+        p = line_end;
+    }
+    
+    if (list->count > 0) {
+        entry_section_t *last = &list->sections[list->count - 1];
+        last->length = length - last->offset;
+    }
+    
+    return 1;
+}
+
+int scan_entry_file(const char *path, section_list_t *list) {
+    mapped_file_t file;
+    if (!map_file(path, &file)) {
+        list->count = 0;
+        return 0;
+    }
+    
+    int result = scan_sections(file.data, file.length, list);
+    unmap_file(&file);
+    return result;
+}
+
+void free_section_list(section_list_t *list) {
+    free(list->sections);
+    memset(list, 0, sizeof(*list));
+}
+
+// Count "## " headers without building a section list
+int count_sections(const char *data, size_t length) {
+    int count = 0;
+    const char *p = data;
+    const char *end = data + length;
+    int in_fence = 0;
+    
+    while (p < end) {
+        int kind;
+        const char *header = find_next_unfenced_header(data, p, end, &kind, &in_fence);
+        if (kind == HEADER_NONE) break;
+        if (kind == HEADER_SECTION) count++;
+        p = header + 1;
+    }
+    
+    return count;
+}
+
+// Count whitespace-separated words, skipping date and time headers
+int count_words(const char *data, size_t length) {
+    int count = 0;
+    const char *p = data;
+    const char *end = data + length;
+    
+    while (p < end) {
+        const char *newline = memchr(p, '\n', end - p);
+        const char *line_end = newline ? newline : end;
+        
+        if (!is_section_header(p, line_end) && !is_date_header(p, line_end)) {
+            int in_word = 0;
+            for (const char *c = p; c < line_end; c++) {
+                int is_space = (*c == ' ' || *c == '\t' || *c == '\r');
+                if (!is_space && !in_word) count++;
+                in_word = !is_space;
+            }
+        }
+        
+        p = line_end + 1;
+    }
+    
+    return count;
+}
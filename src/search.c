@@ -0,0 +1,859 @@
+#define _GNU_SOURCE
+#include "ciary.h"
+#include <math.h>
+#include <stdint.h>
+
+// On-disk layout of .ciary-search (host byte order; a foreign or corrupt
+// file is simply rebuilt):
+//   header:  search_file_header_t
+//   arrays:  days, sections, terms, postings, then the term text; each
+//            array starts 8-byte aligned
+// The index follows the journal index: a day whose mtime and size still
+// match keeps its sections and postings, anything else is reparsed.
+#define SEARCH_MAGIC "CSRC"
+#define SEARCH_VERSION 2
+#define SEARCH_MAX_COUNT (1u << 30)
+#define SEARCH_QUERY_TERMS 16
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t day_count;
+    uint32_t section_count;
+    uint32_t term_count;
+    uint32_t reserved;
+    uint64_t posting_count;
+    uint64_t strings_length;
+} search_file_header_t;
+
+void search_index_init(search_index_t *index) {
+    memset(index, 0, sizeof(*index));
+}
+
+void search_index_free(search_index_t *index) {
+    free(index->days);
+    free(index->sections);
+    free(index->terms);
+    free(index->postings);
+    free(index->strings);
+    search_index_init(index);
+}
+
+static char* get_search_path(char *path, const config_t *config) {
+    int result = snprintf(path, MAX_PATH_SIZE, "%s/%s", config->journal_directory, SEARCH_INDEX_FILE);
+    return (result < MAX_PATH_SIZE) ? path : NULL;
+}
+
+static size_t align8(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+// Tokens are runs of ASCII letters and digits plus any non-ASCII byte,
+// so UTF-8 words stay whole; ASCII is folded to lower case
+static int is_token_byte(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+// Read the next token from [*p, end) into token, which has room for
+// SEARCH_TOKEN_MAX bytes and a NUL. Returns its length, or 0 once the
+// text is used up. Longer words are cut short, the same way for indexing
+// and for queries.
+size_t search_next_token(const char **p, const char *end, char *token) {
+    const char *s = *p;
+    while (s < end && !is_token_byte((unsigned char)*s)) s++;
+
+    size_t length = 0;
+    while (s < end && is_token_byte((unsigned char)*s)) {
+        if (length < SEARCH_TOKEN_MAX) {
+            char c = *s;
+            token[length++] = (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+        }
+        s++;
+    }
+    token[length] = '\0';
+    *p = s;
+    return length;
+}
+
+// Order of the term table: bytewise, shorter first on a common prefix
+static int compare_text(const char *a, size_t a_length, const char *b, size_t b_length) {
+    int result = memcmp(a, b, a_length < b_length ? a_length : b_length);
+    if (result != 0) return result;
+    return (a_length > b_length) - (a_length < b_length);
+}
+
+static int day_key(const search_day_t *day) {
+    return date_to_days((date_t){day->year, day->month, day->day});
+}
+
+static void count_tokens(search_index_t *index) {
+    index->token_total = 0;
+    for (int i = 0; i < index->section_count; i++) {
+        index->token_total += index->sections[i].token_count;
+    }
+}
+
+// Load
+static int copy_array(void **array, const mapped_file_t *file, size_t *offset, size_t size) {
+    if (*offset > file->length || size > file->length - *offset) return 0;
+    *array = malloc(size > 0 ? size : 1);
+    if (!*array) return 0;
+    memcpy(*array, file->data + *offset, size);
+    *offset = align8(*offset + size);
+    return 1;
+}
+
+// Check every cross-reference so a damaged file can't send a query out
+// of bounds
+static int validate_index(const search_index_t *index) {
+    uint32_t next_section = 0;
+    for (int i = 0; i < index->day_count; i++) {
+        const search_day_t *day = &index->days[i];
+        if (day->first_section != next_section ||
+            day->section_count > (uint32_t)index->section_count - next_section) {
+            return 0;
+        }
+        next_section += day->section_count;
+        if (i > 0 && day_key(day) <= day_key(&index->days[i - 1])) return 0;
+    }
+    if (next_section != (uint32_t)index->section_count) return 0;
+
+    for (int i = 0; i < index->section_count; i++) {
+        if (index->sections[i].day >= (uint32_t)index->day_count) return 0;
+    }
+
+    for (int i = 0; i < index->term_count; i++) {
+        const search_term_t *term = &index->terms[i];
+        if (term->text > index->strings_length || term->length > index->strings_length - term->text ||
+            term->first_posting > index->posting_count ||
+            term->posting_count > index->posting_count - term->first_posting) {
+            return 0;
+        }
+    }
+
+    for (size_t i = 0; i < index->posting_count; i++) {
+        if (index->postings[i].section >= (uint32_t)index->section_count) return 0;
+    }
+    return 1;
+}
+
+int search_index_load(search_index_t *index, const config_t *config) {
+    char path[MAX_PATH_SIZE];
+
+    search_index_free(index);
+    if (!get_search_path(path, config)) return 0;
+
+    mapped_file_t file;
+    if (!map_file(path, &file)) return 0;  // No index yet
+
+    search_file_header_t header;
+    if (file.length < sizeof(header)) {
+        unmap_file(&file);
+        return 0;
+    }
+    memcpy(&header, file.data, sizeof(header));
+    if (memcmp(header.magic, SEARCH_MAGIC, 4) != 0 || header.version != SEARCH_VERSION ||
+        header.day_count > SEARCH_MAX_COUNT || header.section_count > SEARCH_MAX_COUNT ||
+        header.term_count > SEARCH_MAX_COUNT || header.posting_count > SEARCH_MAX_COUNT ||
+        header.strings_length > UINT32_MAX) {
+        unmap_file(&file);
+        return 0;
+    }
+
+    size_t offset = align8(sizeof(header));
+    int ok = copy_array((void **)&index->days, &file, &offset, header.day_count * sizeof(search_day_t)) &&
+             copy_array((void **)&index->sections, &file, &offset,
+                        header.section_count * sizeof(search_section_t)) &&
+             copy_array((void **)&index->terms, &file, &offset, header.term_count * sizeof(search_term_t)) &&
+             copy_array((void **)&index->postings, &file, &offset,
+                        header.posting_count * sizeof(search_posting_t)) &&
+             copy_array((void **)&index->strings, &file, &offset, header.strings_length);
+    unmap_file(&file);
+
+    index->day_count = (int)header.day_count;
+    index->section_count = (int)header.section_count;
+    index->term_count = (int)header.term_count;
+    index->posting_count = (size_t)header.posting_count;
+    index->strings_length = (size_t)header.strings_length;
+    if (!ok || !validate_index(index)) {
+        search_index_free(index);
+        return 0;
+    }
+
+    count_tokens(index);
+    index->dirty = 0;
+    return 1;
+}
+
+static void write_array(output_sink_t *output, const void *array, size_t size) {
+    static const char padding[8];
+    output_write(output, array, size);
+    output_write(output, padding, align8(size) - size);
+}
+
+int search_index_save(search_index_t *index, const config_t *config) {
+    char path[MAX_PATH_SIZE];
+    char temp_path[MAX_PATH_SIZE];
+
+    if (!index->dirty) return 1;
+    if (!get_search_path(path, config)) return 0;
+    if (snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= (int)sizeof(temp_path)) return 0;
+
+    output_sink_t output;
+    if (!output_open(&output, temp_path)) return 0;
+
+    search_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SEARCH_MAGIC, 4);
+    header.version = SEARCH_VERSION;
+    header.day_count = (uint32_t)index->day_count;
+    header.section_count = (uint32_t)index->section_count;
+    header.term_count = (uint32_t)index->term_count;
+    header.posting_count = (uint64_t)index->posting_count;
+    header.strings_length = (uint64_t)index->strings_length;
+
+    write_array(&output, &header, sizeof(header));
+    write_array(&output, index->days, index->day_count * sizeof(search_day_t));
+    write_array(&output, index->sections, index->section_count * sizeof(search_section_t));
+    write_array(&output, index->terms, index->term_count * sizeof(search_term_t));
+    write_array(&output, index->postings, index->posting_count * sizeof(search_posting_t));
+    write_array(&output, index->strings, index->strings_length);
+
+    // Replace the old index atomically so readers never see a partial file
+    if (!output_close(&output) || rename(temp_path, path) != 0) {
+        unlink(temp_path);
+        return 0;
+    }
+
+    index->dirty = 0;
+    return 1;
+}
+
+// Update
+
+// A posting before it has been placed under its term
+typedef struct {
+    uint32_t term;
+    uint32_t section;
+    uint32_t frequency;
+} search_triple_t;
+
+// Collects terms and postings for a rebuilt index. Terms are interned
+// through an open-addressing hash table; postings arrive in any order
+// and are sorted into place by search_builder_finish.
+typedef struct {
+    search_term_t *terms;    // posting_count counts triples while building
+    uint32_t *last_triple;   // Per term: its most recent triple
+    int term_count;
+    int term_capacity;
+    char *strings;
+    size_t strings_length;
+    size_t strings_capacity;
+    uint32_t *slots;         // Term id + 1; 0 is an empty slot
+    size_t slot_mask;
+    search_triple_t *triples;
+    size_t triple_count;
+    size_t triple_capacity;
+    int failed;
+} search_builder_t;
+
+static uint32_t hash_text(const char *text, size_t length) {
+    uint32_t hash = 2166136261u;  // FNV-1a
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static int builder_init(search_builder_t *builder) {
+    memset(builder, 0, sizeof(*builder));
+    builder->slot_mask = 1023;
+    builder->slots = calloc(builder->slot_mask + 1, sizeof(uint32_t));
+    return builder->slots != NULL;
+}
+
+static void builder_free(search_builder_t *builder) {
+    free(builder->terms);
+    free(builder->last_triple);
+    free(builder->strings);
+    free(builder->slots);
+    free(builder->triples);
+    memset(builder, 0, sizeof(*builder));
+}
+
+static int builder_grow_slots(search_builder_t *builder) {
+    size_t mask = builder->slot_mask * 2 + 1;
+    uint32_t *slots = calloc(mask + 1, sizeof(uint32_t));
+    if (!slots) return 0;
+
+    for (int id = 0; id < builder->term_count; id++) {
+        const search_term_t *term = &builder->terms[id];
+        size_t slot = hash_text(builder->strings + term->text, term->length) & mask;
+        while (slots[slot]) slot = (slot + 1) & mask;
+        slots[slot] = (uint32_t)id + 1;
+    }
+    free(builder->slots);
+    builder->slots = slots;
+    builder->slot_mask = mask;
+    return 1;
+}
+
+// Id of a term, added if it's new; -1 if memory ran out
+static int builder_intern(search_builder_t *builder, const char *text, size_t length) {
+    if (builder->failed) return -1;
+    if ((size_t)(builder->term_count + 1) * 2 > builder->slot_mask + 1 && !builder_grow_slots(builder)) {
+        builder->failed = 1;
+        return -1;
+    }
+
+    size_t slot = hash_text(text, length) & builder->slot_mask;
+    while (builder->slots[slot]) {
+        const search_term_t *term = &builder->terms[builder->slots[slot] - 1];
+        if (term->length == length && memcmp(builder->strings + term->text, text, length) == 0) {
+            return (int)builder->slots[slot] - 1;
+        }
+        slot = (slot + 1) & builder->slot_mask;
+    }
+
+    if (builder->term_count == builder->term_capacity) {
+        int capacity = builder->term_capacity ? builder->term_capacity * 2 : 1024;
+        search_term_t *terms = realloc(builder->terms, capacity * sizeof(search_term_t));
+        if (terms) builder->terms = terms;
+        uint32_t *last = realloc(builder->last_triple, capacity * sizeof(uint32_t));
+        if (last) builder->last_triple = last;
+        if (!terms || !last) {
+            builder->failed = 1;
+            return -1;
+        }
+        builder->term_capacity = capacity;
+    }
+    if (builder->strings_capacity - builder->strings_length < length) {
+        size_t capacity = builder->strings_capacity ? builder->strings_capacity * 2 : 16384;
+        while (capacity - builder->strings_length < length) capacity *= 2;
+        char *strings = realloc(builder->strings, capacity);
+        if (!strings) {
+            builder->failed = 1;
+            return -1;
+        }
+        builder->strings = strings;
+        builder->strings_capacity = capacity;
+    }
+
+    int id = builder->term_count++;
+    search_term_t *term = &builder->terms[id];
+    memset(term, 0, sizeof(*term));
+    term->text = (uint32_t)builder->strings_length;
+    term->length = (uint32_t)length;
+    memcpy(builder->strings + builder->strings_length, text, length);
+    builder->strings_length += length;
+    builder->slots[slot] = (uint32_t)id + 1;
+    return id;
+}
+
+static void builder_push(search_builder_t *builder, int term, uint32_t section, uint32_t frequency) {
+    if (builder->triple_count == builder->triple_capacity) {
+        size_t capacity = builder->triple_capacity ? builder->triple_capacity * 2 : 65536;
+        search_triple_t *triples = realloc(builder->triples, capacity * sizeof(search_triple_t));
+        if (!triples) {
+            builder->failed = 1;
+            return;
+        }
+        builder->triples = triples;
+        builder->triple_capacity = capacity;
+    }
+    builder->last_triple[term] = (uint32_t)builder->triple_count;
+    builder->triples[builder->triple_count++] = (search_triple_t){(uint32_t)term, section, frequency};
+    builder->terms[term].posting_count++;
+}
+
+// Count one occurrence of a token in section. Sections are tokenized one
+// at a time, so a repeat always hits the term's most recent triple.
+static void builder_add(search_builder_t *builder, const char *text, size_t length, uint32_t section) {
+    int term = builder_intern(builder, text, length);
+    if (term < 0) return;
+
+    if (builder->terms[term].posting_count > 0) {
+        search_triple_t *last = &builder->triples[builder->last_triple[term]];
+        if (last->section == section) {
+            last->frequency++;
+            return;
+        }
+    }
+    builder_push(builder, term, section, 1);
+}
+
+typedef struct {
+    const char *text;
+    uint32_t length;
+    uint32_t id;
+} term_key_t;
+
+static int compare_term_keys(const void *a, const void *b) {
+    const term_key_t *x = a;
+    const term_key_t *y = b;
+    return compare_text(x->text, x->length, y->text, y->length);
+}
+
+// Sort the terms and lay the postings out term by term, each term's in
+// section order: two stable counting sorts, by section then by term
+static int builder_finish(search_builder_t *builder, int section_count, search_index_t *index) {
+    if (builder->failed) return 0;
+
+    int term_count = 0;
+    term_key_t *keys = malloc((builder->term_count > 0 ? builder->term_count : 1) * sizeof(term_key_t));
+    uint32_t *rank = malloc((builder->term_count > 0 ? builder->term_count : 1) * sizeof(uint32_t));
+    search_triple_t *by_section = malloc((builder->triple_count > 0 ? builder->triple_count : 1) *
+                                         sizeof(search_triple_t));
+    uint32_t *counts = calloc((size_t)(section_count > builder->term_count ? section_count : builder->term_count) + 1,
+                              sizeof(uint32_t));
+    search_term_t *terms = NULL;
+    search_posting_t *postings = malloc((builder->triple_count > 0 ? builder->triple_count : 1) *
+                                        sizeof(search_posting_t));
+    char *strings = malloc(builder->strings_length > 0 ? builder->strings_length : 1);
+    if (!keys || !rank || !by_section || !counts || !postings || !strings) goto fail;
+
+    // Terms whose every day went away have no postings left; drop them
+    for (int id = 0; id < builder->term_count; id++) {
+        const search_term_t *term = &builder->terms[id];
+        if (term->posting_count == 0) continue;
+        keys[term_count++] = (term_key_t){builder->strings + term->text, term->length, (uint32_t)id};
+    }
+    qsort(keys, term_count, sizeof(term_key_t), compare_term_keys);
+
+    terms = malloc((term_count > 0 ? term_count : 1) * sizeof(search_term_t));
+    if (!terms) goto fail;
+    size_t strings_length = 0;
+    for (int i = 0; i < term_count; i++) {
+        rank[keys[i].id] = (uint32_t)i;
+        terms[i].text = (uint32_t)strings_length;
+        terms[i].length = keys[i].length;
+        terms[i].posting_count = builder->terms[keys[i].id].posting_count;
+        memcpy(strings + strings_length, keys[i].text, keys[i].length);
+        strings_length += keys[i].length;
+    }
+
+    size_t count = builder->triple_count;
+    for (size_t i = 0; i < count; i++) counts[builder->triples[i].section + 1]++;
+    for (int i = 0; i < section_count; i++) counts[i + 1] += counts[i];
+    for (size_t i = 0; i < count; i++) {
+        by_section[counts[builder->triples[i].section]++] = builder->triples[i];
+    }
+
+    uint32_t next = 0;
+    for (int i = 0; i < term_count; i++) {
+        terms[i].first_posting = next;
+        next += terms[i].posting_count;
+    }
+    memset(counts, 0, (size_t)term_count * sizeof(uint32_t));
+    for (size_t i = 0; i < count; i++) {
+        uint32_t term = rank[by_section[i].term];
+        postings[terms[term].first_posting + counts[term]++] =
+            (search_posting_t){by_section[i].section, by_section[i].frequency};
+    }
+
+    free(index->terms);
+    free(index->postings);
+    free(index->strings);
+    index->terms = terms;
+    index->term_count = term_count;
+    index->postings = postings;
+    index->posting_count = count;
+    index->strings = strings;
+    index->strings_length = strings_length;
+
+    free(keys);
+    free(rank);
+    free(by_section);
+    free(counts);
+    return 1;
+
+fail:
+    free(keys);
+    free(rank);
+    free(by_section);
+    free(counts);
+    free(terms);
+    free(postings);
+    free(strings);
+    return 0;
+}
+
+static int append_section(search_section_t **sections, int *count, int *capacity) {
+    if (*count == *capacity) {
+        int grown = *capacity ? *capacity * 2 : 256;
+        search_section_t *resized = realloc(*sections, grown * sizeof(search_section_t));
+        if (!resized) return 0;
+        *sections = resized;
+        *capacity = grown;
+    }
+    memset(&(*sections)[*count], 0, sizeof(search_section_t));
+    (*count)++;
+    return 1;
+}
+
+// Tokenize the "## " sections of a changed day file into the builder.
+// A file that can't be read is indexed as having no sections, and is
+// retried once its mtime or size moves.
+static int index_day_file(search_builder_t *builder, date_t date, uint32_t day, const config_t *config,
+                          search_section_t **sections, int *count, int *capacity) {
+    char path[MAX_PATH_SIZE];
+    mapped_file_t file;
+    if (!get_entry_path(date, path, config) || !map_file(path, &file)) return 1;
+
+    section_list_t list;
+    memset(&list, 0, sizeof(list));
+    int ok = scan_sections(file.data, file.length, &list);
+
+    char token[SEARCH_TOKEN_MAX + 1];
+    for (int i = 0; ok && i < list.count; i++) {
+        const entry_section_t *scanned = &list.sections[i];
+        if (!append_section(sections, count, capacity)) {
+            ok = 0;
+            break;
+        }
+        uint32_t id = (uint32_t)(*count - 1);
+        search_section_t *section = &(*sections)[id];
+        section->day = day;
+        section->offset = (uint32_t)scanned->offset;
+        section->length = (uint32_t)scanned->length;
+        section->hour = (int8_t)scanned->hour;
+        section->minute = (int8_t)scanned->minute;
+        section->second = (int8_t)scanned->second;
+
+        // The header line holds the time, not text
+        const char *p = file.data + scanned->offset;
+        const char *end = p + scanned->length;
+        const char *body = memchr(p, '\n', end - p);
+        p = body ? body + 1 : end;
+
+        uint32_t tokens = 0;
+        size_t length;
+        while ((length = search_next_token(&p, end, token)) > 0) {
+            builder_add(builder, token, length, id);
+            tokens++;
+        }
+        (*sections)[id].token_count = tokens;
+    }
+
+    free_section_list(&list);
+    unmap_file(&file);
+    return ok && !builder->failed;
+}
+
+// Bring the search index in line with the journal index. Only day files
+// whose mtime or size changed are read; the postings of every other day
+// are carried over. Returns 0 if memory ran out, leaving the index as it
+// was.
+int search_index_update(search_index_t *index, const journal_index_t *journal, const config_t *config) {
+    int *kept = malloc((journal->count > 0 ? journal->count : 1) * sizeof(int));
+    if (!kept) return 0;
+
+    // Pair each journal day with its record from the old index
+    int changed = (journal->count != index->day_count);
+    int old = 0;
+    for (int i = 0; i < journal->count; i++) {
+        const index_entry_t *entry = &journal->entries[i];
+        int key = date_to_days(entry->date);
+        while (old < index->day_count && day_key(&index->days[old]) < key) old++;
+        if (old < index->day_count && day_key(&index->days[old]) == key &&
+            index->days[old].mtime == (int64_t)entry->mtime && index->days[old].size == (int64_t)entry->size) {
+            kept[i] = old++;
+        } else {
+            kept[i] = -1;
+            changed = 1;
+        }
+    }
+    if (!changed) {
+        free(kept);
+        return 1;
+    }
+
+    search_builder_t builder;
+    search_day_t *days = calloc(journal->count > 0 ? journal->count : 1, sizeof(search_day_t));
+    uint32_t *section_map = malloc((index->section_count > 0 ? index->section_count : 1) * sizeof(uint32_t));
+    search_section_t *sections = NULL;
+    int section_count = 0;
+    int section_capacity = 0;
+    int ok = builder_init(&builder) && days && section_map;
+    if (ok) memset(section_map, 0xff, index->section_count * sizeof(uint32_t));  // UINT32_MAX: dropped
+
+    for (int i = 0; ok && i < journal->count; i++) {
+        const index_entry_t *entry = &journal->entries[i];
+        search_day_t *day = &days[i];
+        day->mtime = (int64_t)entry->mtime;
+        day->size = (int64_t)entry->size;
+        day->year = (uint16_t)entry->date.year;
+        day->month = (uint8_t)entry->date.month;
+        day->day = (uint8_t)entry->date.day;
+        day->first_section = (uint32_t)section_count;
+
+        if (kept[i] >= 0) {
+            const search_day_t *previous = &index->days[kept[i]];
+            for (uint32_t s = 0; ok && s < previous->section_count; s++) {
+                uint32_t from = previous->first_section + s;
+                ok = append_section(&sections, &section_count, &section_capacity);
+                if (!ok) break;
+                sections[section_count - 1] = index->sections[from];
+                sections[section_count - 1].day = (uint32_t)i;
+                section_map[from] = (uint32_t)(section_count - 1);
+            }
+        } else {
+            ok = index_day_file(&builder, entry->date, (uint32_t)i, config,
+                                &sections, &section_count, &section_capacity);
+        }
+        day->section_count = (uint32_t)section_count - day->first_section;
+    }
+
+    // Carry over the postings of unchanged days
+    for (int t = 0; ok && t < index->term_count; t++) {
+        const search_term_t *term = &index->terms[t];
+        int id = -1;
+        for (uint32_t p = 0; p < term->posting_count; p++) {
+            const search_posting_t *posting = &index->postings[term->first_posting + p];
+            uint32_t section = section_map[posting->section];
+            if (section == UINT32_MAX) continue;
+            if (id < 0) id = builder_intern(&builder, index->strings + term->text, term->length);
+            if (id < 0) break;
+            builder_push(&builder, id, section, posting->frequency);
+        }
+        ok = !builder.failed;
+    }
+
+    if (ok) ok = builder_finish(&builder, section_count, index);
+    if (ok) {
+        free(index->days);
+        free(index->sections);
+        index->days = days;
+        index->day_count = journal->count;
+        index->sections = sections;
+        index->section_count = section_count;
+        count_tokens(index);
+        index->dirty = 1;
+    } else {
+        free(days);
+        free(sections);
+    }
+
+    builder_free(&builder);
+    free(section_map);
+    free(kept);
+    return ok;
+}
+
+// Load the saved index, bring it up to date and write it back if needed
+int search_index_open(search_index_t *index, const journal_index_t *journal, const config_t *config) {
+    search_index_load(index, config);
+    int result = search_index_update(index, journal, config);
+    search_index_save(index, config);
+    return result;
+}
+
+// Query
+
+// Position of a term in the sorted term table, or -1
+static int find_term(const search_index_t *index, const char *text, size_t length) {
+    int lo = 0, hi = index->term_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        const search_term_t *term = &index->terms[mid];
+        int result = compare_text(index->strings + term->text, term->length, text, length);
+        if (result == 0) return mid;
+        if (result < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return -1;
+}
+
+// First position in postings[0, count) whose section is above section
+static uint32_t upper_bound(const search_posting_t *postings, uint32_t count, uint32_t section) {
+    uint32_t lo = 0, hi = count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (postings[mid].section <= section) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Look up the distinct words of query. Returns how many were found, and
+// sets *missing if any word occurs nowhere.
+static int query_terms(const search_index_t *index, const char *query, const search_term_t **terms,
+                       int *missing) {
+    int term_count = 0;
+    *missing = 0;
+
+    const char *p = query;
+    const char *end = query + strlen(query);
+    char token[SEARCH_TOKEN_MAX + 1];
+    size_t length;
+    while ((length = search_next_token(&p, end, token)) > 0) {
+        int found = find_term(index, token, length);
+        if (found < 0) {
+            *missing = 1;
+            continue;
+        }
+
+        const search_term_t *term = &index->terms[found];
+        int duplicate = 0;
+        for (int i = 0; i < term_count; i++) {
+            if (terms[i] == term) duplicate = 1;
+        }
+        if (!duplicate && term_count < SEARCH_QUERY_TERMS) {
+            terms[term_count++] = term;
+        }
+    }
+    return term_count;
+}
+
+// Find the sections that contain every word of query, newest first.
+// Up to max_hits are stored in hits; returns the total number found.
+int search_index_query(const search_index_t *index, const char *query, search_hit_t *hits, int max_hits) {
+    const search_term_t *terms[SEARCH_QUERY_TERMS];
+    int missing;
+    int term_count = query_terms(index, query, terms, &missing);
+    if (term_count == 0 || missing) return 0;  // A word that occurs nowhere matches nothing
+
+    // Walk the rarest term's postings; the others are probed by binary
+    // search, and the part still worth searching only shrinks
+    for (int i = 1; i < term_count; i++) {
+        for (int j = i; j > 0 && terms[j]->posting_count < terms[j - 1]->posting_count; j--) {
+            const search_term_t *swap = terms[j];
+            terms[j] = terms[j - 1];
+            terms[j - 1] = swap;
+        }
+    }
+    uint32_t limits[SEARCH_QUERY_TERMS];
+    for (int i = 0; i < term_count; i++) {
+        limits[i] = terms[i]->posting_count;
+    }
+
+    const search_posting_t *rarest = index->postings + terms[0]->first_posting;
+    int total = 0;
+    for (uint32_t i = terms[0]->posting_count; i-- > 0;) {
+        uint32_t section = rarest[i].section;
+        int match = 1;
+        for (int t = 1; t < term_count && match; t++) {
+            const search_posting_t *postings = index->postings + terms[t]->first_posting;
+            limits[t] = upper_bound(postings, limits[t], section);
+            match = (limits[t] > 0 && postings[limits[t] - 1].section == section);
+        }
+        if (!match) continue;
+
+        if (total < max_hits) {
+            const search_day_t *day = &index->days[index->sections[section].day];
+            hits[total].date = (date_t){day->year, day->month, day->day};
+            hits[total].section = section;
+            hits[total].score = 0;
+        }
+        total++;
+    }
+    return total;
+}
+
+// Ranking
+
+#define BM25_K1 1.2f
+#define BM25_B 0.75f
+
+// Candidate in the top-k heap
+typedef struct {
+    float score;
+    uint32_t section;
+} ranked_t;
+
+// Weaker result: lower score, or older on a tie
+static int ranks_below(const ranked_t *a, const ranked_t *b) {
+    return a->score < b->score || (a->score == b->score && a->section < b->section);
+}
+
+// Restore the min-heap below position i
+static void heap_sift_down(ranked_t *heap, int count, int i) {
+    for (;;) {
+        int weakest = i;
+        int left = 2 * i + 1, right = left + 1;
+        if (left < count && ranks_below(&heap[left], &heap[weakest])) weakest = left;
+        if (right < count && ranks_below(&heap[right], &heap[weakest])) weakest = right;
+        if (weakest == i) return;
+        ranked_t swap = heap[i];
+        heap[i] = heap[weakest];
+        heap[weakest] = swap;
+        i = weakest;
+    }
+}
+
+static void heap_sift_up(ranked_t *heap, int i) {
+    while (i > 0 && ranks_below(&heap[i], &heap[(i - 1) / 2])) {
+        ranked_t swap = heap[i];
+        heap[i] = heap[(i - 1) / 2];
+        heap[(i - 1) / 2] = swap;
+        i = (i - 1) / 2;
+    }
+}
+
+// Rank the sections containing any word of query by BM25, using each
+// posting's frequency and each section's token count. The best max_hits
+// are kept in a bounded min-heap and stored in hits, best first; returns
+// the number of sections that matched at all, or -1 if memory ran out.
+int search_index_rank(const search_index_t *index, const char *query, search_hit_t *hits, int max_hits) {
+    const search_term_t *terms[SEARCH_QUERY_TERMS];
+    int missing;
+    int term_count = query_terms(index, query, terms, &missing);
+    if (term_count == 0 || max_hits <= 0) return 0;
+
+    // Scores accumulate per section; touched lists the ones with any
+    float *scores = calloc(index->section_count, sizeof(float));
+    uint32_t *touched = malloc(index->section_count * sizeof(uint32_t));
+    ranked_t *heap = malloc(max_hits * sizeof(ranked_t));
+    if (!scores || !touched || !heap) {
+        free(scores);
+        free(touched);
+        free(heap);
+        return -1;
+    }
+
+    float sections = (float)index->section_count;
+    float average_length = (float)index->token_total / sections;
+    if (average_length <= 0) average_length = 1;
+    int total = 0;
+    for (int t = 0; t < term_count; t++) {
+        float documents = (float)terms[t]->posting_count;
+        float idf = (float)log(1.0 + (sections - documents + 0.5) / (documents + 0.5));
+        const search_posting_t *postings = index->postings + terms[t]->first_posting;
+        for (uint32_t p = 0; p < terms[t]->posting_count; p++) {
+            uint32_t section = postings[p].section;
+            float frequency = (float)postings[p].frequency;
+            float length = (float)index->sections[section].token_count;
+            float norm = BM25_K1 * (1 - BM25_B + BM25_B * length / average_length);
+            // Every term adds a positive amount, so zero means untouched
+            if (scores[section] == 0) touched[total++] = section;
+            scores[section] += idf * frequency * (BM25_K1 + 1) / (frequency + norm);
+        }
+    }
+
+    int kept = 0;
+    for (int i = 0; i < total; i++) {
+        ranked_t candidate = {scores[touched[i]], touched[i]};
+        if (kept < max_hits) {
+            heap[kept] = candidate;
+            heap_sift_up(heap, kept++);
+        } else if (ranks_below(&heap[0], &candidate)) {
+            heap[0] = candidate;
+            heap_sift_down(heap, kept, 0);
+        }
+    }
+
+    // Popping the weakest first fills hits from the back
+    for (int i = kept - 1; i >= 0; i--) {
+        const search_day_t *day = &index->days[index->sections[heap[0].section].day];
+        hits[i].date = (date_t){day->year, day->month, day->day};
+        hits[i].section = heap[0].section;
+        hits[i].score = heap[0].score;
+        heap[0] = heap[i];
+        heap_sift_down(heap, i, 0);
+    }
+
+    free(scores);
+    free(touched);
+    free(heap);
+    return total;
+}
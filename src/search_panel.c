@@ -0,0 +1,593 @@
+#define _GNU_SOURCE
+#include "ciary.h"
+
+// The search panel is MODE_SEARCH of run_app. The UI thread owns the
+// query line and the hits on screen; a worker thread owns the queries.
+// They meet only in search_panel_t's request and reply fields, under its
+// lock. The indexes are written by the worker alone, under index_lock,
+// and only while no hits are on screen; the calendar takes the same lock
+// when it updates the journal index after an edit.
+
+static double elapsed_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000.0 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// Words go to the word index; "text" and /regex/ to the trigram index
+static int is_word_query(const char *query) {
+    return query[0] != '"' && query[0] != '/';
+}
+
+// Worker
+
+// Load the index on first use and catch up with the journal index, which
+// the calendar keeps current as entries are edited
+static void prepare_search(app_state_t *state) {
+    pthread_mutex_lock(&state->panel->index_lock);
+    if (!state->search_loaded) {
+        search_index_load(&state->search, &state->config);
+        state->search_loaded = 1;
+    }
+    if (search_index_update(&state->search, &state->index, &state->config)) {
+        search_index_save(&state->search, &state->config);
+    }
+    pthread_mutex_unlock(&state->panel->index_lock);
+}
+
+// A newer request has replaced generation, or the worker is shutting down
+static int is_stale(search_panel_t *panel, unsigned generation) {
+    pthread_mutex_lock(&panel->lock);
+    int stale = panel->quit || panel->generation != generation;
+    pthread_mutex_unlock(&panel->lock);
+    return stale;
+}
+
+// Position of date in the index's days, or -1
+static int find_day(const search_index_t *index, date_t date) {
+    int key = date_to_days(date);
+    int lo = 0, hi = index->day_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        const search_day_t *day = &index->days[mid];
+        int mid_key = date_to_days((date_t){day->year, day->month, day->day});
+        if (mid_key == key) return mid;
+        if (mid_key < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return -1;
+}
+
+// Turns grep matches into hits on the sections holding them
+typedef struct {
+    const search_index_t *index;
+    search_hit_t *hits;
+    int max_hits;
+    int total;
+    date_t date;
+    int day;          // Of date in the index, or -1
+    int day_start;    // First hit of date
+    uint32_t section; // Of the last hit
+    search_panel_t *panel;
+    unsigned generation;
+} section_collector_t;
+
+// Matches come oldest section first within a day; word search lists the
+// newest first
+static void finish_day(section_collector_t *collector) {
+    int last = (collector->total < collector->max_hits ? collector->total : collector->max_hits) - 1;
+    for (int first = collector->day_start; first < last; first++, last--) {
+        search_hit_t swap = collector->hits[first];
+        collector->hits[first] = collector->hits[last];
+        collector->hits[last] = swap;
+    }
+}
+
+static int collect_section(const grep_match_t *match, void *context) {
+    section_collector_t *collector = context;
+    if (is_stale(collector->panel, collector->generation)) return 0;
+
+    if (collector->day_start < 0 || date_compare(match->date, collector->date) != 0) {
+        if (collector->day_start >= 0) finish_day(collector);
+        collector->date = match->date;
+        collector->day = find_day(collector->index, match->date);
+        collector->day_start = collector->total;
+    }
+    if (collector->day < 0) return 1;
+
+    // Lines above the first "## " header belong to no section
+    const search_day_t *day = &collector->index->days[collector->day];
+    for (uint32_t s = day->first_section; s < day->first_section + day->section_count; s++) {
+        const search_section_t *section = &collector->index->sections[s];
+        if (match->offset < section->offset || match->offset >= (size_t)section->offset + section->length) {
+            continue;
+        }
+        if (collector->total > collector->day_start && collector->section == s) break;
+        collector->section = s;
+        if (collector->total < collector->max_hits) {
+            collector->hits[collector->total].date = match->date;
+            collector->hits[collector->total].section = s;
+            collector->hits[collector->total].score = 0;
+        }
+        collector->total++;
+        break;
+    }
+    return 1;
+}
+
+// A query in quotes is a fragment and one between slashes a regex; both
+// ignore case and go through the trigram index instead of the word index.
+// Returns the number of matching sections, or -1 with a message in error.
+static int grep_sections(app_state_t *state, const char *query, unsigned generation, search_hit_t *hits,
+                         char *error, size_t size) {
+    char text[SEARCH_QUERY_SIZE];
+    char close = query[0];
+    snprintf(text, sizeof(text), "%s", query + 1);
+    size_t length = strlen(text);
+    if (length > 0 && text[length - 1] == close) text[length - 1] = '\0';
+
+    grep_pattern_t pattern;
+    int flags = GREP_IGNORE_CASE | (close == '"' ? GREP_FIXED : 0);
+    if (!grep_pattern_compile(&pattern, text, flags, error, size)) return -1;
+
+    pthread_mutex_lock(&state->panel->index_lock);
+    if (!state->trigram_loaded) {
+        trigram_index_load(&state->trigram, &state->config);
+        state->trigram_loaded = 1;
+    }
+    if (trigram_index_update(&state->trigram, &state->index, &state->config)) {
+        trigram_index_save(&state->trigram, &state->config);
+    }
+    pthread_mutex_unlock(&state->panel->index_lock);
+
+    section_collector_t collector;
+    memset(&collector, 0, sizeof(collector));
+    collector.index = &state->search;
+    collector.hits = hits;
+    collector.max_hits = SEARCH_MAX_HITS;
+    collector.day_start = -1;
+    collector.panel = state->panel;
+    collector.generation = generation;
+    int result = grep_journal(&state->trigram, &pattern, &state->config, 1, collect_section, &collector);
+    if (collector.day_start >= 0) finish_day(&collector);
+    grep_pattern_free(&pattern);
+
+    if (result < 0) {
+        snprintf(error, size, "out of memory");
+        return -1;
+    }
+    return collector.total;
+}
+
+// Words go to the word index, ranked by relevance or newest first.
+// Returns the number of matches, or -1 with a message in error.
+static int run_query(app_state_t *state, const char *query, int ranked, unsigned generation,
+                     search_hit_t *hits, char *error, size_t size) {
+    if (!is_word_query(query)) {
+        return grep_sections(state, query, generation, hits, error, size);
+    }
+    if (!ranked) {
+        return search_index_query(&state->search, query, hits, SEARCH_MAX_HITS);
+    }
+    int total = search_index_rank(&state->search, query, hits, SEARCH_MAX_HITS);
+    if (total < 0) snprintf(error, size, "out of memory");
+    return total;
+}
+
+// Take the latest request, run it and post the reply unless a newer
+// request came in meanwhile. Called with the lock held, which is dropped
+// while the query runs.
+static void serve_request(app_state_t *state) {
+    search_panel_t *panel = state->panel;
+    char query[SEARCH_QUERY_SIZE];
+    char error[sizeof(panel->reply_error)];
+    int prepare = panel->prepare;
+    int ranked = panel->request_ranked;
+    unsigned generation = panel->generation;
+    memcpy(query, panel->request, sizeof(query));
+    panel->prepare = 0;
+    panel->served = generation;
+    pthread_mutex_unlock(&panel->lock);
+
+    if (prepare) prepare_search(state);
+    int total = 0;
+    error[0] = '\0';
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (query[0] != '\0' && !is_stale(panel, generation)) {
+        total = run_query(state, query, ranked, generation, panel->work, error, sizeof(error));
+    }
+    double elapsed_ms = elapsed_since(&start);
+
+    pthread_mutex_lock(&panel->lock);
+    if (generation == panel->generation) {
+        search_hit_t *swap = panel->reply;
+        panel->reply = panel->work;
+        panel->work = swap;
+        panel->reply_total = total;
+        memcpy(panel->reply_error, error, sizeof(error));
+        panel->reply_ms = elapsed_ms;
+        panel->reply_generation = generation;
+        panel->reply_ready = 1;
+    }
+}
+
+static void* search_worker(void *arg) {
+    app_state_t *state = arg;
+    search_panel_t *panel = state->panel;
+
+    pthread_mutex_lock(&panel->lock);
+    for (;;) {
+        while (!panel->quit && !panel->prepare && panel->served == panel->generation) {
+            pthread_cond_wait(&panel->wake, &panel->lock);
+        }
+        if (panel->quit) break;
+        serve_request(state);
+    }
+    pthread_mutex_unlock(&panel->lock);
+    return NULL;
+}
+
+// UI thread
+
+static search_panel_t* create_panel(app_state_t *state) {
+    search_panel_t *panel = calloc(1, sizeof(search_panel_t));
+    if (!panel) return NULL;
+    panel->work = malloc(SEARCH_MAX_HITS * sizeof(search_hit_t));
+    panel->reply = malloc(SEARCH_MAX_HITS * sizeof(search_hit_t));
+    panel->hits = malloc(SEARCH_MAX_HITS * sizeof(search_hit_t));
+    panel->snippets = malloc(SEARCH_MAX_HITS * sizeof(*panel->snippets));
+    panel->snippet_ready = calloc(SEARCH_MAX_HITS, 1);
+    if (!panel->work || !panel->reply || !panel->hits || !panel->snippets || !panel->snippet_ready) {
+        free(panel->work);
+        free(panel->reply);
+        free(panel->hits);
+        free(panel->snippets);
+        free(panel->snippet_ready);
+        free(panel);
+        return NULL;
+    }
+    pthread_mutex_init(&panel->lock, NULL);
+    pthread_cond_init(&panel->wake, NULL);
+    pthread_mutex_init(&panel->index_lock, NULL);
+
+    state->panel = panel;
+    panel->running = (pthread_create(&panel->thread, NULL, search_worker, state) == 0);
+    return panel;
+}
+
+// Hand the request over to the worker, or serve it here if there is none
+static void send_request(app_state_t *state) {
+    search_panel_t *panel = state->panel;
+    if (panel->running) {
+        pthread_cond_signal(&panel->wake);
+        pthread_mutex_unlock(&panel->lock);
+    } else {
+        serve_request(state);
+        pthread_mutex_unlock(&panel->lock);
+    }
+}
+
+// Post the query line as a new request. The hits on screen stay until the
+// reply arrives, except that an empty line clears them at once.
+static void post_query(app_state_t *state) {
+    search_panel_t *panel = state->panel;
+    pthread_mutex_lock(&panel->lock);
+    panel->generation++;
+    memcpy(panel->request, panel->query, sizeof(panel->request));
+    panel->request_ranked = panel->ranked && is_word_query(panel->query);
+    if (panel->length == 0) {
+        panel->shown_generation = panel->generation;
+        panel->total = panel->shown = panel->selected = panel->top = 0;
+        panel->error[0] = '\0';
+    }
+    send_request(state);
+}
+
+// Enter MODE_SEARCH with an empty query line. The worker first brings the
+// indexes up to date, so typing can start while it does.
+void open_search_panel(app_state_t *state) {
+    search_panel_t *panel = state->panel ? state->panel : create_panel(state);
+    if (!panel) return;
+
+    panel->query[0] = '\0';
+    panel->length = 0;
+    panel->ranked = 1;
+    pthread_mutex_lock(&panel->lock);
+    panel->prepare = 1;
+    pthread_mutex_unlock(&panel->lock);
+    post_query(state);
+    state->mode = MODE_SEARCH;
+}
+
+// Back to the calendar; a query still running is abandoned
+void close_search_panel(app_state_t *state) {
+    search_panel_t *panel = state->panel;
+    panel->query[0] = '\0';
+    panel->length = 0;
+    post_query(state);
+    state->mode = MODE_CALENDAR;
+}
+
+// Take the worker's reply if it answers the latest request. Returns 1 if
+// the panel has something new to show.
+int search_panel_poll(app_state_t *state) {
+    search_panel_t *panel = state->panel;
+    if (!panel) return 0;
+
+    pthread_mutex_lock(&panel->lock);
+    int fresh = panel->reply_ready && panel->reply_generation == panel->generation;
+    if (fresh) {
+        search_hit_t *swap = panel->hits;
+        panel->hits = panel->reply;
+        panel->reply = swap;
+        panel->total = panel->reply_total;
+        memcpy(panel->error, panel->reply_error, sizeof(panel->error));
+        panel->elapsed_ms = panel->reply_ms;
+        panel->shown_generation = panel->reply_generation;
+        panel->reply_ready = 0;
+    }
+    pthread_mutex_unlock(&panel->lock);
+
+    if (fresh) {
+        panel->shown = panel->total < SEARCH_MAX_HITS ? panel->total : SEARCH_MAX_HITS;
+        if (panel->shown < 0) panel->shown = 0;
+        panel->selected = panel->top = 0;
+        memset(panel->snippet_ready, 0, SEARCH_MAX_HITS);
+    }
+    return fresh;
+}
+
+// The hits on screen are not for the query line yet
+int search_panel_waiting(const app_state_t *state) {
+    return state->panel && state->panel->shown_generation != state->panel->generation;
+}
+
+void search_panel_free(app_state_t *state) {
+    search_panel_t *panel = state->panel;
+    if (!panel) return;
+
+    if (panel->running) {
+        pthread_mutex_lock(&panel->lock);
+        panel->quit = 1;
+        pthread_cond_signal(&panel->wake);
+        pthread_mutex_unlock(&panel->lock);
+        pthread_join(panel->thread, NULL);
+    }
+    pthread_mutex_destroy(&panel->lock);
+    pthread_cond_destroy(&panel->wake);
+    pthread_mutex_destroy(&panel->index_lock);
+    free(panel->work);
+    free(panel->reply);
+    free(panel->hits);
+    free(panel->snippets);
+    free(panel->snippet_ready);
+    free(panel);
+    state->panel = NULL;
+}
+
+// Keep the worker off the indexes while the caller changes them
+void search_lock_indexes(app_state_t *state) {
+    if (state->panel) pthread_mutex_lock(&state->panel->index_lock);
+}
+
+void search_unlock_indexes(app_state_t *state) {
+    if (state->panel) pthread_mutex_unlock(&state->panel->index_lock);
+}
+
+// Drawing
+
+// The first non-blank line of a section's text, for the result list
+static void section_snippet(const app_state_t *state, const search_hit_t *hit, char *snippet, size_t size) {
+    char path[MAX_PATH_SIZE];
+    mapped_file_t file;
+    snippet[0] = '\0';
+    if (!get_entry_path(hit->date, path, &state->config) || !map_file(path, &file)) return;
+
+    const search_section_t *section = &state->search.sections[hit->section];
+    if ((size_t)section->offset + section->length <= file.length) {
+        const char *p = file.data + section->offset;
+        const char *end = p + section->length;
+        const char *line = memchr(p, '\n', end - p);
+        p = line ? line + 1 : end;
+        while (p < end) {
+            line = memchr(p, '\n', end - p);
+            if (!line) line = end;
+            const char *text = p;
+            while (text < line && (*text == ' ' || *text == '\t' || *text == '\r')) text++;
+            if (text < line) {
+                size_t length = (size_t)(line - text);
+                if (length >= size) length = size - 1;
+                for (size_t i = 0; i < length; i++) {
+                    snippet[i] = (text[i] == '\t' || text[i] == '\r') ? ' ' : text[i];
+                }
+                snippet[length] = '\0';
+                break;
+            }
+            p = line + 1;
+        }
+    }
+    unmap_file(&file);
+}
+
+// Snippets are read when a row first comes into view, so a reply costs
+// the same to show however many hits it has
+static const char* row_snippet(app_state_t *state, int row) {
+    search_panel_t *panel = state->panel;
+    if (!panel->snippet_ready[row]) {
+        section_snippet(state, &panel->hits[row], panel->snippets[row], SEARCH_SNIPPET_SIZE);
+        panel->snippet_ready[row] = 1;
+    }
+    return panel->snippets[row];
+}
+
+static void draw_summary(const search_panel_t *panel, int waiting) {
+    const char *order = (panel->ranked && is_word_query(panel->query)) ? "best" : "newest";
+    if (panel->length == 0) {
+        mvprintw(3, 2, "Words find sections; \"text\" finds a fragment and /regex/ a pattern");
+    } else if (waiting) {
+        mvprintw(3, 2, "Searching...");
+    } else if (panel->total < 0) {
+        mvprintw(3, 2, "Invalid pattern: %s", panel->error);
+    } else if (panel->total == 0) {
+        mvprintw(3, 2, "No matches (%.1f ms)", panel->elapsed_ms);
+    } else if (panel->total > panel->shown) {
+        mvprintw(3, 2, "%d matches, %s %d shown (%.1f ms)", panel->total, order, panel->shown,
+                 panel->elapsed_ms);
+    } else {
+        mvprintw(3, 2, "%d %s, %s first (%.1f ms)", panel->total, panel->total == 1 ? "match" : "matches",
+                 order, panel->elapsed_ms);
+    }
+}
+
+// The query line and summary on top, the hits in a boxed window below.
+// Only the rows in view are formatted.
+void draw_search_panel(app_state_t *state) {
+    search_panel_t *panel = state->panel;
+    int rows, cols, cursor_y, cursor_x;
+    getmaxyx(stdscr, rows, cols);
+    erase();
+
+    mvprintw(2, 2, "Search: %s", panel->query);
+    getyx(stdscr, cursor_y, cursor_x);
+    draw_summary(panel, search_panel_waiting(state));
+    int ranked = panel->ranked && is_word_query(panel->query);
+    if (is_word_query(panel->query)) {
+        mvprintw(rows - 2, 2, "Up/Down: Select  Enter: Go to day  Tab: %s  Esc: Back",
+                 ranked ? "Newest first" : "Rank by relevance");
+    } else {
+        mvprintw(rows - 2, 2, "Up/Down: Select  Enter: Go to day  Esc: Back");
+    }
+    wnoutrefresh(stdscr);
+
+    int height = rows - 8;
+    int width = cols - 2;
+    WINDOW *list = (height >= 3 && width >= 10) ? newwin(height, width, 5, 1) : NULL;
+    if (list) {
+        int visible = height - 2;
+        if (panel->selected < panel->top) panel->top = panel->selected;
+        if (panel->selected >= panel->top + visible) panel->top = panel->selected - visible + 1;
+
+        box(list, 0, 0);
+        if (panel->shown > 0) {
+            int last = (panel->top + visible < panel->shown) ? panel->top + visible : panel->shown;
+            mvwprintw(list, 0, width - 24, " %d-%d of %d ", panel->top + 1, last, panel->shown);
+        }
+        for (int i = 0; i < visible && panel->top + i < panel->shown; i++) {
+            int row = panel->top + i;
+            const search_hit_t *hit = &panel->hits[row];
+            const search_section_t *section = &state->search.sections[hit->section];
+            char when[32], line[512];
+            if (section->hour >= 0) {
+                snprintf(when, sizeof(when), "%04d-%02d-%02d %02d:%02d:%02d", hit->date.year, hit->date.month,
+                         hit->date.day, section->hour, section->minute, section->second);
+            } else {
+                snprintf(when, sizeof(when), "%04d-%02d-%02d         ", hit->date.year, hit->date.month,
+                         hit->date.day);
+            }
+            if (ranked) {
+                snprintf(line, sizeof(line), "%s %6.2f  %s", when, hit->score, row_snippet(state, row));
+            } else {
+                snprintf(line, sizeof(line), "%s  %s", when, row_snippet(state, row));
+            }
+
+            if (row == panel->selected) wattron(list, A_REVERSE);
+            mvwprintw(list, 1 + i, 1, "%-*.*s", width - 2, width - 2, line);
+            if (row == panel->selected) wattroff(list, A_REVERSE);
+        }
+        wnoutrefresh(list);
+    }
+
+    // Leave the cursor on the query line
+    move(cursor_y, cursor_x);
+    wnoutrefresh(stdscr);
+    doupdate();
+    if (list) delwin(list);
+}
+
+// Input
+
+// Drop the last character of the query line, all of its UTF-8 bytes
+static void erase_last_char(search_panel_t *panel) {
+    while (panel->length > 0 && ((unsigned char)panel->query[panel->length - 1] & 0xC0) == 0x80) {
+        panel->length--;
+    }
+    if (panel->length > 0) panel->length--;
+    panel->query[panel->length] = '\0';
+}
+
+// Typing edits the query line, which is searched again at once; the
+// arrows move through the hits and Enter moves the calendar to one
+void handle_search_input(app_state_t *state, int ch) {
+    search_panel_t *panel = state->panel;
+    int visible = LINES - 10;
+    if (visible < 1) visible = 1;
+
+    switch (ch) {
+        case 27:  // Esc
+            close_search_panel(state);
+            break;
+
+        case '\n':
+        case '\r':
+        case KEY_ENTER:
+            if (panel->shown > 0) {
+                state->selected_date = panel->hits[panel->selected].date;
+                state->current_date = panel->hits[panel->selected].date;
+                close_search_panel(state);
+            }
+            break;
+
+        case KEY_UP:
+            if (panel->selected > 0) panel->selected--;
+            break;
+        case KEY_DOWN:
+            if (panel->selected < panel->shown - 1) panel->selected++;
+            break;
+        case KEY_PPAGE:
+            panel->selected = (panel->selected > visible) ? panel->selected - visible : 0;
+            break;
+        case KEY_NPAGE:
+            if (panel->shown > 0) {
+                panel->selected = (panel->selected + visible < panel->shown) ? panel->selected + visible
+                                                                             : panel->shown - 1;
+            }
+            break;
+        case KEY_HOME:
+            panel->selected = 0;
+            break;
+        case KEY_END:
+            if (panel->shown > 0) panel->selected = panel->shown - 1;
+            break;
+
+        case '\t':
+            panel->ranked = !panel->ranked;
+            if (panel->length > 0 && is_word_query(panel->query)) post_query(state);
+            break;
+
+        case KEY_BACKSPACE:
+        case 127:
+        case 8:
+            if (panel->length > 0) {
+                erase_last_char(panel);
+                post_query(state);
+            }
+            break;
+
+        case 21:  // Ctrl-U
+            if (panel->length > 0) {
+                panel->query[0] = '\0';
+                panel->length = 0;
+                post_query(state);
+            }
+            break;
+
+        default:
+            if (ch >= 32 && ch < 256 && ch != 127 && panel->length < SEARCH_QUERY_SIZE - 1) {
+                panel->query[panel->length++] = (char)ch;
+                panel->query[panel->length] = '\0';
+                post_query(state);
+            }
+            break;
+    }
+}
@@ -0,0 +1,484 @@
+#define _GNU_SOURCE
+#include "ciary.h"
+#include <stdint.h>
+
+// On-disk layout of .ciary-trigram (host byte order; a foreign or corrupt
+// file is simply rebuilt):
+//   header:  trigram_file_header_t
+//   arrays:  days, terms, postings; each array starts 8-byte aligned
+// Like the search index it follows the journal index: only day files
+// whose mtime or size moved are read again.
+#define TRIGRAM_MAGIC "CTRI"
+#define TRIGRAM_VERSION 1
+#define TRIGRAM_MAX_COUNT (1u << 30)
+#define TRIGRAM_LIMIT (1u << 24)
+#define TRIGRAM_QUERY_MAX 64  // More trigrams than this hardly narrow the candidates
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t day_count;
+    uint32_t term_count;
+    uint64_t posting_count;
+} trigram_file_header_t;
+
+void trigram_index_init(trigram_index_t *index) {
+    memset(index, 0, sizeof(*index));
+}
+
+void trigram_index_free(trigram_index_t *index) {
+    free(index->days);
+    free(index->terms);
+    free(index->postings);
+    trigram_index_init(index);
+}
+
+static char* get_trigram_path(char *path, const config_t *config) {
+    int result = snprintf(path, MAX_PATH_SIZE, "%s/%s", config->journal_directory, TRIGRAM_INDEX_FILE);
+    return (result < MAX_PATH_SIZE) ? path : NULL;
+}
+
+static size_t align8(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+static int day_key(const trigram_day_t *day) {
+    return date_to_days((date_t){day->year, day->month, day->day});
+}
+
+static uint32_t fold(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (uint32_t)(c + ('a' - 'A')) : c;
+}
+
+// Load
+static int copy_array(void **array, const mapped_file_t *file, size_t *offset, size_t size) {
+    if (*offset > file->length || size > file->length - *offset) return 0;
+    *array = malloc(size > 0 ? size : 1);
+    if (!*array) return 0;
+    memcpy(*array, file->data + *offset, size);
+    *offset = align8(*offset + size);
+    return 1;
+}
+
+// Check the ordering every lookup relies on, and every posting's range
+static int validate_index(const trigram_index_t *index) {
+    for (int i = 1; i < index->day_count; i++) {
+        if (day_key(&index->days[i]) <= day_key(&index->days[i - 1])) return 0;
+    }
+
+    for (int i = 0; i < index->term_count; i++) {
+        const trigram_term_t *term = &index->terms[i];
+        if (term->trigram >= TRIGRAM_LIMIT || (i > 0 && term->trigram <= index->terms[i - 1].trigram) ||
+            term->first_posting > index->posting_count ||
+            term->posting_count > index->posting_count - term->first_posting) {
+            return 0;
+        }
+        const uint32_t *postings = index->postings + term->first_posting;
+        for (uint32_t p = 0; p < term->posting_count; p++) {
+            if (postings[p] >= (uint32_t)index->day_count || (p > 0 && postings[p] <= postings[p - 1])) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+int trigram_index_load(trigram_index_t *index, const config_t *config) {
+    char path[MAX_PATH_SIZE];
+
+    trigram_index_free(index);
+    if (!get_trigram_path(path, config)) return 0;
+
+    mapped_file_t file;
+    if (!map_file(path, &file)) return 0;  // No index yet
+
+    trigram_file_header_t header;
+    if (file.length < sizeof(header)) {
+        unmap_file(&file);
+        return 0;
+    }
+    memcpy(&header, file.data, sizeof(header));
+    if (memcmp(header.magic, TRIGRAM_MAGIC, 4) != 0 || header.version != TRIGRAM_VERSION ||
+        header.day_count > TRIGRAM_MAX_COUNT || header.term_count > TRIGRAM_LIMIT ||
+        header.posting_count > TRIGRAM_MAX_COUNT) {
+        unmap_file(&file);
+        return 0;
+    }
+
+    size_t offset = align8(sizeof(header));
+    int ok = copy_array((void **)&index->days, &file, &offset, header.day_count * sizeof(trigram_day_t)) &&
+             copy_array((void **)&index->terms, &file, &offset, header.term_count * sizeof(trigram_term_t)) &&
+             copy_array((void **)&index->postings, &file, &offset, header.posting_count * sizeof(uint32_t));
+    unmap_file(&file);
+
+    index->day_count = (int)header.day_count;
+    index->term_count = (int)header.term_count;
+    index->posting_count = (size_t)header.posting_count;
+    if (!ok || !validate_index(index)) {
+        trigram_index_free(index);
+        return 0;
+    }
+
+    index->dirty = 0;
+    return 1;
+}
+
+static void write_array(output_sink_t *output, const void *array, size_t size) {
+    static const char padding[8];
+    output_write(output, array, size);
+    output_write(output, padding, align8(size) - size);
+}
+
+int trigram_index_save(trigram_index_t *index, const config_t *config) {
+    char path[MAX_PATH_SIZE];
+    char temp_path[MAX_PATH_SIZE];
+
+    if (!index->dirty) return 1;
+    if (!get_trigram_path(path, config)) return 0;
+    if (snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= (int)sizeof(temp_path)) return 0;
+
+    output_sink_t output;
+    if (!output_open(&output, temp_path)) return 0;
+
+    trigram_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRIGRAM_MAGIC, 4);
+    header.version = TRIGRAM_VERSION;
+    header.day_count = (uint32_t)index->day_count;
+    header.term_count = (uint32_t)index->term_count;
+    header.posting_count = (uint64_t)index->posting_count;
+
+    write_array(&output, &header, sizeof(header));
+    write_array(&output, index->days, index->day_count * sizeof(trigram_day_t));
+    write_array(&output, index->terms, index->term_count * sizeof(trigram_term_t));
+    write_array(&output, index->postings, index->posting_count * sizeof(uint32_t));
+
+    // Replace the old index atomically so readers never see a partial file
+    if (!output_close(&output) || rename(temp_path, path) != 0) {
+        unlink(temp_path);
+        return 0;
+    }
+
+    index->dirty = 0;
+    return 1;
+}
+
+// Update
+
+// (trigram, day) pairs of the reread days, trigram in the high word
+typedef struct {
+    uint64_t *keys;
+    size_t count;
+    size_t capacity;
+    uint64_t *seen;  // One bit per trigram, cleared again after each day
+    int failed;
+} trigram_pairs_t;
+
+static int push_pair(trigram_pairs_t *pairs, uint32_t trigram, uint32_t day) {
+    if (pairs->count == pairs->capacity) {
+        size_t grown = pairs->capacity ? pairs->capacity * 2 : 4096;
+        uint64_t *resized = realloc(pairs->keys, grown * sizeof(uint64_t));
+        if (!resized) {
+            pairs->failed = 1;
+            return 0;
+        }
+        pairs->keys = resized;
+        pairs->capacity = grown;
+    }
+    pairs->keys[pairs->count++] = ((uint64_t)trigram << 32) | day;
+    return 1;
+}
+
+// Add the distinct trigrams of a day file. A file that can't be read
+// contributes none, and is retried once its mtime or size moves.
+static void add_day_file(trigram_pairs_t *pairs, date_t date, uint32_t day, const config_t *config) {
+    char path[MAX_PATH_SIZE];
+    mapped_file_t file;
+    if (!get_entry_path(date, path, config) || !map_file(path, &file)) return;
+
+    size_t first = pairs->count;
+    const unsigned char *p = (const unsigned char *)file.data;
+    uint32_t trigram = 0;
+    for (size_t i = 0; i < file.length; i++) {
+        trigram = ((trigram << 8) | fold(p[i])) & (TRIGRAM_LIMIT - 1);
+        if (i < 2) continue;
+        uint64_t bit = (uint64_t)1 << (trigram & 63);
+        if (pairs->seen[trigram >> 6] & bit) continue;
+        pairs->seen[trigram >> 6] |= bit;
+        if (!push_pair(pairs, trigram, day)) break;
+    }
+
+    for (size_t i = first; i < pairs->count; i++) {
+        uint32_t seen = (uint32_t)(pairs->keys[i] >> 32);
+        pairs->seen[seen >> 6] &= ~((uint64_t)1 << (seen & 63));
+    }
+    unmap_file(&file);
+}
+
+// Order pairs by trigram. The day numbers were pushed in ascending order
+// and each pass is stable, so days stay ascending within a trigram.
+static int sort_pairs(trigram_pairs_t *pairs) {
+    if (pairs->count < 2) return 1;
+    uint64_t *scratch = malloc(pairs->count * sizeof(uint64_t));
+    if (!scratch) return 0;
+
+    uint64_t *from = pairs->keys, *to = scratch;
+    for (int shift = 32; shift < 56; shift += 8) {
+        size_t counts[256] = {0};
+        for (size_t i = 0; i < pairs->count; i++) {
+            counts[(from[i] >> shift) & 0xff]++;
+        }
+        size_t position = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t count = counts[b];
+            counts[b] = position;
+            position += count;
+        }
+        for (size_t i = 0; i < pairs->count; i++) {
+            to[counts[(from[i] >> shift) & 0xff]++] = from[i];
+        }
+        uint64_t *swap = from;
+        from = to;
+        to = swap;
+    }
+
+    // Three passes leave the result in scratch
+    pairs->keys = from;
+    free(to);
+    pairs->capacity = pairs->count;
+    return 1;
+}
+
+// Bring the trigram index in line with the journal index. Only day files
+// whose mtime or size changed are read; every other day keeps its place
+// in the posting lists. Returns 0 if memory ran out, leaving the index as
+// it was.
+int trigram_index_update(trigram_index_t *index, const journal_index_t *journal, const config_t *config) {
+    int *kept = malloc((journal->count > 0 ? journal->count : 1) * sizeof(int));
+    if (!kept) return 0;
+
+    // Pair each journal day with its record from the old index
+    int changed = (journal->count != index->day_count);
+    int old = 0;
+    for (int i = 0; i < journal->count; i++) {
+        const index_entry_t *entry = &journal->entries[i];
+        int key = date_to_days(entry->date);
+        while (old < index->day_count && day_key(&index->days[old]) < key) old++;
+        if (old < index->day_count && day_key(&index->days[old]) == key &&
+            index->days[old].mtime == (int64_t)entry->mtime && index->days[old].size == (int64_t)entry->size) {
+            kept[i] = old++;
+        } else {
+            kept[i] = -1;
+            changed = 1;
+        }
+    }
+    if (!changed) {
+        free(kept);
+        return 1;
+    }
+
+    // Both indexes are in date order, so renumbering kept days keeps every
+    // old posting list ascending
+    trigram_pairs_t pairs;
+    memset(&pairs, 0, sizeof(pairs));
+    trigram_day_t *days = calloc(journal->count > 0 ? journal->count : 1, sizeof(trigram_day_t));
+    uint32_t *day_map = malloc((index->day_count > 0 ? index->day_count : 1) * sizeof(uint32_t));
+    pairs.seen = calloc(TRIGRAM_LIMIT / 64, sizeof(uint64_t));
+    int ok = days && day_map && pairs.seen;
+    if (ok) memset(day_map, 0xff, index->day_count * sizeof(uint32_t));  // UINT32_MAX: dropped
+
+    for (int i = 0; ok && i < journal->count; i++) {
+        const index_entry_t *entry = &journal->entries[i];
+        trigram_day_t *day = &days[i];
+        day->mtime = (int64_t)entry->mtime;
+        day->size = (int64_t)entry->size;
+        day->year = (uint16_t)entry->date.year;
+        day->month = (uint8_t)entry->date.month;
+        day->day = (uint8_t)entry->date.day;
+
+        if (kept[i] >= 0) {
+            day_map[kept[i]] = (uint32_t)i;
+        } else {
+            add_day_file(&pairs, entry->date, (uint32_t)i, config);
+            ok = !pairs.failed;
+        }
+    }
+    free(pairs.seen);
+    if (ok) ok = sort_pairs(&pairs);
+
+    // Merge the surviving old postings with the new pairs, trigram by
+    // trigram; the two never share a day
+    trigram_term_t *terms = NULL;
+    uint32_t *postings = NULL;
+    int term_count = 0;
+    size_t posting_count = 0;
+    if (ok) {
+        // Pairs come one per (trigram, day); the term table needs one slot
+        // per distinct trigram, at most the old terms plus the new ones
+        size_t new_terms = 0;
+        for (size_t i = 0; i < pairs.count; i++) {
+            if (i == 0 || (pairs.keys[i] >> 32) != (pairs.keys[i - 1] >> 32)) new_terms++;
+        }
+        terms = malloc(((size_t)index->term_count + new_terms + 1) * sizeof(trigram_term_t));
+        postings = malloc((index->posting_count + pairs.count + 1) * sizeof(uint32_t));
+        ok = terms && postings;
+    }
+
+    int t = 0;
+    size_t n = 0;
+    while (ok && (t < index->term_count || n < pairs.count)) {
+        uint32_t old_trigram = (t < index->term_count) ? index->terms[t].trigram : TRIGRAM_LIMIT;
+        uint32_t new_trigram = (n < pairs.count) ? (uint32_t)(pairs.keys[n] >> 32) : TRIGRAM_LIMIT;
+        uint32_t trigram = old_trigram < new_trigram ? old_trigram : new_trigram;
+
+        const uint32_t *from = NULL;
+        uint32_t from_count = 0;
+        if (old_trigram == trigram) {
+            from = index->postings + index->terms[t].first_posting;
+            from_count = index->terms[t].posting_count;
+            t++;
+        }
+
+        size_t first = posting_count;
+        uint32_t f = 0;
+        for (;;) {
+            while (f < from_count && day_map[from[f]] == UINT32_MAX) f++;
+            int have_new = (n < pairs.count && (uint32_t)(pairs.keys[n] >> 32) == trigram);
+            if (f == from_count && !have_new) break;
+
+            uint32_t new_day = have_new ? (uint32_t)pairs.keys[n] : UINT32_MAX;
+            if (f < from_count && day_map[from[f]] < new_day) {
+                postings[posting_count++] = day_map[from[f++]];
+            } else {
+                postings[posting_count++] = new_day;
+                n++;
+            }
+        }
+
+        if (posting_count > first) {
+            terms[term_count].trigram = trigram;
+            terms[term_count].first_posting = (uint32_t)first;
+            terms[term_count].posting_count = (uint32_t)(posting_count - first);
+            term_count++;
+        }
+    }
+
+    if (ok) {
+        trigram_index_free(index);
+        index->days = days;
+        index->day_count = journal->count;
+        index->terms = terms;
+        index->term_count = term_count;
+        index->postings = postings;
+        index->posting_count = posting_count;
+        index->dirty = 1;
+    } else {
+        free(days);
+        free(terms);
+        free(postings);
+    }
+
+    free(pairs.keys);
+    free(day_map);
+    free(kept);
+    return ok;
+}
+
+// Load the saved index, bring it up to date and write it back if needed
+int trigram_index_open(trigram_index_t *index, const journal_index_t *journal, const config_t *config) {
+    trigram_index_load(index, config);
+    int result = trigram_index_update(index, journal, config);
+    trigram_index_save(index, config);
+    return result;
+}
+
+// Query
+
+static const trigram_term_t* find_trigram(const trigram_index_t *index, uint32_t trigram) {
+    int lo = 0, hi = index->term_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (index->terms[mid].trigram == trigram) return &index->terms[mid];
+        if (index->terms[mid].trigram < trigram) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+// First position in postings[from, count) not below day
+static uint32_t lower_bound(const uint32_t *postings, uint32_t from, uint32_t count, uint32_t day) {
+    uint32_t lo = from, hi = count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (postings[mid] < day) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// The days that may contain a match for pattern, in date order, as a
+// malloc'd array of day numbers. A pattern without a literal of three
+// bytes can't be filtered, so every day is a candidate. Returns 0 if
+// memory ran out.
+int trigram_index_candidates(const trigram_index_t *index, const grep_pattern_t *pattern,
+                             uint32_t **days, int *count) {
+    const trigram_term_t *terms[TRIGRAM_QUERY_MAX];
+    int term_count = 0;
+
+    const char *literal = pattern->literals;
+    for (int l = 0; l < pattern->literal_count; l++) {
+        size_t length = strlen(literal);
+        const unsigned char *p = (const unsigned char *)literal;
+        for (size_t i = 2; i < length && term_count < TRIGRAM_QUERY_MAX; i++) {
+            uint32_t trigram = ((uint32_t)p[i - 2] << 16) | ((uint32_t)p[i - 1] << 8) | p[i];
+            const trigram_term_t *term = find_trigram(index, trigram);
+            if (!term) {
+                // Occurs in no day file
+                *days = NULL;
+                *count = 0;
+                return 1;
+            }
+            int duplicate = 0;
+            for (int j = 0; j < term_count; j++) {
+                if (terms[j] == term) duplicate = 1;
+            }
+            if (!duplicate) terms[term_count++] = term;
+        }
+        literal += length + 1;
+    }
+
+    *days = malloc((index->day_count > 0 ? index->day_count : 1) * sizeof(uint32_t));
+    if (!*days) return 0;
+
+    if (term_count == 0) {
+        for (int i = 0; i < index->day_count; i++) {
+            (*days)[i] = (uint32_t)i;
+        }
+        *count = index->day_count;
+        return 1;
+    }
+
+    // Intersect starting from the rarest list, probing the others
+    for (int i = 1; i < term_count; i++) {
+        for (int j = i; j > 0 && terms[j]->posting_count < terms[j - 1]->posting_count; j--) {
+            const trigram_term_t *swap = terms[j];
+            terms[j] = terms[j - 1];
+            terms[j - 1] = swap;
+        }
+    }
+    uint32_t positions[TRIGRAM_QUERY_MAX] = {0};
+    const uint32_t *rarest = index->postings + terms[0]->first_posting;
+    int found = 0;
+    for (uint32_t i = 0; i < terms[0]->posting_count; i++) {
+        uint32_t day = rarest[i];
+        int match = 1;
+        for (int t = 1; t < term_count && match; t++) {
+            const uint32_t *postings = index->postings + terms[t]->first_posting;
+            positions[t] = lower_bound(postings, positions[t], terms[t]->posting_count, day);
+            match = (positions[t] < terms[t]->posting_count && postings[positions[t]] == day);
+        }
+        if (match) (*days)[found++] = day;
+    }
+    *count = found;
+    return 1;
+}
@@ -12,6 +12,14 @@ int days_in_month(int month, int year) {
     return days[month - 1];
 }
 
+const char* month_name(int month) {
+    static const char *names[] = {
+        "January", "February", "March", "April", "May", "June",
+        "July", "August", "September", "October", "November", "December"
+    };
+    return names[month - 1];
+}
+
 int day_of_week(int year, int month, int day) {
     // Zeller's congruence algorithm
     if (month < 3) {
@@ -66,6 +74,85 @@ int date_compare(date_t a, date_t b) {
     return a.day - b.day;
 }
 
+// Days since 1970-01-01 (proleptic Gregorian), so dates can be used as
+// array indices and compared as integers
+int date_to_days(date_t date) {
+    int year = date.year - (date.month <= 2);
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int year_of_era = year - era * 400;
+    int day_of_year = (153 * (date.month + (date.month > 2 ? -3 : 9)) + 2) / 5 + date.day - 1;
+    int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+date_t days_to_date(int days) {
+    days += 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int day_of_era = days - era * 146097;
+    int year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    int day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int month_index = (5 * day_of_year + 2) / 153;
+    
+    date_t date;
+    date.day = day_of_year - (153 * month_index + 2) / 5 + 1;
+    date.month = month_index < 10 ? month_index + 3 : month_index - 9;
+    date.year = year_of_era + era * 400 + (date.month <= 2);
+    return date;
+}
+
+// Bump allocator for many small strings that are freed together. Blocks
+// are chained, so pointers handed out stay valid as the arena grows.
+#define ARENA_BLOCK_SIZE (16 * 1024)
+
+struct arena_block {
+    struct arena_block *next;
+    size_t used;
+    size_t size;
+    char data[];
+};
+
+void arena_init(arena_t *arena) {
+    arena->head = NULL;
+    arena->total = 0;
+}
+
+void* arena_alloc(arena_t *arena, size_t size) {
+    struct arena_block *block = arena->head;
+    
+    if (!block || block->size - block->used < size) {
+        // Oversized requests get a block of their own
+        size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(struct arena_block) + block_size);
+        if (!block) return NULL;
+        block->next = arena->head;
+        block->used = 0;
+        block->size = block_size;
+        arena->head = block;
+        arena->total += sizeof(struct arena_block) + block_size;
+    }
+    
+    void *ptr = block->data + block->used;
+    block->used += size;
+    return ptr;
+}
+
+char* arena_strdup(arena_t *arena, const char *text) {
+    size_t len = strlen(text) + 1;
+    char *copy = arena_alloc(arena, len);
+    if (copy) memcpy(copy, text, len);
+    return copy;
+}
+
+void arena_free(arena_t *arena) {
+    struct arena_block *block = arena->head;
+    while (block) {
+        struct arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena_init(arena);
+}
+
 void draw_help(void) {
     clear();
     
@@ -79,26 +166,27 @@ void draw_help(void) {
     mvprintw(10, 4, "Enter or n    - Create new entry");
     mvprintw(11, 4, "                (current time for today, custom time for other dates)");
     mvprintw(12, 4, "v             - View existing entries (read-only)");
-    mvprintw(13, 4, "e             - Export entries to HTML/PDF/Markdown");
-    mvprintw(14, 4, "h             - Show this help");
-    mvprintw(15, 4, "q             - Quit application");
-    
-    mvprintw(17, 2, "Entry Format:");
-    mvprintw(18, 4, "- One file per day with time-based sections");
-    mvprintw(19, 4, "- Format: ## HH:MM:SS followed by entry content");
-    mvprintw(20, 4, "- Today: Automatic current time");
-    mvprintw(21, 4, "- Other dates: Prompted for specific time");
-    mvprintw(22, 4, "- Dates with entries are shown in bold");
-    
-    mvprintw(24, 2, "Export Options:");
-    mvprintw(25, 4, "- Date ranges: All, Last 7 days, This month/year, Custom");
-    mvprintw(26, 4, "- Formats: HTML (styled), PDF (requires wkhtmltopdf), Markdown");
-    
-    mvprintw(28, 2, "External Tools:");
-    mvprintw(29, 4, "- Editors: nvim, vim, nano, emacs, vi (first available)");
-    mvprintw(30, 4, "- Viewers: less, more, cat (first available)");
-    
-    mvprintw(32, 2, "Press any key to return...");
+    mvprintw(13, 4, "/             - Search all entries as you type");
+    mvprintw(14, 4, "e             - Export entries to HTML/PDF/Markdown/NDJSON");
+    mvprintw(15, 4, "h             - Show this help");
+    mvprintw(16, 4, "q             - Quit application");
+    
+    mvprintw(18, 2, "Entry Format:");
+    mvprintw(19, 4, "- One file per day with time-based sections");
+    mvprintw(20, 4, "- Format: ## HH:MM:SS followed by entry content");
+    mvprintw(21, 4, "- Today: Automatic current time");
+    mvprintw(22, 4, "- Other dates: Prompted for specific time");
+    mvprintw(23, 4, "- Dates with entries are shown in bold");
+    
+    mvprintw(25, 2, "Export Options:");
+    mvprintw(26, 4, "- Date ranges: All, Last 7 days, This month/year, Custom");
+    mvprintw(27, 4, "- Formats: HTML (styled), HTML site, PDF, Markdown, NDJSON");
+    
+    mvprintw(29, 2, "External Tools:");
+    mvprintw(30, 4, "- Editors: nvim, vim, nano, emacs, vi (first available)");
+    mvprintw(31, 4, "- Viewers: less, more, cat (first available)");
+    
+    mvprintw(33, 2, "Press any key to return...");
     refresh();
     getch();
 }
@@ -114,7 +202,11 @@ void draw_status_bar(app_state_t *state) {
     // Draw status information
     char status[256];
     if (state->mode == MODE_CALENDAR) {
-        int entry_count = count_entries(state->selected_date, &state->config);
+        int entry_count = month_cache_get(&state->month_cache, state->selected_date);
+        if (entry_count < 0) {
+            const index_entry_t *entry = journal_index_find(&state->index, state->selected_date);
+            entry_count = entry ? entry->section_count : 0;
+        }
         if (entry_count == 0) {
             snprintf(status, sizeof(status), "Calendar | Selected: %04d-%02d-%02d | No entry",
                     state->selected_date.year, state->selected_date.month, state->selected_date.day);
@@ -0,0 +1,181 @@
+#define _GNU_SOURCE
+#include "test_framework.h"
+#include "../include/ciary.h"
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int parse(char **args, int count, export_options_t *options, char *error) {
+    return parse_export_args(count, args, options, error, 256);
+}
+
+void test_export_arguments(void) {
+    TEST_CASE("Export Arguments");
+
+    export_options_t options;
+    char error[256];
+
+    char *full[] = {"--from", "2024-01-01", "--to", "2024-12-31", "--format", "pdf", "--out", "/tmp/out"};
+    ASSERT_TRUE(parse(full, 8, &options, error), "All options should parse");
+    ASSERT_EQ(2024, options.start_date.year, "Start year should be parsed");
+    ASSERT_EQ(12, options.end_date.month, "End month should be parsed");
+    ASSERT_EQ(31, options.end_date.day, "End day should be parsed");
+    ASSERT_EQ(EXPORT_FORMAT_PDF, options.format, "Format should be parsed");
+    ASSERT_STR_EQ("/tmp/out", options.output_path, "Output directory should be parsed");
+
+    ASSERT_TRUE(parse(NULL, 0, &options, error), "No options should parse");
+    ASSERT_EQ(EXPORT_FORMAT_HTML, options.format, "HTML should be the default format");
+    ASSERT_EQ(0, options.start_date.year, "Missing start date should be left open");
+    ASSERT_EQ(0, options.end_date.year, "Missing end date should be left open");
+    ASSERT_STR_EQ("", options.output_path, "Missing output directory should be left empty");
+
+    char *formats[][2] = {{"--format", "md"}, {"--format", "markdown"}, {"--format", "site"}};
+    export_format_t expected[] = {EXPORT_FORMAT_MARKDOWN, EXPORT_FORMAT_MARKDOWN, EXPORT_FORMAT_HTML_SITE};
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(parse(formats[i], 2, &options, error) && options.format == expected[i],
+                    "Format names should map to formats");
+    }
+
+    char *bad_date[] = {"--from", "2024-02-30"};
+    ASSERT_FALSE(parse(bad_date, 2, &options, error), "Impossible dates should be rejected");
+    ASSERT_TRUE(strstr(error, "2024-02-30") != NULL, "Error should name the bad value");
+
+    char *short_date[] = {"--to", "2024-1-1"};
+    ASSERT_FALSE(parse(short_date, 2, &options, error), "Dates must be YYYY-MM-DD");
+
+    char *bad_format[] = {"--format", "docx"};
+    ASSERT_FALSE(parse(bad_format, 2, &options, error), "Unknown formats should be rejected");
+
+    char *missing_value[] = {"--out"};
+    ASSERT_FALSE(parse(missing_value, 1, &options, error), "Options without a value should be rejected");
+
+    char *unknown[] = {"--verbose"};
+    ASSERT_FALSE(parse(unknown, 1, &options, error), "Unknown options should be rejected");
+
+    char *site_stdout[] = {"--format", "site", "--out", "-"};
+    ASSERT_FALSE(parse(site_stdout, 4, &options, error), "Site exports can't go to stdout");
+
+    char *piped[] = {"--format", "md", "--out", "-"};
+    ASSERT_TRUE(parse(piped, 4, &options, error) && export_writes_to_stdout(&options),
+                "- should select stdout");
+
+    char *reversed[] = {"--from", "2024-05-01", "--to", "2024-04-01"};
+    ASSERT_FALSE(parse(reversed, 4, &options, error), "Reversed ranges should be rejected");
+}
+
+// The whole command, configured through a temporary HOME
+void test_grep_arguments(void) {
+    TEST_CASE("Grep Arguments");
+
+    int flags, scan;
+    const char *pattern;
+    char error[256];
+
+    char *plain[] = {"coffee"};
+    ASSERT_TRUE(parse_grep_args(1, plain, &flags, &scan, &pattern, error, sizeof(error)), "A pattern alone should parse");
+    ASSERT_EQ(0, flags, "Regex matching case should be the default");
+    ASSERT_STR_EQ("coffee", pattern, "Pattern should be returned");
+
+    char *both[] = {"-F", "-i", "a.b"};
+    ASSERT_TRUE(parse_grep_args(3, both, &flags, &scan, &pattern, error, sizeof(error)) &&
+                flags == (GREP_FIXED | GREP_IGNORE_CASE), "-F and -i should set their flags");
+
+    char *grouped[] = {"-iF", "a.b"};
+    ASSERT_TRUE(parse_grep_args(2, grouped, &flags, &scan, &pattern, error, sizeof(error)) &&
+                flags == (GREP_FIXED | GREP_IGNORE_CASE), "Flags should combine in one argument");
+
+    char *scanned[] = {"--scan", "-i", "a.b"};
+    ASSERT_TRUE(parse_grep_args(3, scanned, &flags, &scan, &pattern, error, sizeof(error)) && scan &&
+                flags == GREP_IGNORE_CASE, "--scan should be accepted among the flags");
+    ASSERT_TRUE(parse_grep_args(1, plain, &flags, &scan, &pattern, error, sizeof(error)) && !scan,
+                "The index should be used by default");
+
+    char *dashed[] = {"--", "-i"};
+    ASSERT_TRUE(parse_grep_args(2, dashed, &flags, &scan, &pattern, error, sizeof(error)) && flags == 0 &&
+                strcmp(pattern, "-i") == 0, "-- should end the options");
+
+    char *missing[] = {"-i"};
+    ASSERT_FALSE(parse_grep_args(1, missing, &flags, &scan, &pattern, error, sizeof(error)), "A pattern is required");
+
+    char *extra[] = {"one", "two"};
+    ASSERT_FALSE(parse_grep_args(2, extra, &flags, &scan, &pattern, error, sizeof(error)), "Only one pattern is allowed");
+
+    char *unknown[] = {"-x", "one"};
+    ASSERT_FALSE(parse_grep_args(2, unknown, &flags, &scan, &pattern, error, sizeof(error)),
+                 "Unknown options should be rejected");
+}
+
+void test_cli_export(void) {
+    TEST_CASE("Command-Line Export");
+
+    char *dir = create_temp_dir();
+    ASSERT_NOT_NULL(dir, "Should create temp directory");
+    if (!dir) return;
+
+    char home[256], path[MAX_PATH_SIZE], journal[300], out[300];
+    snprintf(home, sizeof(home), "%s", dir);
+    snprintf(journal, sizeof(journal), "%s/journal", home);
+    snprintf(out, sizeof(out), "%s/out", home);
+    mkdir(journal, 0755);
+    mkdir(out, 0755);
+
+    const char *old_home = getenv("HOME");
+    char *saved_home = old_home ? strdup(old_home) : NULL;
+    setenv("HOME", home, 1);
+
+    ensure_config_dir();
+    FILE *file = fopen(get_config_path(path), "w");
+    if (file) {
+        fprintf(file, "journal_directory=%s\n", journal);
+        fclose(file);
+    }
+    const char *days[] = {"2024-03-01", "2024-03-09", "2024-04-02"};
+    for (int i = 0; i < 3; i++) {
+        snprintf(path, sizeof(path), "%s/%s.md", journal, days[i]);
+        file = fopen(path, "w");
+        if (file) {
+            fprintf(file, "# %s\n\n## 09:00:00\n\nEntry %d\n", days[i], i);
+            fclose(file);
+        }
+    }
+
+    int status;
+    char *march[] = {"ciary", "export", "--from", "2024-03-01", "--to", "2024-03-31",
+                     "--format", "md", "--out", out, NULL};
+    status = run_cli(10, march);
+    ASSERT_EQ(0, status, "Export should succeed");
+    snprintf(path, sizeof(path), "%s/ciary_export_2024-03-01_to_2024-03-31.md", out);
+    ASSERT_TRUE(access(path, F_OK) == 0, "Export should be written to --out");
+
+    // Open-ended ranges are narrowed to the entries that exist
+    char *all[] = {"ciary", "export", "--out", out, NULL};
+    status = run_cli(4, all);
+    ASSERT_EQ(0, status, "Export of everything should succeed");
+    snprintf(path, sizeof(path), "%s/ciary_export_2024-03-01_to_2024-04-02.html", out);
+    ASSERT_TRUE(access(path, F_OK) == 0, "Open range should be named after the first and last entry");
+
+    char *empty[] = {"ciary", "export", "--from", "2020-01-01", "--to", "2020-01-31", "--out", out, NULL};
+    status = run_cli(8, empty);
+    ASSERT_EQ(1, status, "Empty range should fail");
+
+    char *bad[] = {"ciary", "export", "--format", "docx", NULL};
+    status = run_cli(4, bad);
+    ASSERT_EQ(2, status, "Bad usage should exit with 2");
+
+    char *unknown[] = {"ciary", "frobnicate", NULL};
+    status = run_cli(2, unknown);
+    ASSERT_EQ(2, status, "Unknown commands should exit with 2");
+
+    if (saved_home) {
+        setenv("HOME", saved_home, 1);
+        free(saved_home);
+    }
+    remove_temp_dir(dir);
+}
+
+void run_cli_tests(void) {
+    TEST_SUITE("Command Line");
+
+    test_export_arguments();
+    test_grep_arguments();
+    test_cli_export();
+}
@@ -0,0 +1,194 @@
+#include "test_framework.h"
+#include "../include/ciary.h"
+#include <unistd.h>
+
+// Straightforward per-byte escape used as the reference for the kernels
+static size_t reference_escape(const char *text, size_t length, char *out) {
+    char *o = out;
+    for (size_t i = 0; i < length; i++) {
+        switch (text[i]) {
+            case '<': memcpy(o, "&lt;", 4); o += 4; break;
+            case '>': memcpy(o, "&gt;", 4); o += 4; break;
+            case '&': memcpy(o, "&amp;", 5); o += 5; break;
+            case '"': memcpy(o, "&quot;", 6); o += 6; break;
+            case '\'': memcpy(o, "&#39;", 5); o += 5; break;
+            default: *o++ = text[i]; break;
+        }
+    }
+    *o = '\0';
+    return o - out;
+}
+
+// Escape through a memory sink, as the exporters do, into out
+static size_t escape_with(void (*escape)(output_sink_t *, const char *, size_t),
+                          const char *text, size_t length, char *out) {
+    output_sink_t sink;
+    out[0] = '\0';
+    if (!output_init_memory(&sink)) return 0;
+    escape(&sink, text, length);
+    size_t used = sink.failed ? 0 : sink.used;
+    memcpy(out, sink.buffer, used);
+    out[used] = '\0';
+    output_close(&sink);
+    return used;
+}
+
+static size_t escape_to_string(const char *text, size_t length, char *out) {
+    return escape_with(write_html_escaped, text, length, out);
+}
+
+void test_escape_basics(void) {
+    TEST_CASE("HTML Escaping");
+
+    char out[256];
+    size_t length;
+
+    length = escape_to_string("plain text", 10, out);
+    ASSERT_EQ(10, length, "Clean text should keep its length");
+    ASSERT_STR_EQ("plain text", out, "Clean text should be copied unchanged");
+
+    const char *text = "Fish & <chips> \"quoted\" it's";
+    length = escape_to_string(text, strlen(text), out);
+    ASSERT_STR_EQ("Fish &amp; &lt;chips&gt; &quot;quoted&quot; it&#39;s", out,
+                  "All five special characters should be escaped");
+    ASSERT_EQ(strlen(out), length, "Returned length should match the output");
+
+    length = escape_to_string("", 0, out);
+    ASSERT_EQ(0, length, "Empty input should produce empty output");
+    ASSERT_STR_EQ("", out, "Empty output should be terminated");
+
+    // Bytes outside ASCII (UTF-8 text) pass through untouched
+    const char *utf8 = "caf\xc3\xa9 <\xe2\x80\x94>";
+    length = escape_to_string(utf8, strlen(utf8), out);
+    ASSERT_STR_EQ("caf\xc3\xa9 &lt;\xe2\x80\x94&gt;", out, "UTF-8 bytes should not be escaped");
+}
+
+void test_escape_kernels(void) {
+    TEST_CASE("HTML Escape Kernels");
+
+    // Mostly clean text with specials sprinkled at every offset, plus high
+    // bytes that must not be mistaken for them
+    size_t length = 4096;
+    char *text = malloc(length);
+    char *expected = malloc(length * 6 + 1);
+    char *actual = malloc(length * 6 + 1);
+    if (!text || !expected || !actual) {
+        free(text);
+        free(expected);
+        free(actual);
+        return;
+    }
+
+    static const char specials[] = "<>&\"'";
+    unsigned int seed = 4242;
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned int r = (seed >> 16) % 64;
+        text[i] = (r < 5) ? specials[r] : (r < 8) ? (char)(0x80 + r) : (char)('a' + r % 26);
+    }
+
+    const char *original = html_escape_kernel_name();
+    const char *kernels[] = {"scalar", "sse2", "avx2"};
+
+    for (int k = 0; k < 3; k++) {
+        if (!select_html_escape_kernel(kernels[k])) {
+            printf("⚠ Skipping %s kernel - not supported here\n", kernels[k]);
+            continue;
+        }
+
+        int mismatches = 0;
+        for (size_t start = 0; start < 64 && !mismatches; start++) {
+            size_t span = length - start - (start % 7);
+            size_t expected_length = reference_escape(text + start, span, expected);
+            size_t actual_length = escape_to_string(text + start, span, actual);
+            if (expected_length != actual_length || memcmp(expected, actual, expected_length) != 0) {
+                mismatches++;
+            }
+        }
+
+        // The first special must be found wherever it falls in a block
+        for (size_t offset = 0; offset < 100 && !mismatches; offset++) {
+            char clean[128];
+            memset(clean, 'x', sizeof(clean));
+            clean[offset] = '&';
+            if (find_html_special(clean, clean + sizeof(clean)) != clean + offset) {
+                mismatches++;
+            }
+        }
+
+        char message[128];
+        snprintf(message, sizeof(message), "%s kernel should match the reference escape", kernels[k]);
+        ASSERT_EQ(0, mismatches, message);
+    }
+
+    select_html_escape_kernel(original);
+    ASSERT_STR_EQ(original, html_escape_kernel_name(), "Default kernel should be restored");
+    ASSERT_FALSE(select_html_escape_kernel("neon-on-x86"), "Unknown kernels should be rejected");
+
+    free(text);
+    free(expected);
+    free(actual);
+}
+
+void test_escape_to_sink(void) {
+    TEST_CASE("HTML Escaping Into a Sink");
+
+    char path[256];
+    snprintf(path, sizeof(path), "/tmp/ciary_escape_test_%d.html", getpid());
+
+    output_sink_t sink;
+    ASSERT_TRUE(output_open(&sink, path), "Sink should open");
+    const char *text = "a<b>c\"d'e&f";
+    write_html_escaped(&sink, text, strlen(text));
+    ASSERT_TRUE(output_close(&sink), "Sink should close cleanly");
+
+    mapped_file_t file;
+    ASSERT_TRUE(map_file(path, &file), "Should read back escaped output");
+    const char *expected = "a&lt;b&gt;c&quot;d&#39;e&amp;f";
+    ASSERT_EQ(strlen(expected), file.length, "Escaped length should match");
+    if (file.length == strlen(expected)) {
+        ASSERT_TRUE(memcmp(file.data, expected, file.length) == 0, "Escaped bytes should match");
+    }
+    unmap_file(&file);
+    unlink(path);
+}
+
+void test_json_escape(void) {
+    TEST_CASE("JSON String Escaping");
+
+    char out[256];
+    const char *text = "say \"hi\"\\\n\t\x01";
+    escape_with(write_json_escaped, text, strlen(text), out);
+    ASSERT_STR_EQ("say \\\"hi\\\"\\\\\\n\\t\\u0001", out,
+                  "Quotes, backslashes and control characters should be escaped");
+
+    // Valid UTF-8 of every length passes through untouched
+    const char *utf8 = "caf\xc3\xa9 \xe2\x80\x94 \xf0\x9f\x93\x93";
+    escape_with(write_json_escaped, utf8, strlen(utf8), out);
+    ASSERT_STR_EQ(utf8, out, "Valid UTF-8 should be copied unchanged");
+
+    // Each byte outside a valid sequence becomes U+FFFD
+    const char *invalid = "ok \xff\xfe bad";
+    escape_with(write_json_escaped, invalid, strlen(invalid), out);
+    ASSERT_STR_EQ("ok \\ufffd\\ufffd bad", out, "Invalid bytes should be replaced");
+
+    const char *overlong = "\xc0\xaf \xed\xa0\x80 \xf4\x90\x80\x80";
+    escape_with(write_json_escaped, overlong, strlen(overlong), out);
+    ASSERT_STR_EQ("\\ufffd\\ufffd \\ufffd\\ufffd\\ufffd \\ufffd\\ufffd\\ufffd\\ufffd", out,
+                  "Overlong forms, surrogates and code points past U+10FFFF should be replaced");
+
+    // A sequence cut short, mid-text or at the end
+    const char *truncated = "a\xe2\x80" "b\xf0\x9f\x93";
+    escape_with(write_json_escaped, truncated, strlen(truncated), out);
+    ASSERT_STR_EQ("a\\ufffd\\ufffdb\\ufffd\\ufffd\\ufffd", out,
+                  "Truncated sequences should be replaced byte by byte");
+}
+
+void run_escape_tests(void) {
+    TEST_SUITE("HTML Escaping");
+
+    test_escape_basics();
+    test_escape_kernels();
+    test_escape_to_sink();
+    test_json_escape();
+}
@@ -1,8 +1,10 @@
+#define _GNU_SOURCE
 #include "test_framework.h"
 #include "../include/ciary.h"
 #include <sys/stat.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <fcntl.h>
 
 // Use external test counters from framework
 extern int test_count;
@@ -96,6 +98,14 @@ void test_date_parsing(void) {
     // Test malformed date
     result = parse_date_from_filename("2024-13-45.md", &parsed_date);
     ASSERT_FALSE(result, "Should fail to parse invalid date values");
+    
+    // Only canonical names of real dates map to a day
+    result = parse_date_from_filename("2024-07-1a.md", &parsed_date);
+    ASSERT_FALSE(result, "Should reject non-digit characters");
+    result = parse_date_from_filename("2023-02-29.md", &parsed_date);
+    ASSERT_FALSE(result, "Should reject days past the end of the month");
+    result = parse_date_from_filename("2024-02-29.md", &parsed_date);
+    ASSERT_TRUE(result, "Should accept leap days");
 }
 
 // Test chronological sorting
@@ -125,37 +135,81 @@ void test_chronological_sorting(void) {
     strcpy(config.journal_directory, test_dir);
     
     // Test collection and sorting
-    char **entry_files;
-    int file_count;
+    entry_list_t entries;
     
-    bool collection_result = collect_entries_in_range(&options, &config, &entry_files, &file_count);
+    bool collection_result = collect_entries_in_range(&options, &config, &entries);
     ASSERT_TRUE(collection_result, "Should successfully collect entries");
-    ASSERT_EQ(4, file_count, "Should find all 4 test entries");
+    ASSERT_EQ(4, entries.count, "Should find all 4 test entries");
     
-    if (collection_result && file_count == 4) {
+    if (collection_result && entries.count == 4) {
         // Check chronological order
-        char* filename1 = strrchr(entry_files[0], '/');
-        char* filename2 = strrchr(entry_files[1], '/');
-        char* filename3 = strrchr(entry_files[2], '/');
-        char* filename4 = strrchr(entry_files[3], '/');
+        const char* filename1 = strrchr(entries.items[0].path, '/');
+        const char* filename2 = strrchr(entries.items[1].path, '/');
+        const char* filename3 = strrchr(entries.items[2].path, '/');
+        const char* filename4 = strrchr(entries.items[3].path, '/');
         
-        if (filename1) filename1++; else filename1 = entry_files[0];
-        if (filename2) filename2++; else filename2 = entry_files[1];
-        if (filename3) filename3++; else filename3 = entry_files[2];
-        if (filename4) filename4++; else filename4 = entry_files[3];
+        if (filename1) filename1++; else filename1 = entries.items[0].path;
+        if (filename2) filename2++; else filename2 = entries.items[1].path;
+        if (filename3) filename3++; else filename3 = entries.items[2].path;
+        if (filename4) filename4++; else filename4 = entries.items[3].path;
         
         ASSERT_STR_EQ("2024-07-20.md", filename1, "First file should be oldest date");
         ASSERT_STR_EQ("2024-07-21.md", filename2, "Second file should be second oldest");
         ASSERT_STR_EQ("2024-07-23.md", filename3, "Third file should be third oldest");
         ASSERT_STR_EQ("2024-07-25.md", filename4, "Fourth file should be newest date");
-        
-        // Cleanup allocated memory
-        for (int i = 0; i < file_count; i++) {
-            free(entry_files[i]);
-        }
-        free(entry_files);
+        ASSERT_EQ(21, entries.items[1].date.day, "Entry dates should travel with their paths");
     }
     
+    // Cleanup allocated memory
+    free_entry_list(&entries);
+    
+    cleanup_test_journal_dir(test_dir);
+}
+
+// Test that large journals are collected completely
+void test_large_collection(void) {
+    TEST_CASE("Large Journal Collection");
+    
+    char* test_dir = create_test_journal_dir();
+    if (!test_dir) {
+        return;
+    }
+    
+    // Four years of daily entries, well past the old 1000-file limit
+    date_t date = {2020, 1, 1};
+    int created = 0;
+    for (int i = 0; i < 1461; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "%04d-%02d-%02d", date.year, date.month, date.day);
+        create_test_entry(test_dir, name, "## 12:00:00\n\nDaily");
+        created++;
+        date_add_days(&date, 1);
+    }
+    
+    export_options_t options;
+    memset(&options, 0, sizeof(options));
+    calculate_date_range(DATE_RANGE_ALL, (date_t){2024, 1, 1}, &options.start_date, &options.end_date);
+    
+    config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.journal_directory, test_dir);
+    
+    entry_list_t entries;
+    ASSERT_TRUE(collect_entries_in_range(&options, &config, &entries), "Should collect a large journal");
+    ASSERT_EQ(created, entries.count, "Every day file should be collected");
+    
+    int ordered = 1;
+    for (int i = 1; i < entries.count; i++) {
+        if (date_compare(entries.items[i - 1].date, entries.items[i].date) >= 0) ordered = 0;
+    }
+    ASSERT_TRUE(ordered, "Large collection should stay chronological");
+    
+    // Paths share one arena sized by their actual length, not MAX_PATH_SIZE each
+    ASSERT_TRUE(entries.paths.total < (size_t)created * 128, "Path storage should be proportional to path lengths");
+    
+    free_entry_list(&entries);
+    ASSERT_EQ(0, entries.count, "Freed list should be empty");
+    
     cleanup_test_journal_dir(test_dir);
 }
 
@@ -282,16 +336,721 @@ void test_markdown_export(void) {
     cleanup_test_journal_dir(test_dir);
 }
 
+// Test HTML export functionality
+void test_html_export(void) {
+    TEST_CASE("HTML Export Functionality");
+    
+    char* test_dir = create_test_journal_dir();
+    if (!test_dir) {
+        return;
+    }
+    
+    create_test_entry(test_dir, "2024-07-16",
+                      "## 08:15:00\n\nFish & <chips>\n#hashtag line\n\n## 20:00:00\n\nEvening");
+    
+    export_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.start_date = (date_t){2024, 7, 16};
+    options.end_date = (date_t){2024, 7, 16};
+    options.format = EXPORT_FORMAT_HTML;
+    strcpy(options.output_path, "/tmp");
+    
+    config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.journal_directory, test_dir);
+    
+    bool export_result = export_entries(&options, &config);
+    ASSERT_TRUE(export_result, "HTML export should succeed");
+    
+    const char *expected_file = "/tmp/ciary_export_2024-07-16_to_2024-07-16.html";
+    FILE* export_file = fopen(expected_file, "r");
+    ASSERT_NOT_NULL(export_file, "HTML export file should be created");
+    
+    if (export_file) {
+        char buffer[1024];
+        int sections = 0;
+        bool found_escaped = false;
+        bool found_hashtag = false;
+        bool found_date_header = false;
+        
+        while (fgets(buffer, sizeof(buffer), export_file)) {
+            if (strstr(buffer, "<div class=\"entry-time\">")) sections++;
+            if (strstr(buffer, "Fish &amp; &lt;chips&gt;")) found_escaped = true;
+            if (strstr(buffer, "#hashtag line</p>")) found_hashtag = true;
+            if (strstr(buffer, "<p># 2024-07-16</p>")) found_date_header = true;
+        }
+        
+        ASSERT_EQ(2, sections, "Each time header should open a section");
+        ASSERT_TRUE(found_escaped, "Content should be HTML-escaped");
+        ASSERT_TRUE(found_hashtag, "Lines starting with '#' but not headers should be content");
+        ASSERT_FALSE(found_date_header, "Date header should not be repeated as content");
+        
+        fclose(export_file);
+        unlink(expected_file);
+    }
+    
+    cleanup_test_journal_dir(test_dir);
+}
+
+void test_output_sink(void) {
+    TEST_CASE("Buffered Output Sink");
+    
+    char* test_dir = create_test_journal_dir();
+    if (!test_dir) {
+        return;
+    }
+    
+    char path[512];
+    snprintf(path, sizeof(path), "%s/sink.out", test_dir);
+    
+    // A block larger than the sink's buffer goes straight through writev
+    size_t big_length = 1024 * 1024;
+    char *big = malloc(big_length);
+    ASSERT_NOT_NULL(big, "Should allocate test block");
+    if (!big) {
+        cleanup_test_journal_dir(test_dir);
+        return;
+    }
+    for (size_t i = 0; i < big_length; i++) {
+        big[i] = 'a' + (i % 26);
+    }
+    
+    output_sink_t sink;
+    ASSERT_TRUE(output_open(&sink, path), "Sink should open output file");
+    output_puts(&sink, "head:");
+    output_printf(&sink, "%d-%02d|", 2024, 7);
+    write_html_escaped(&sink, "a<b>&c", 6);
+    output_write(&sink, big, big_length);
+    write_html_escaped(&sink, "&&", 2);
+    ASSERT_TRUE(output_close(&sink), "Sink should flush and close cleanly");
+    
+    mapped_file_t file;
+    ASSERT_TRUE(map_file(path, &file), "Should read back sink output");
+    const char *prefix = "head:2024-07|a&lt;b&gt;&amp;c";
+    size_t prefix_length = strlen(prefix);
+    ASSERT_EQ(prefix_length + big_length + 10, file.length, "Output length should match everything written");
+    if (file.length == prefix_length + big_length + 10) {
+        ASSERT_TRUE(memcmp(file.data, prefix, prefix_length) == 0, "Small writes and escapes should come first");
+        ASSERT_TRUE(memcmp(file.data + prefix_length, big, big_length) == 0, "Large block should follow in order");
+        ASSERT_TRUE(memcmp(file.data + prefix_length + big_length, "&amp;&amp;", 10) == 0,
+                    "Escaped tail should be last");
+    }
+    unmap_file(&file);
+    
+    ASSERT_FALSE(output_open(&sink, "/nonexistent/dir/sink.out"), "Opening an unwritable path should fail");
+    ASSERT_FALSE(output_close(&sink), "Closing a failed sink should report failure");
+    
+    free(big);
+    cleanup_test_journal_dir(test_dir);
+}
+
+// Read a whole export file into a heap buffer
+static char* read_export_file(const char *path, size_t *length) {
+    mapped_file_t file;
+    if (!map_file(path, &file)) return NULL;
+    char *copy = malloc(file.length + 1);
+    if (copy) {
+        memcpy(copy, file.data, file.length);
+        copy[file.length] = '\0';
+        *length = file.length;
+    }
+    unmap_file(&file);
+    return copy;
+}
+
+void test_file_splicing(void) {
+    TEST_CASE("Spliced File Copy");
+    
+    char* test_dir = create_test_journal_dir();
+    if (!test_dir) {
+        return;
+    }
+    
+    // Larger than the sink buffer, so every copy path has to loop
+    size_t length = 3 * 1024 * 1024 + 17;
+    char *content = malloc(length);
+    ASSERT_NOT_NULL(content, "Should allocate source content");
+    if (!content) {
+        cleanup_test_journal_dir(test_dir);
+        return;
+    }
+    for (size_t i = 0; i < length; i++) {
+        content[i] = (i % 61 == 60) ? '\n' : 'A' + (i % 23);
+    }
+    
+    char source[512], target[512];
+    snprintf(source, sizeof(source), "%s/source.md", test_dir);
+    snprintf(target, sizeof(target), "%s/target.md", test_dir);
+    FILE *file = fopen(source, "w");
+    if (file) {
+        fwrite(content, 1, length, file);
+        fclose(file);
+    }
+    
+    output_sink_t sink;
+    ASSERT_TRUE(output_open(&sink, target), "Sink should open");
+    output_puts(&sink, "head\n");
+    ASSERT_TRUE(output_splice_file(&sink, source), "Splicing an existing file should succeed");
+    output_puts(&sink, "tail\n");
+    ASSERT_FALSE(output_splice_file(&sink, "/nonexistent/day.md"), "Missing source should be reported");
+    ASSERT_TRUE(output_close(&sink), "A missing source should not fail the sink");
+    
+    size_t copied_length = 0;
+    char *copied = read_export_file(target, &copied_length);
+    ASSERT_EQ(length + 10, copied_length, "Output should hold header, file and trailer");
+    if (copied && copied_length == length + 10) {
+        ASSERT_TRUE(memcmp(copied, "head\n", 5) == 0, "Buffered header should be flushed first");
+        ASSERT_TRUE(memcmp(copied + 5, content, length) == 0, "File content should be copied unchanged");
+        ASSERT_TRUE(memcmp(copied + 5 + length, "tail\n", 5) == 0, "Trailer should follow the file");
+    }
+    free(copied);
+    
+    // Memory sinks take the same call
+    ASSERT_TRUE(output_init_memory(&sink), "Memory sink should start");
+    ASSERT_TRUE(output_splice_file(&sink, source), "Splicing into memory should succeed");
+    ASSERT_TRUE(sink.used == length && memcmp(sink.buffer, content, length) == 0,
+                "Memory sink should hold the file content");
+    output_close(&sink);
+    
+    free(content);
+    cleanup_test_journal_dir(test_dir);
+}
+
+void test_parallel_export(void) {
+    TEST_CASE("Parallel Export Ordering");
+    
+    char* test_dir = create_test_journal_dir();
+    if (!test_dir) {
+        return;
+    }
+    
+    // Day files of very different sizes so workers finish out of order
+    date_t date = {2023, 1, 1};
+    char content[8192];
+    for (int day = 0; day < 300; day++) {
+        char name[16];
+        snprintf(name, sizeof(name), "%d-%02d-%02d", date.year, date.month, date.day);
+        int repeat = (day * 37) % 60;
+        size_t used = (size_t)snprintf(content, sizeof(content), "## 09:00:00\n\nDay %d <%s>\n", day, name);
+        for (int r = 0; r < repeat && used + 64 < sizeof(content); r++) {
+            used += (size_t)snprintf(content + used, sizeof(content) - used, "Filler line %d & more text.\n", r);
+        }
+        create_test_entry(test_dir, name, content);
+        date_add_days(&date, 1);
+    }
+    
+    export_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.start_date = (date_t){2023, 1, 1};
+    options.end_date = (date_t){2023, 12, 31};
+    strcpy(options.output_path, test_dir);
+    
+    config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.journal_directory, test_dir);
+    
+    entry_list_t entries;
+    ASSERT_TRUE(collect_entries_in_range(&options, &config, &entries), "Should collect entries");
+    ASSERT_EQ(300, entries.count, "Should collect every day file");
+    
+    const char *suffixes[] = {"html", "md"};
+    for (int f = 0; f < 2; f++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/ciary_export_2023-01-01_to_2023-12-31.%s", test_dir, suffixes[f]);
+        
+        size_t sequential_length = 0, parallel_length = 0;
+        export_set_worker_count(1);
+        int ok = (f == 0) ? export_to_html(&options, &config, &entries)
+                          : export_to_markdown(&options, &config, &entries);
+        ASSERT_TRUE(ok, "Sequential export should succeed");
+        char *sequential = read_export_file(path, &sequential_length);
+        
+        export_set_worker_count(3);
+        ok = (f == 0) ? export_to_html(&options, &config, &entries)
+                      : export_to_markdown(&options, &config, &entries);
+        ASSERT_TRUE(ok, "Parallel export should succeed");
+        char *parallel = read_export_file(path, &parallel_length);
+        
+        ASSERT_NOT_NULL(sequential, "Sequential output should exist");
+        ASSERT_NOT_NULL(parallel, "Parallel output should exist");
+        if (sequential && parallel) {
+            ASSERT_TRUE(sequential_length == parallel_length &&
+                        memcmp(sequential, parallel, sequential_length) == 0,
+                        "Parallel output should match sequential output byte for byte");
+            
+            // Days must appear in chronological order
+            const char *p = parallel;
+            int in_order = 1;
+            for (int day = 0; day < 300 && in_order; day++) {
+                char marker[32];
+                snprintf(marker, sizeof(marker), "Day %d ", day);
+                const char *found = strstr(p, marker);
+                if (!found) in_order = 0;
+                else p = found;
+            }
+            ASSERT_TRUE(in_order, "Days should be written in chronological order");
+        }
+        free(sequential);
+        free(parallel);
+    }
+    export_set_worker_count(0);
+    
+    free_entry_list(&entries);
+    cleanup_test_journal_dir(test_dir);
+}
+
+void test_fragment_cache(void) {
+    TEST_CASE("HTML Fragment Cache");
+    
+    char* test_dir = create_test_journal_dir();
+    if (!test_dir) {
+        return;
+    }
+    
+    create_test_entry(test_dir, "2024-03-01", "## 09:00:00\n\nFirst day");
+    create_test_entry(test_dir, "2024-03-02", "## 09:00:00\n\nSecond day");
+    
+    export_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.start_date = (date_t){2024, 3, 1};
+    options.end_date = (date_t){2024, 3, 2};
+    strcpy(options.output_path, test_dir);
+    
+    config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.journal_directory, test_dir);
+    
+    char output_file[512], fragment[512];
+    snprintf(output_file, sizeof(output_file), "%s/ciary_export_2024-03-01_to_2024-03-02.html", test_dir);
+    snprintf(fragment, sizeof(fragment), "%s/%s/html", test_dir, EXPORT_CACHE_DIR);
+    
+    entry_list_t entries;
+    ASSERT_TRUE(collect_entries_in_range(&options, &config, &entries), "Should collect entries");
+    ASSERT_TRUE(export_to_html(&options, &config, &entries), "First export should succeed");
+    ASSERT_TRUE(access(fragment, F_OK) == 0, "Rendering should write the fragment pack");
+    
+    size_t first_length = 0;
+    char *first = read_export_file(output_file, &first_length);
+    
+    // Plant a marker in the cached fragment; a cache hit copies it through
+    size_t fragment_length = 0;
+    char *cached = read_export_file(fragment, &fragment_length);
+    char *body = cached ? strstr(cached + 24, "<p>First day") : NULL;
+    ASSERT_NOT_NULL(body, "Fragment pack should hold the rendered day");
+    if (body) body += 3;
+    if (body) {
+        memcpy(body, "Cache hit", 9);
+        FILE *file = fopen(fragment, "w");
+        if (file) {
+            fwrite(cached, 1, fragment_length, file);
+            fclose(file);
+        }
+    }
+    
+    ASSERT_TRUE(export_to_html(&options, &config, &entries), "Repeat export should succeed");
+    size_t second_length = 0;
+    char *second = read_export_file(output_file, &second_length);
+    ASSERT_TRUE(second && strstr(second, "Cache hit") != NULL, "Unchanged day should come from the cache");
+    ASSERT_TRUE(second && strstr(second, "Second day") != NULL, "Other days should still be present");
+    ASSERT_EQ(first_length, second_length, "Stitched output should keep the same layout");
+    free(second);
+    
+    // Changing the day file (different size) invalidates its fragment
+    create_test_entry(test_dir, "2024-03-01", "## 09:00:00\n\nFirst day, edited");
+    ASSERT_TRUE(export_to_html(&options, &config, &entries), "Export after an edit should succeed");
+    char *third = read_export_file(output_file, &second_length);
+    ASSERT_TRUE(third && strstr(third, "First day, edited") != NULL, "Edited day should be re-rendered");
+    ASSERT_TRUE(third && strstr(third, "Cache hit") == NULL, "Stale fragment should not be used");
+    ASSERT_TRUE(third && strstr(third, "Second day") != NULL, "Unchanged days should survive the update");
+    free(third);
+    
+    // A narrower export must not drop fragments for days outside its range
+    options.end_date = (date_t){2024, 3, 1};
+    entry_list_t first_day;
+    ASSERT_TRUE(collect_entries_in_range(&options, &config, &first_day), "Should collect one day");
+    create_test_entry(test_dir, "2024-03-01", "## 09:00:00\n\nFirst day, edited twice");
+    ASSERT_TRUE(export_to_html(&options, &config, &first_day), "Single-day export should succeed");
+    free_entry_list(&first_day);
+    
+    char *pack = read_export_file(fragment, &fragment_length);
+    int found_second = 0;
+    for (size_t i = 0; pack && i + 10 <= fragment_length; i++) {
+        if (memcmp(pack + i, "Second day", 10) == 0) found_second = 1;
+    }
+    ASSERT_TRUE(found_second, "Fragments outside the export range should be kept");
+    free(pack);
+    
+    free(first);
+    free(cached);
+    free_entry_list(&entries);
+    cleanup_test_journal_dir(test_dir);
+}
+
+void test_html_site_export(void) {
+    TEST_CASE("Sharded HTML Export");
+    
+    char* test_dir = create_test_journal_dir();
+    if (!test_dir) {
+        return;
+    }
+    
+    create_test_entry(test_dir, "2024-01-15", "## 09:00:00\n\nJanuary one");
+    create_test_entry(test_dir, "2024-01-20", "## 09:00:00\n\nJanuary two");
+    create_test_entry(test_dir, "2024-02-03", "## 09:00:00\n\nFebruary only");
+    create_test_entry(test_dir, "2025-03-01", "## 09:00:00\n\nNext year");
+    
+    export_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.start_date = (date_t){2024, 1, 1};
+    options.end_date = (date_t){2025, 12, 31};
+    options.format = EXPORT_FORMAT_HTML_SITE;
+    strcpy(options.output_path, test_dir);
+    
+    config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.journal_directory, test_dir);
+    
+    entry_list_t entries;
+    ASSERT_TRUE(collect_entries_in_range(&options, &config, &entries), "Should collect entries");
+    export_set_worker_count(2);
+    ASSERT_TRUE(export_to_html_site(&options, &config, &entries), "Sharded export should succeed");
+    export_set_worker_count(0);
+    
+    char path[512];
+    size_t length = 0;
+    snprintf(path, sizeof(path), "%s/ciary_export_2024-01-01_to_2025-12-31/index.html", test_dir);
+    char *index = read_export_file(path, &length);
+    ASSERT_NOT_NULL(index, "Index page should be written");
+    ASSERT_TRUE(index && strstr(index, "<h2>2024</h2>") && strstr(index, "<h2>2025</h2>"),
+                "Index should group months by year");
+    ASSERT_TRUE(index && strstr(index, "<a href=\"2024-01.html\">January</a> (2 entries)"),
+                "Index should link each month with its entry count");
+    ASSERT_TRUE(index && strstr(index, "<style>"), "Index should use the export stylesheet");
+    
+    snprintf(path, sizeof(path), "%s/ciary_export_2024-01-01_to_2025-12-31/2024-01.html", test_dir);
+    char *january = read_export_file(path, &length);
+    ASSERT_TRUE(january && strstr(january, "January one") && strstr(january, "January two"),
+                "Month page should hold all of its days");
+    ASSERT_TRUE(january && !strstr(january, "February only"), "Month page should hold only its days");
+    ASSERT_TRUE(january && strstr(january, "February 2024 &rarr;"), "Month page should link the next month");
+    ASSERT_TRUE(january && !strstr(january, "&larr;"), "First month should have no previous link");
+    
+    snprintf(path, sizeof(path), "%s/ciary_export_2024-01-01_to_2025-12-31/2024-02.html", test_dir);
+    char *february = read_export_file(path, &length);
+    ASSERT_TRUE(february && strstr(february, "href=\"2024-01.html\"") &&
+                strstr(february, "href=\"2025-03.html\"") && strstr(february, "href=\"index.html\""),
+                "Navigation should skip months without entries");
+    
+    snprintf(path, sizeof(path), "%s/ciary_export_2024-01-01_to_2025-12-31/2025-03.html", test_dir);
+    char *march = read_export_file(path, &length);
+    ASSERT_TRUE(march && strstr(march, "Next year") && strstr(march, "</html>"),
+                "Last month page should be complete");
+    
+    free(index);
+    free(january);
+    free(february);
+    free(march);
+    free_entry_list(&entries);
+    cleanup_test_journal_dir(test_dir);
+}
+
+// Check every xref entry points at its "N 0 obj" line; returns the
+// number of objects, or -1 if the table is broken
+static int check_pdf_xref(const char *pdf, size_t length) {
+    const char *startxref = NULL;
+    for (const char *p = pdf; (p = strstr(p, "startxref\n")) != NULL; p++) {
+        startxref = p;
+    }
+    if (!startxref) return -1;
+    size_t xref = strtoul(startxref + 10, NULL, 10);
+    if (xref >= length || strncmp(pdf + xref, "xref\n0 ", 7) != 0) return -1;
+    
+    char *p;
+    int count = (int)strtol(pdf + xref + 7, &p, 10);
+    p = strchr(p, '\n') + 1 + 20;  // Skip the free entry
+    for (int i = 1; i < count; i++, p += 20) {
+        size_t offset = strtoul(p, NULL, 10);
+        char expected[32];
+        int n = snprintf(expected, sizeof(expected), "%d 0 obj\n", i);
+        if (offset >= length || strncmp(pdf + offset, expected, n) != 0) return -1;
+    }
+    return count;
+}
+
+void test_pdf_export(void) {
+    TEST_CASE("PDF Export");
+    
+    char* test_dir = create_test_journal_dir();
+    if (!test_dir) {
+        return;
+    }
+    
+    // Enough text for several pages, with one line far wider than a page
+    char content[8192];
+    size_t used = (size_t)snprintf(content, sizeof(content),
+                                   "## 09:15:00\n\nCaf\xC3\xA9 (with \\backslash) \xE2\x80\x94 done\n\n"
+                                   "```\n  indented code\n```\n### Notes\n");
+    for (int i = 0; i < 60 && used + 100 < sizeof(content); i++) {
+        used += (size_t)snprintf(content + used, sizeof(content) - used, "word%d ", i);
+    }
+    create_test_entry(test_dir, "2024-05-01", content);
+    for (int day = 2; day <= 20; day++) {
+        char name[16];
+        snprintf(name, sizeof(name), "2024-05-%02d", day);
+        create_test_entry(test_dir, name, "## 10:00:00\n\nLine one\nLine two\n\nLine three");
+    }
+    
+    export_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.start_date = (date_t){2024, 5, 1};
+    options.end_date = (date_t){2024, 5, 31};
+    options.format = EXPORT_FORMAT_PDF;
+    strcpy(options.output_path, test_dir);
+    
+    config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.journal_directory, test_dir);
+    
+    entry_list_t entries;
+    ASSERT_TRUE(collect_entries_in_range(&options, &config, &entries), "Should collect entries");
+    ASSERT_TRUE(export_to_pdf(&options, &config, &entries), "PDF export should succeed");
+    
+    char output_file[512];
+    size_t length = 0;
+    snprintf(output_file, sizeof(output_file), "%s/ciary_export_2024-05-01_to_2024-05-31.pdf", test_dir);
+    char *pdf = read_export_file(output_file, &length);
+    ASSERT_NOT_NULL(pdf, "PDF file should be written");
+    if (pdf) {
+        ASSERT_TRUE(strncmp(pdf, "%PDF-1.4\n", 9) == 0, "File should start with the PDF header");
+        ASSERT_TRUE(length > 6 && strcmp(pdf + length - 6, "%%EOF\n") == 0, "File should end with %%EOF");
+        
+        int objects = check_pdf_xref(pdf, length);
+        ASSERT_TRUE(objects > 9, "Xref table should point at every object");
+        
+        // Pages are searched in order; binary data in the file is fine
+        // for strstr as long as it holds no NUL bytes
+        int pages = 0;
+        for (const char *p = pdf; (p = strstr(p, "/Type /Page /Parent")) != NULL; p++) pages++;
+        ASSERT_TRUE(pages >= 2, "Long exports should span several pages");
+        ASSERT_EQ(pages, (objects - 9) / 2, "Each page should have a content stream and a page object");
+        
+        char count[32];
+        snprintf(count, sizeof(count), "/Count %d ", pages);
+        ASSERT_TRUE(strstr(pdf, count) != NULL, "Page tree should count every page");
+        ASSERT_TRUE(strstr(pdf, "(Wednesday 1 May 2024) Tj") != NULL, "Days should get a heading");
+        ASSERT_TRUE(strstr(pdf, "(09:15:00) Tj") != NULL, "Time sections should get a heading");
+        ASSERT_TRUE(strstr(pdf, "(Caf\xE9 \\(with \\\\backslash\\) \x97 done) Tj") != NULL,
+                    "Text should be WinAnsi-encoded and escaped");
+        ASSERT_TRUE(strstr(pdf, "/F4 9.50 Tf 56.00") && strstr(pdf, "(  indented code) Tj"),
+                    "Code should be set in Courier with its indentation");
+        ASSERT_TRUE(strstr(pdf, "(Notes) Tj") != NULL, "Markdown headings should drop their markers");
+        int wrapped_lines = 0;
+        for (const char *p = pdf; (p = strstr(p, "Td (word")) != NULL; p++) wrapped_lines++;
+        ASSERT_TRUE(wrapped_lines >= 3 && strstr(pdf, "word59) Tj") != NULL,
+                    "Long lines should wrap at spaces");
+        ASSERT_TRUE(strstr(pdf, "(# 2024-05-01)") == NULL, "Date headers should not be printed");
+        free(pdf);
+    }
+    
+    free_entry_list(&entries);
+    cleanup_test_journal_dir(test_dir);
+}
+
 // Main test runner for export functionality
+void test_ndjson_export(void) {
+    TEST_CASE("NDJSON Export");
+    
+    char* test_dir = create_test_journal_dir();
+    if (!test_dir) {
+        return;
+    }
+    
+    create_test_entry(test_dir, "2024-05-01",
+                      "Before any time\n\n"
+                      "## 09:00:00\n\nSaid \"hi\" \\ back\n\tindented\x01\n\n"
+                      "## 10:30:00\n\nCaf\xc3\xa9 \xe2\x98\x95\n\n"
+                      "## 11:00:00\n");
+    create_test_entry(test_dir, "2024-05-02", "## 08:00:00\n\nSecond day");
+    
+    export_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.start_date = (date_t){2024, 5, 1};
+    options.end_date = (date_t){2024, 5, 31};
+    options.format = EXPORT_FORMAT_NDJSON;
+    strcpy(options.output_path, test_dir);
+    
+    config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.journal_directory, test_dir);
+    
+    int count = 0;
+    export_status_t status = run_export(&options, &config, &count);
+    ASSERT_EQ(EXPORT_OK, status, "NDJSON export should succeed");
+    ASSERT_EQ(2, count, "Both days should be exported");
+    
+    char path[512];
+    size_t length = 0;
+    snprintf(path, sizeof(path), "%s/ciary_export_2024-05-01_to_2024-05-31.ndjson", test_dir);
+    char *ndjson = read_export_file(path, &length);
+    ASSERT_NOT_NULL(ndjson, "NDJSON file should be written");
+    
+    const char *expected =
+        "{\"date\":\"2024-05-01\",\"time\":null,\"text\":\"Before any time\"}\n"
+        "{\"date\":\"2024-05-01\",\"time\":\"09:00:00\",\"text\":\"Said \\\"hi\\\" \\\\ back\\n\\tindented\\u0001\"}\n"
+        "{\"date\":\"2024-05-01\",\"time\":\"10:30:00\",\"text\":\"Caf\xc3\xa9 \xe2\x98\x95\"}\n"
+        "{\"date\":\"2024-05-01\",\"time\":\"11:00:00\",\"text\":\"\"}\n"
+        "{\"date\":\"2024-05-02\",\"time\":\"08:00:00\",\"text\":\"Second day\"}\n";
+    ASSERT_STR_EQ(expected, ndjson ? ndjson : "", "Each time section should be one escaped JSON line");
+    free(ndjson);
+    
+    // A day file that can't be read fails the export
+    entry_list_t entries;
+    init_entry_list(&entries);
+    snprintf(path, sizeof(path), "%s/2024-05-01.md", test_dir);
+    add_entry_file(&entries, (date_t){2024, 5, 1}, path);
+    snprintf(path, sizeof(path), "%s/2024-05-09.md", test_dir);
+    add_entry_file(&entries, (date_t){2024, 5, 9}, path);
+    ASSERT_FALSE(export_to_ndjson(&options, &config, &entries), "A missing day file should fail the export");
+    free_entry_list(&entries);
+    
+    cleanup_test_journal_dir(test_dir);
+}
+
+// Header-looking lines inside a fenced code block are code, not sections
+void test_fenced_headers(void) {
+    TEST_CASE("Headers Inside Fenced Code");
+    
+    char* test_dir = create_test_journal_dir();
+    if (!test_dir) {
+        return;
+    }
+    
+    create_test_entry(test_dir, "2024-08-01",
+                      "## 09:00:00\n\nSetup:\n\n```sh\n# install deps\nmake\n## not a section\n```\n\n"
+                      "After the fence\n\n## 10:00:00\n\nLater");
+    
+    export_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.start_date = (date_t){2024, 8, 1};
+    options.end_date = (date_t){2024, 8, 1};
+    options.format = EXPORT_FORMAT_HTML;
+    strcpy(options.output_path, test_dir);
+    
+    config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.journal_directory, test_dir);
+    
+    int count = 0;
+    ASSERT_EQ(EXPORT_OK, run_export(&options, &config, &count), "HTML export should succeed");
+    
+    char path[512];
+    size_t length = 0;
+    snprintf(path, sizeof(path), "%s/ciary_export_2024-08-01_to_2024-08-01.html", test_dir);
+    char *html = read_export_file(path, &length);
+    ASSERT_NOT_NULL(html, "HTML file should be written");
+    if (html) {
+        int sections = 0;
+        for (const char *p = html; (p = strstr(p, "<div class=\"entry-time\">")) != NULL; p++) sections++;
+        ASSERT_EQ(2, sections, "Only the real time headers should open sections");
+        ASSERT_NOT_NULL(strstr(html, "<pre><code># install deps\nmake\n## not a section\n</code></pre>"),
+                        "The fenced block should keep its header-looking lines");
+        ASSERT_NOT_NULL(strstr(html, "<p>After the fence</p>"), "Text after the fence should be a paragraph");
+        free(html);
+    }
+    
+    options.format = EXPORT_FORMAT_NDJSON;
+    ASSERT_EQ(EXPORT_OK, run_export(&options, &config, &count), "NDJSON export should succeed");
+    snprintf(path, sizeof(path), "%s/ciary_export_2024-08-01_to_2024-08-01.ndjson", test_dir);
+    char *ndjson = read_export_file(path, &length);
+    const char *expected =
+        "{\"date\":\"2024-08-01\",\"time\":\"09:00:00\",\"text\":\"Setup:\\n\\n```sh\\n# install deps\\n"
+        "make\\n## not a section\\n```\\n\\nAfter the fence\"}\n"
+        "{\"date\":\"2024-08-01\",\"time\":\"10:00:00\",\"text\":\"Later\"}\n";
+    ASSERT_STR_EQ(expected, ndjson ? ndjson : "", "Fenced lines should stay in their section's record");
+    free(ndjson);
+    
+    cleanup_test_journal_dir(test_dir);
+}
+
+// "-" as the output path streams the export to stdout
+void test_stdout_export(void) {
+    TEST_CASE("Export to stdout");
+    
+    char* test_dir = create_test_journal_dir();
+    if (!test_dir) {
+        return;
+    }
+    
+    create_test_entry(test_dir, "2024-06-01", "## 09:00:00\n\nPiped day");
+    create_test_entry(test_dir, "2024-06-02", "## 09:00:00\n\nPiped again");
+    
+    export_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.start_date = (date_t){2024, 6, 1};
+    options.end_date = (date_t){2024, 6, 30};
+    strcpy(options.output_path, "-");
+    
+    config_t config;
+    memset(&config, 0, sizeof(config));
+    strcpy(config.journal_directory, test_dir);
+    
+    // Point stdout at a file for the duration of each export
+    char path[512];
+    snprintf(path, sizeof(path), "%s/stdout.out", test_dir);
+    export_format_t formats[] = {EXPORT_FORMAT_MARKDOWN, EXPORT_FORMAT_HTML, EXPORT_FORMAT_NDJSON};
+    const char *expected[] = {"Piped again", "<p>Piped day</p>", "\"text\":\"Piped again\"}\n"};
+    for (int i = 0; i < 3; i++) {
+        options.format = formats[i];
+        fflush(stdout);
+        int saved = dup(STDOUT_FILENO);
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+        
+        int count = 0;
+        export_status_t status = run_export(&options, &config, &count);
+        
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+        
+        size_t length = 0;
+        char *output = read_export_file(path, &length);
+        ASSERT_TRUE(status == EXPORT_OK && output && strstr(output, expected[i]),
+                    "Export should be written to stdout");
+        free(output);
+    }
+    
+    snprintf(path, sizeof(path), "%s/-", test_dir);
+    ASSERT_TRUE(access(path, F_OK) != 0 && access("-", F_OK) != 0, "No file named - should be created");
+    
+    options.format = EXPORT_FORMAT_HTML_SITE;
+    int count = 0;
+    export_status_t status = run_export(&options, &config, &count);
+    ASSERT_EQ(EXPORT_FAILED, status, "Site exports can't go to stdout");
+    
+    cleanup_test_journal_dir(test_dir);
+}
+
 void run_export_tests(void) {
     TEST_SUITE("Export Functionality Tests");
     
     test_date_comparison();
     test_date_parsing();
     test_chronological_sorting();
+    test_large_collection();
     test_export_format_validation();
     test_date_range_validation();
     test_markdown_export();
+    test_html_export();
+    test_output_sink();
+    test_parallel_export();
+    test_file_splicing();
+    test_fragment_cache();
+    test_html_site_export();
+    test_pdf_export();
+    test_ndjson_export();
+    test_fenced_headers();
+    test_stdout_export();
     
     TEST_SUMMARY();
 }
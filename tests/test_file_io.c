@@ -106,6 +106,66 @@ void test_entry_counting() {
     cleanup_file_io_test();
 }
 
+void test_month_entry_cache() {
+    TEST_CASE("Month Entry Cache");
+    setup_file_io_test();
+    
+    if (test_journal_dir == NULL) {
+        printf("⚠ Skipping test - could not create temp directory\n");
+        return;
+    }
+    
+    date_t day_one = {2024, 3, 1};
+    date_t day_two = {2024, 3, 31};
+    date_t other_month = {2024, 4, 1};
+    char path[512];
+    
+    get_entry_path(day_one, path, &test_config);
+    FILE *file = fopen(path, "w");
+    if (file) {
+        fprintf(file, "# 2024-03-01\n\n## 08:00:00\n\nFirst\n\n## 09:00:00\n\nSecond\n");
+        fclose(file);
+    }
+    get_entry_path(other_month, path, &test_config);
+    file = fopen(path, "w");
+    if (file) {
+        fprintf(file, "# 2024-04-01\n\n## 08:00:00\n\nApril\n");
+        fclose(file);
+    }
+    
+    journal_index_t index;
+    journal_index_init(&index);
+    journal_index_refresh(&index, &test_config);
+    
+    month_cache_t cache;
+    month_cache_invalidate(&cache);
+    ASSERT_EQ(-1, month_cache_get(&cache, day_one), "Empty cache should not answer");
+    
+    month_cache_load(&cache, 2024, 3, &index);
+    ASSERT_EQ(2, month_cache_get(&cache, day_one), "Cache should count entries from the index");
+    ASSERT_EQ(0, month_cache_get(&cache, day_two), "Days without files should have 0 entries");
+    ASSERT_EQ(-1, month_cache_get(&cache, other_month), "Other months should not be answered");
+    
+    // Append a section; the cache only changes once the day is refreshed
+    get_entry_path(day_one, path, &test_config);
+    file = fopen(path, "a");
+    if (file) {
+        fprintf(file, "\n## 10:00:00\n\nThird\n");
+        fclose(file);
+    }
+    ASSERT_EQ(2, month_cache_get(&cache, day_one), "Redraws should read from memory");
+    journal_index_update_day(&index, day_one, &test_config);
+    month_cache_invalidate(&cache);
+    month_cache_load(&cache, 2024, 3, &index);
+    ASSERT_EQ(3, month_cache_get(&cache, day_one), "Refresh should pick up the changed file");
+    
+    month_cache_load(&cache, 2024, 4, &index);
+    ASSERT_EQ(1, month_cache_get(&cache, other_month), "Switching month should reload");
+    
+    journal_index_free(&index);
+    cleanup_file_io_test();
+}
+
 void test_journal_directory_creation() {
     TEST_CASE("Journal Directory Creation");
     
@@ -207,6 +267,48 @@ void test_editor_detection() {
     ASSERT_TRUE(strlen(fallback_editor) > 0, "Fallback editor name should not be empty");
 }
 
+void test_program_resolution() {
+    TEST_CASE("Program Resolution");
+    
+    char path[512];
+    ASSERT_TRUE(find_in_path("sh", path, sizeof(path)), "sh should be found on PATH");
+    ASSERT_TRUE(path[0] == '/' || path[0] == '.', "Resolved program should be a path");
+    ASSERT_FALSE(find_in_path("nonexistent_program_12345", path, sizeof(path)),
+                 "Missing program should not be found");
+    ASSERT_TRUE(find_in_path("/bin/sh", path, sizeof(path)), "Absolute path should be accepted");
+    ASSERT_STR_EQ("/bin/sh", path, "Absolute path should be kept as-is");
+    ASSERT_FALSE(find_in_path("/tmp", path, sizeof(path)), "Directories should not be treated as programs");
+    
+    // Results are kept until the preference changes
+    config_t config;
+    load_default_config(&config);
+    strcpy(config.editor_preference, "auto");
+    const char* first = get_actual_editor(&config);
+    const char* second = get_actual_editor(&config);
+    ASSERT_TRUE(first == second, "Repeated lookups should reuse the resolved editor");
+    
+    strcpy(config.viewer_preference, "cat");
+    ASSERT_STR_EQ("cat", get_actual_viewer(&config), "Viewer preference should be honoured when available");
+}
+
+void test_process_spawning() {
+    TEST_CASE("Process Spawning");
+    
+    char *true_argv[] = {"true", NULL};
+    ASSERT_EQ(0, spawn_and_wait(true_argv), "Successful program should return 0");
+    
+    char *false_argv[] = {"false", NULL};
+    ASSERT_EQ(1, spawn_and_wait(false_argv), "Exit status should be passed through");
+    
+    char *missing_argv[] = {"nonexistent_program_12345", NULL};
+    ASSERT_EQ(-1, spawn_and_wait(missing_argv), "Missing program should fail to spawn");
+    
+    // Arguments reach the child verbatim, quotes included
+    char *quote_argv[] = {"sh", "-c", "test \"$1\" = \"it's \\\"quoted\\\"\"", "sh",
+                          "it's \"quoted\"", NULL};
+    ASSERT_EQ(0, spawn_and_wait(quote_argv), "Arguments with quotes should not be reinterpreted");
+}
+
 void test_path_expansion() {
     TEST_CASE("Path Expansion");
     
@@ -238,8 +340,11 @@ void run_file_io_tests() {
     test_entry_path_generation();
     test_entry_existence_check();
     test_entry_counting();
+    test_month_entry_cache();
     test_journal_directory_creation();
     test_file_format_validation();
     test_editor_detection();
+    test_program_resolution();
+    test_process_spawning();
     test_path_expansion();
 }
\ No newline at end of file
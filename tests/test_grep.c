@@ -0,0 +1,352 @@
+#define _GNU_SOURCE
+#include "test_framework.h"
+#include "../include/ciary.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+static char* grep_test_dir = NULL;
+static config_t grep_config;
+
+static void setup_grep_test(void) {
+    grep_test_dir = create_temp_dir();
+    if (grep_test_dir) {
+        memset(&grep_config, 0, sizeof(grep_config));
+        strncpy(grep_config.journal_directory, grep_test_dir, sizeof(grep_config.journal_directory) - 1);
+    }
+}
+
+static void cleanup_grep_test(void) {
+    if (grep_test_dir) {
+        remove_temp_dir(grep_test_dir);
+        grep_test_dir = NULL;
+    }
+}
+
+// Write a day file with an mtime of its own, so rewrites within the same
+// second are still seen as changes
+static void write_day(const char *date, const char *content, time_t mtime) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.md", grep_test_dir, date);
+    FILE *file = fopen(path, "w");
+    if (file) {
+        fprintf(file, "# %s\n\n%s", date, content);
+        fclose(file);
+    }
+    struct utimbuf times = {mtime, mtime};
+    utime(path, &times);
+}
+
+// Keeps the first few matches
+typedef struct {
+    grep_match_t matches[8];
+    char lines[8][64];
+    int count;
+    int stop_after;
+} match_list_t;
+
+static int collect_match(const grep_match_t *match, void *context) {
+    match_list_t *list = context;
+    if (list->count < 8) {
+        list->matches[list->count] = *match;
+        snprintf(list->lines[list->count], sizeof(list->lines[0]), "%.*s", (int)match->length, match->line);
+    }
+    list->count++;
+    return list->stop_after == 0 || list->count < list->stop_after;
+}
+
+// Matches of pattern in text, with flags
+static int grep_text(const char *pattern_text, int flags, const char *text, match_list_t *list) {
+    grep_pattern_t pattern;
+    char error[256];
+    memset(list, 0, sizeof(*list));
+    if (!grep_pattern_compile(&pattern, pattern_text, flags, error, sizeof(error))) return -1;
+    int matches = 0;
+    grep_buffer(&pattern, (date_t){2024, 5, 1}, text, strlen(text), collect_match, list, &matches);
+    grep_pattern_free(&pattern);
+    return matches;
+}
+
+// Number of candidate days for a pattern
+static int candidates(const trigram_index_t *index, const char *pattern_text, int flags) {
+    grep_pattern_t pattern;
+    char error[256];
+    uint32_t *days = NULL;
+    int count = -1;
+    if (grep_pattern_compile(&pattern, pattern_text, flags, error, sizeof(error))) {
+        trigram_index_candidates(index, &pattern, &days, &count);
+        grep_pattern_free(&pattern);
+    }
+    free(days);
+    return count;
+}
+
+void test_grep_literals(void) {
+    TEST_CASE("Grep Pattern Literals");
+
+    grep_pattern_t pattern;
+    char error[256];
+
+    ASSERT_TRUE(grep_pattern_compile(&pattern, "Foo(bar)*baz+qux", 0, error, sizeof(error)), "Regex should compile");
+    ASSERT_EQ(3, pattern.literal_count, "Literals outside groups should be kept");
+    if (pattern.literal_count == 3) {
+        const char *second = pattern.literals + strlen(pattern.literals) + 1;
+        ASSERT_STR_EQ("foo", pattern.literals, "Literals should be folded to lower case");
+        ASSERT_STR_EQ("baz", second, "A repeated byte should end its run");
+        ASSERT_STR_EQ("qux", second + strlen(second) + 1, "Runs should restart after a quantifier");
+    }
+    grep_pattern_free(&pattern);
+
+    grep_pattern_compile(&pattern, "colou?r", 0, error, sizeof(error));
+    ASSERT_STR_EQ("colo", pattern.literals, "An optional byte should be dropped from its run");
+    ASSERT_EQ(4, (int)pattern.anchor_length, "The longest literal should be the anchor");
+    grep_pattern_free(&pattern);
+
+    grep_pattern_compile(&pattern, "[a-z]+\\.example\\.com", 0, error, sizeof(error));
+    ASSERT_STR_EQ(".example.com", pattern.literals, "Escaped bytes should be literal");
+    grep_pattern_free(&pattern);
+
+    grep_pattern_compile(&pattern, "cat|dog", 0, error, sizeof(error));
+    ASSERT_EQ(0, pattern.literal_count, "Alternation should keep no literals");
+    grep_pattern_free(&pattern);
+
+    grep_pattern_compile(&pattern, "a.B", GREP_FIXED, error, sizeof(error));
+    ASSERT_STR_EQ("a.b", pattern.literals, "A fixed pattern should be its own literal");
+    grep_pattern_free(&pattern);
+
+    ASSERT_FALSE(grep_pattern_compile(&pattern, "(", 0, error, sizeof(error)), "Bad regexes should be rejected");
+    ASSERT_TRUE(error[0] != '\0', "Rejection should explain why");
+}
+
+void test_grep_buffer(void) {
+    TEST_CASE("Grep Buffer");
+
+    const char *text =
+        "# 2024-05-01\n"
+        "\n"
+        "## 08:00:00\n"
+        "\n"
+        "Coffee at cafe.example.com\n"
+        "no match here\n"
+        "\n"
+        "## 21:30:15\n"
+        "More coffee\r\n";
+    match_list_t list;
+
+    int matches = grep_text("coffee", GREP_FIXED, text, &list);
+    ASSERT_EQ(1, matches, "Fixed search should match case");
+    ASSERT_EQ(9, list.matches[0].line_number, "Line numbers should count from 1");
+    ASSERT_EQ(21, list.matches[0].hour, "Match should carry its section's time");
+    ASSERT_EQ(15, list.matches[0].second, "Match should carry its section's seconds");
+    ASSERT_STR_EQ("More coffee", list.lines[0], "Line should exclude the line ending");
+
+    matches = grep_text("COFFEE", GREP_FIXED | GREP_IGNORE_CASE, text, &list);
+    ASSERT_EQ(2, matches, "Ignoring case should match both lines");
+    ASSERT_EQ(5, list.matches[0].line_number, "Matches should come in file order");
+    ASSERT_EQ(8, list.matches[0].hour, "First match should be in the first section");
+
+    matches = grep_text("^[a-z]+ [a-z]+ here$", 0, text, &list);
+    ASSERT_EQ(1, matches, "Regex should match whole lines");
+    ASSERT_STR_EQ("no match here", list.lines[0], "Regex should report the matching line");
+
+    matches = grep_text("cafe\\.[a-z]+\\.com", 0, text, &list);
+    ASSERT_EQ(1, matches, "Regex with literals should match");
+
+    matches = grep_text("2024-05", GREP_FIXED, text, &list);
+    ASSERT_EQ(1, matches, "Header line should be searched");
+    ASSERT_EQ(-1, list.matches[0].hour, "Lines above the first section have no time");
+
+    matches = grep_text("", GREP_FIXED, text, &list);
+    ASSERT_EQ(9, matches, "An empty pattern should match every line");
+
+    memset(&list, 0, sizeof(list));
+    list.stop_after = 2;
+    grep_pattern_t pattern;
+    char error[256];
+    grep_pattern_compile(&pattern, "e", GREP_FIXED, error, sizeof(error));
+    matches = 0;
+    int more = grep_buffer(&pattern, (date_t){2024, 5, 1}, text, strlen(text), collect_match, &list, &matches);
+    grep_pattern_free(&pattern);
+    ASSERT_FALSE(more, "Callback should be able to stop the search");
+    ASSERT_EQ(2, matches, "No match should be reported after stopping");
+}
+
+void test_trigram_index(void) {
+    TEST_CASE("Trigram Index");
+    setup_grep_test();
+
+    if (grep_test_dir == NULL) {
+        printf("⚠ Skipping test - could not create temp directory\n");
+        return;
+    }
+
+    write_day("2024-02-01", "## 08:00:00\n\nhttps://example.com/alpha\n", 1000);
+    write_day("2024-02-02", "## 08:00:00\n\nCalled Bartholomew\n", 1000);
+    write_day("2024-02-03", "## 08:00:00\n\nexample of nothing\n", 1000);
+
+    journal_index_t journal;
+    journal_index_init(&journal);
+    journal_index_open(&journal, &grep_config);
+    trigram_index_t index;
+    trigram_index_init(&index);
+    ASSERT_TRUE(trigram_index_open(&index, &journal, &grep_config), "Open should build the index");
+    ASSERT_EQ(3, index.day_count, "Every day file should be indexed");
+
+    ASSERT_EQ(2, candidates(&index, "example", GREP_FIXED), "Only days with every trigram should be candidates");
+    ASSERT_EQ(1, candidates(&index, "THOLOM", GREP_FIXED), "Trigrams should ignore case");
+    ASSERT_EQ(0, candidates(&index, "zebra", GREP_FIXED), "An absent trigram should rule out every day");
+    ASSERT_EQ(3, candidates(&index, "ex", GREP_FIXED), "Short patterns can't be filtered");
+    ASSERT_EQ(3, candidates(&index, "alpha|nothing", 0), "Alternation can't be filtered");
+    ASSERT_EQ(1, candidates(&index, "example\\.com/[a-z]+", 0), "Regex literals should be filtered");
+
+    match_list_t list;
+    memset(&list, 0, sizeof(list));
+    grep_pattern_t pattern;
+    char error[256];
+    grep_pattern_compile(&pattern, "example", GREP_FIXED, error, sizeof(error));
+    int matches = grep_journal(&index, &pattern, &grep_config, 1, collect_match, &list);
+    ASSERT_EQ(2, matches, "Journal search should verify candidates");
+    if (matches == 2) {
+        ASSERT_EQ(3, list.matches[0].date.day, "Newest day should come first when asked");
+        ASSERT_EQ(1, list.matches[1].date.day, "Older day should follow");
+    }
+
+    // A saved index loads back and a no-op update leaves it alone
+    trigram_index_t loaded;
+    trigram_index_init(&loaded);
+    ASSERT_TRUE(trigram_index_load(&loaded, &grep_config), "Saved index should load");
+    ASSERT_TRUE(trigram_index_update(&loaded, &journal, &grep_config), "Update should succeed");
+    ASSERT_FALSE(loaded.dirty, "An up-to-date index should not be rebuilt");
+    ASSERT_EQ(index.posting_count, loaded.posting_count, "Loaded postings should match");
+    trigram_index_free(&loaded);
+
+    // Edit one day, delete another, add a new one
+    write_day("2024-02-02", "## 08:00:00\n\nexample.org instead\n", 2000);
+    char path[512];
+    snprintf(path, sizeof(path), "%s/2024-02-03.md", grep_test_dir);
+    unlink(path);
+    write_day("2024-02-04", "## 09:00:00\n\nBartholomew again\n", 1000);
+    journal_index_refresh(&journal, &grep_config);
+
+    ASSERT_TRUE(trigram_index_update(&index, &journal, &grep_config), "Update should succeed");
+    ASSERT_TRUE(index.dirty, "A changed journal should dirty the index");
+    ASSERT_EQ(3, index.day_count, "Days should follow the journal");
+    ASSERT_EQ(1, candidates(&index, "bartholomew", GREP_FIXED), "Edited and added days should be reindexed");
+    ASSERT_EQ(2, candidates(&index, "example", GREP_FIXED), "Kept days should keep their trigrams");
+    ASSERT_EQ(0, candidates(&index, "nothing", GREP_FIXED), "Deleted days should be dropped");
+
+    memset(&list, 0, sizeof(list));
+    matches = grep_journal(&index, &pattern, &grep_config, 0, collect_match, &list);
+    ASSERT_EQ(2, matches, "Search should follow the update");
+    if (matches == 2) {
+        ASSERT_EQ(1, list.matches[0].date.day, "Date order should be the default");
+        ASSERT_STR_EQ("example.org instead", list.lines[1], "Edited text should be found");
+    }
+    grep_pattern_free(&pattern);
+
+    // A damaged file is rejected rather than trusted
+    ASSERT_TRUE(trigram_index_save(&index, &grep_config), "Save should succeed");
+    snprintf(path, sizeof(path), "%s/%s", grep_test_dir, TRIGRAM_INDEX_FILE);
+    struct stat st;
+    stat(path, &st);
+    truncate(path, st.st_size / 2);
+    ASSERT_FALSE(trigram_index_load(&loaded, &grep_config), "Truncated index should not load");
+    ASSERT_EQ(0, loaded.day_count, "Failed load should leave an empty index");
+
+    trigram_index_free(&index);
+    journal_index_free(&journal);
+    cleanup_grep_test();
+}
+
+typedef struct {
+    output_sink_t *output;
+    grep_group_t group;
+} grouped_output_t;
+
+static int write_grouped_match(const grep_match_t *match, void *context) {
+    grouped_output_t *grouped = context;
+    grep_write_match(grouped->output, &grouped->group, match);
+    return 1;
+}
+
+void test_grep_scan(void) {
+    TEST_CASE("Parallel Grep Scan");
+    setup_grep_test();
+
+    if (grep_test_dir == NULL) {
+        printf("⚠ Skipping test - could not create temp directory\n");
+        return;
+    }
+
+    write_day("2024-06-02", "## 09:00:00\n\nTea, then a walk\n\n## 18:30:00\n\nMore tea\ntea again\n", 1000);
+    write_day("2024-06-01", "Tea before any section\n\n## 07:15:00\n\nNo drinks\n", 1000);
+    write_day("2024-06-03", "## 12:00:00\n\nCoffee\n", 1000);
+    char path[512];
+    snprintf(path, sizeof(path), "%s/notes.txt", grep_test_dir);
+    FILE *other = fopen(path, "w");
+    if (other) {
+        fputs("tea that isn't a day file\n", other);
+        fclose(other);
+    }
+
+    const char *expected =
+        "2024-06-01\n"
+        "     3: Tea before any section\n"
+        "2024-06-02 09:00:00\n"
+        "     5: Tea, then a walk\n"
+        "2024-06-02 18:30:00\n"
+        "     9: More tea\n"
+        "    10: tea again\n";
+
+    grep_pattern_t pattern;
+    char error[256];
+    grep_pattern_compile(&pattern, "^(more )?tea", GREP_IGNORE_CASE, error, sizeof(error));
+
+    // Several workers, even on a single CPU, so the ordering is exercised
+    export_set_worker_count(3);
+    output_sink_t output;
+    output_init_memory(&output);
+    int matches = grep_scan_journal(&pattern, &grep_config, &output);
+    export_set_worker_count(0);
+    ASSERT_EQ(4, matches, "Scan should count every matching line");
+    output_write(&output, "", 1);
+    ASSERT_STR_EQ(expected, output.buffer, "Matches should be grouped by day and section, in date order");
+
+    // The index gives the same answer
+    journal_index_t journal;
+    journal_index_init(&journal);
+    journal_index_open(&journal, &grep_config);
+    trigram_index_t index;
+    trigram_index_init(&index);
+    trigram_index_open(&index, &journal, &grep_config);
+    output_reset(&output);
+    grouped_output_t grouped;
+    memset(&grouped, 0, sizeof(grouped));
+    grouped.output = &output;
+    matches = grep_journal(&index, &pattern, &grep_config, 0, write_grouped_match, &grouped);
+    ASSERT_EQ(4, matches, "Indexed search should find the same lines");
+    output_write(&output, "", 1);
+    ASSERT_STR_EQ(expected, output.buffer, "Indexed search should print the same groups");
+
+    output_close(&output);
+    trigram_index_free(&index);
+    journal_index_free(&journal);
+    grep_pattern_free(&pattern);
+
+    config_t missing = grep_config;
+    strcat(missing.journal_directory, "/missing");
+    output_init_memory(&output);
+    ASSERT_EQ(-1, grep_scan_journal(&pattern, &missing, &output), "A missing journal should be an error");
+    output_close(&output);
+
+    cleanup_grep_test();
+}
+
+void run_grep_tests(void) {
+    TEST_SUITE("Trigram Grep");
+
+    test_grep_literals();
+    test_grep_buffer();
+    test_trigram_index();
+    test_grep_scan();
+}
@@ -0,0 +1,209 @@
+#include "test_framework.h"
+#include "../include/ciary.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+static char* index_test_dir = NULL;
+static config_t index_config;
+
+static void setup_index_test(void) {
+    index_test_dir = create_temp_dir();
+    if (index_test_dir) {
+        memset(&index_config, 0, sizeof(index_config));
+        strncpy(index_config.journal_directory, index_test_dir, sizeof(index_config.journal_directory) - 1);
+    }
+}
+
+static void cleanup_index_test(void) {
+    if (index_test_dir) {
+        remove_temp_dir(index_test_dir);
+        index_test_dir = NULL;
+    }
+}
+
+static void write_day(const char *name, const char *content) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", index_test_dir, name);
+    FILE *file = fopen(path, "w");
+    if (file) {
+        fputs(content, file);
+        fclose(file);
+    }
+}
+
+void test_index_build(void) {
+    TEST_CASE("Index Build");
+    setup_index_test();
+    
+    if (index_test_dir == NULL) {
+        printf("⚠ Skipping test - could not create temp directory\n");
+        return;
+    }
+    
+    write_day("2024-05-02.md", "# 2024-05-02\n\n## 09:00:00\n\nTwo words\n\n## 10:00:00\n\nThree more words\n");
+    write_day("2024-05-01.md", "# 2024-05-01\n\n## 08:00:00\n\nOne\n");
+    write_day("notes.txt", "## not a day file\n");
+    
+    journal_index_t index;
+    journal_index_init(&index);
+    ASSERT_TRUE(journal_index_refresh(&index, &index_config), "Refresh should succeed");
+    ASSERT_EQ(2, index.count, "Only day files should be indexed");
+    ASSERT_TRUE(index.dirty, "A fresh index should need saving");
+    
+    if (index.count == 2) {
+        ASSERT_EQ(1, index.entries[0].date.day, "Entries should be sorted by date");
+        ASSERT_EQ(2, index.entries[1].date.day, "Later date should come second");
+    }
+    
+    date_t day = {2024, 5, 2};
+    const index_entry_t *entry = journal_index_find(&index, day);
+    ASSERT_NOT_NULL(entry, "Indexed day should be found");
+    if (entry) {
+        ASSERT_EQ(2, entry->section_count, "Section count should match headers");
+        ASSERT_EQ(5, entry->word_count, "Words should be counted outside headers");
+        ASSERT_EQ(14, (int)entry->section_offsets[0], "First section offset should point at its header");
+        ASSERT_EQ(38, (int)entry->section_offsets[1], "Second section offset should point at its header");
+    }
+    
+    date_t missing = {2024, 5, 3};
+    ASSERT_NULL(journal_index_find(&index, missing), "Unknown day should not be found");
+    
+    journal_index_free(&index);
+    cleanup_index_test();
+}
+
+void test_index_persistence(void) {
+    TEST_CASE("Index Persistence");
+    setup_index_test();
+    
+    if (index_test_dir == NULL) {
+        printf("⚠ Skipping test - could not create temp directory\n");
+        return;
+    }
+    
+    write_day("2023-12-31.md", "# 2023-12-31\n\n## 23:59:00\n\nLast entry of the year\n");
+    write_day("2024-01-01.md", "# 2024-01-01\n\n## 00:01:00\n\nFirst\n\n## 12:00:00\n\nSecond\n");
+    
+    journal_index_t index;
+    journal_index_init(&index);
+    ASSERT_TRUE(journal_index_open(&index, &index_config), "Open should build the index");
+    ASSERT_FALSE(index.dirty, "Open should save the index");
+    journal_index_free(&index);
+    
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", index_test_dir, JOURNAL_INDEX_FILE);
+    ASSERT_TRUE(access(path, F_OK) == 0, "Index file should be written to the journal directory");
+    
+    journal_index_t loaded;
+    journal_index_init(&loaded);
+    ASSERT_TRUE(journal_index_load(&loaded, &index_config), "Saved index should load");
+    ASSERT_EQ(2, loaded.count, "Loaded index should contain both days");
+    
+    date_t day = {2024, 1, 1};
+    const index_entry_t *entry = journal_index_find(&loaded, day);
+    ASSERT_NOT_NULL(entry, "Loaded index should find saved day");
+    if (entry) {
+        ASSERT_EQ(2, entry->section_count, "Section count should survive a round trip");
+        ASSERT_EQ(2, entry->word_count, "Word count should survive a round trip");
+    }
+    
+    // Nothing changed on disk, so a refresh must not dirty the index
+    journal_index_refresh(&loaded, &index_config);
+    ASSERT_FALSE(loaded.dirty, "Unchanged journal should not dirty the index");
+    journal_index_free(&loaded);
+    
+    // A record with an impossible date is dropped; the one after it still
+    // loads. The first record's month sits 26 bytes in, after the header.
+    FILE *file = fopen(path, "r+b");
+    if (file) {
+        fseek(file, 12 + 26, SEEK_SET);
+        fputc(200, file);
+        fclose(file);
+    }
+    journal_index_init(&loaded);
+    ASSERT_TRUE(journal_index_load(&loaded, &index_config), "Index with a bad record should still load");
+    ASSERT_EQ(1, loaded.count, "The record with a bad date should be dropped");
+    ASSERT_NOT_NULL(journal_index_find(&loaded, day), "Records after the bad one should load");
+    ASSERT_TRUE(loaded.dirty, "Dropping a record should dirty the index");
+    journal_index_free(&loaded);
+    
+    // A corrupt index is ignored rather than trusted
+    file = fopen(path, "wb");
+    if (file) {
+        fputs("garbage", file);
+        fclose(file);
+    }
+    journal_index_init(&loaded);
+    journal_index_load(&loaded, &index_config);
+    ASSERT_EQ(0, loaded.count, "Corrupt index should load as empty");
+    journal_index_free(&loaded);
+    
+    cleanup_index_test();
+}
+
+void test_index_incremental_refresh(void) {
+    TEST_CASE("Incremental Index Refresh");
+    setup_index_test();
+    
+    if (index_test_dir == NULL) {
+        printf("⚠ Skipping test - could not create temp directory\n");
+        return;
+    }
+    
+    write_day("2024-02-01.md", "# 2024-02-01\n\n## 08:00:00\n\nAAAA\n");
+    write_day("2024-02-02.md", "# 2024-02-02\n\n## 08:00:00\n\nBBBB\n");
+    
+    journal_index_t index;
+    journal_index_init(&index);
+    journal_index_refresh(&index, &index_config);
+    index.dirty = 0;
+    
+    // Same size, same mtime: the file must not be reparsed
+    char path[512];
+    snprintf(path, sizeof(path), "%s/2024-02-01.md", index_test_dir);
+    struct stat st;
+    stat(path, &st);
+    write_day("2024-02-01.md", "# 2024-02-01\n\n## 08:00:00\n## 00\n");
+    struct utimbuf times = {st.st_atime, st.st_mtime};
+    utime(path, &times);
+    
+    journal_index_refresh(&index, &index_config);
+    date_t first = {2024, 2, 1};
+    const index_entry_t *entry = journal_index_find(&index, first);
+    ASSERT_TRUE(entry && entry->section_count == 1, "Unchanged stat should skip reparsing");
+    ASSERT_FALSE(index.dirty, "Skipped files should not dirty the index");
+    
+    // Growing a file changes its size, so it gets reparsed
+    write_day("2024-02-01.md", "# 2024-02-01\n\n## 08:00:00\n\nAAAA\n\n## 09:00:00\n\nMore\n");
+    write_day("2024-02-03.md", "# 2024-02-03\n\n## 08:00:00\n\nNew\n");
+    snprintf(path, sizeof(path), "%s/2024-02-02.md", index_test_dir);
+    unlink(path);
+    
+    journal_index_refresh(&index, &index_config);
+    entry = journal_index_find(&index, first);
+    ASSERT_TRUE(entry && entry->section_count == 2, "Changed file should be reparsed");
+    date_t removed = {2024, 2, 2};
+    ASSERT_NULL(journal_index_find(&index, removed), "Deleted file should leave the index");
+    date_t added = {2024, 2, 3};
+    ASSERT_NOT_NULL(journal_index_find(&index, added), "New file should join the index");
+    ASSERT_TRUE(index.dirty, "Changes should dirty the index");
+    
+    // Single-day updates after editing
+    write_day("2024-02-04.md", "# 2024-02-04\n\n## 08:00:00\n\nEdited\n");
+    date_t edited = {2024, 2, 4};
+    journal_index_update_day(&index, edited, &index_config);
+    ASSERT_NOT_NULL(journal_index_find(&index, edited), "Updated day should be inserted");
+    ASSERT_EQ(2, journal_index_lower_bound(&index, edited), "Inserted day should stay in date order");
+    
+    journal_index_free(&index);
+    cleanup_index_test();
+}
+
+void run_index_tests(void) {
+    TEST_SUITE("Journal Index");
+    
+    test_index_build();
+    test_index_persistence();
+    test_index_incremental_refresh();
+}
@@ -0,0 +1,148 @@
+#include "test_framework.h"
+#include "../include/ciary.h"
+
+// Render text into a NUL-terminated heap string, feeding it chunk bytes
+// at a time (0 = all at once)
+static char* render(const char *text, size_t chunk) {
+    output_sink_t sink;
+    if (!output_init_memory(&sink)) return NULL;
+
+    markdown_renderer_t md;
+    markdown_init(&md, &sink);
+    size_t length = strlen(text);
+    if (chunk == 0) chunk = length ? length : 1;
+    for (size_t i = 0; i < length; i += chunk) {
+        markdown_feed(&md, text + i, (length - i < chunk) ? length - i : chunk);
+    }
+    markdown_finish(&md);
+
+    char *html = malloc(sink.used + 1);
+    if (html) {
+        memcpy(html, sink.buffer, sink.used);
+        html[sink.used] = '\0';
+    }
+    output_close(&sink);
+    return html;
+}
+
+static void assert_renders(const char *markdown, const char *expected, const char *message) {
+    char *html = render(markdown, 0);
+    ASSERT_STR_EQ(expected, html ? html : "", message);
+    free(html);
+}
+
+void test_markdown_blocks(void) {
+    TEST_CASE("Markdown Blocks");
+
+    assert_renders("One line\nand the next\n\nSecond paragraph",
+                   "<p>One line\nand the next</p>\n<p>Second paragraph</p>\n",
+                   "Lines should join into paragraphs split by blank lines");
+    assert_renders("### Notes\nText", "<h3>Notes</h3>\n<p>Text</p>\n",
+                   "Headings should end with their line");
+    assert_renders("#hashtag and #another", "<p>#hashtag and #another</p>\n",
+                   "Tags aren't headings");
+    assert_renders("- one\n- two\n* three\n\n1. first\n2) second",
+                   "<ul>\n<li>one</li>\n<li>two</li>\n<li>three</li>\n</ul>\n"
+                   "<ol>\n<li>first</li>\n<li>second</li>\n</ol>\n",
+                   "Bullet and numbered lists should be grouped");
+    assert_renders("- item\ncontinued\nText after\n\nPara",
+                   "<ul>\n<li>item\ncontinued\nText after</li>\n</ul>\n<p>Para</p>\n",
+                   "Lines without a marker continue the list item");
+    assert_renders("Intro\n```c\nif (a < b) { *p = 1; }\n\n```\nAfter",
+                   "<p>Intro</p>\n<pre><code>if (a &lt; b) { *p = 1; }\n\n</code></pre>\n<p>After</p>\n",
+                   "Fenced code should be escaped verbatim and closed");
+    assert_renders("```\nnever closed", "<pre><code>never closed</code></pre>\n",
+                   "An unclosed fence should be closed at the end");
+    assert_renders("-not a list\n2024 was a year\n12.5 degrees",
+                   "<p>-not a list\n2024 was a year\n12.5 degrees</p>\n",
+                   "Marker look-alikes should stay text");
+    assert_renders("", "", "Empty input should render nothing");
+    assert_renders("\n\n  \n", "", "Blank lines alone should render nothing");
+}
+
+void test_markdown_inline(void) {
+    TEST_CASE("Markdown Inline Formatting");
+
+    assert_renders("Fish & <chips> \"quoted\"", "<p>Fish &amp; &lt;chips&gt; &quot;quoted&quot;</p>\n",
+                   "Text should be HTML-escaped");
+    assert_renders("*em* and **strong** and _under_ and __double__",
+                   "<p><em>em</em> and <strong>strong</strong> and <em>under</em> and "
+                   "<strong>double</strong></p>\n",
+                   "Emphasis markers should become tags");
+    assert_renders("snake_case_name and 2 * 3", "<p>snake_case_name and 2 * 3</p>\n",
+                   "Markers inside words or around spaces stay literal");
+    assert_renders("`a *b* <c>`", "<p><code>a *b* &lt;c&gt;</code></p>\n",
+                   "Code spans should not format their content");
+    assert_renders("**bold *both** em*", "<p><strong>bold <em>both</em></strong><em> em</em></p>\n",
+                   "Overlapping spans should still nest properly");
+    assert_renders("*never closed", "<p><em>never closed</em></p>\n",
+                   "Open spans should be closed at the end of the block");
+    assert_renders("\\*literal\\* and \\d", "<p>*literal* and \\d</p>\n",
+                   "Backslash should escape markup characters only");
+    assert_renders("See [the docs](https://example.com/a?b=1&c=2).",
+                   "<p>See <a href=\"https://example.com/a?b=1&amp;c=2\">the docs</a>.</p>\n",
+                   "Links should be rendered with escaped URLs");
+    assert_renders("[not a link] and [broken](no end", "<p>[not a link] and [broken](no end</p>\n",
+                   "Incomplete links should fall back to text");
+    assert_renders("[x](javascript:alert(1))", "<p>x)</p>\n", "Script links should be dropped");
+    assert_renders("[a](\x01javascript:alert%281%29)", "<p>a</p>\n",
+                   "Control bytes before the scheme should not hide it");
+    assert_renders("[b](vbscript:x) [c](data:text/html,hi) [d](JavaScript:x)", "<p>b c d</p>\n",
+                   "Schemes outside the allowlist should be dropped");
+    assert_renders("[m](MAILTO:me@example.com) [h](http://example.com)",
+                   "<p><a href=\"MAILTO:me@example.com\">m</a> <a href=\"http://example.com\">h</a></p>\n",
+                   "Mail and web links should stay live");
+    assert_renders("[r](notes/a:b) [q](?at=10:30) [f](#top)",
+                   "<p><a href=\"notes/a:b\">r</a> <a href=\"?at=10:30\">q</a> <a href=\"#top\">f</a></p>\n",
+                   "Links without a scheme should stay live");
+}
+
+void test_markdown_streaming(void) {
+    TEST_CASE("Markdown Streaming");
+
+    const char *document =
+        "### Morning\n"
+        "Went for a *long* walk with **Sam** & the dog.\n"
+        "- bread\n- [shop](https://example.com)\n10. later\n\n"
+        "```\ncode <here>\n```\n"
+        "Ending with `code` and \\_escapes\\_";
+
+    char *whole = render(document, 0);
+    int mismatches = 0;
+    for (size_t chunk = 1; chunk <= 17; chunk++) {
+        char *chunked = render(document, chunk);
+        if (!whole || !chunked || strcmp(whole, chunked) != 0) mismatches++;
+        free(chunked);
+    }
+    ASSERT_EQ(0, mismatches, "Output should not depend on how the input is chunked");
+    free(whole);
+
+    // A single multi-megabyte line stays one paragraph
+    size_t length = 4 * 1024 * 1024;
+    char *line = malloc(length + 1);
+    ASSERT_NOT_NULL(line, "Should allocate long line");
+    if (!line) return;
+    for (size_t i = 0; i < length; i++) {
+        line[i] = (i % 8 == 7) ? ' ' : 'a' + (i % 26);
+    }
+    line[length] = '\0';
+
+    char *html = render(line, 4096);
+    ASSERT_NOT_NULL(html, "Long line should render");
+    if (html) {
+        size_t html_length = strlen(html);
+        ASSERT_EQ(length + 8, html_length, "Long line should produce exactly one paragraph");
+        ASSERT_TRUE(strncmp(html, "<p>", 3) == 0 && strcmp(html + html_length - 5, "</p>\n") == 0,
+                    "Paragraph tags should wrap the whole line");
+    }
+    free(html);
+    free(line);
+}
+
+void run_markdown_tests(void) {
+    TEST_SUITE("Markdown Renderer");
+
+    test_markdown_blocks();
+    test_markdown_inline();
+    test_markdown_streaming();
+}
@@ -11,6 +11,13 @@ void run_export_tests(void);
 void run_integration_tests(void);
 void run_ui_tests(void);
 void run_personalization_tests(void);
+void run_index_tests(void);
+void run_scanner_tests(void);
+void run_escape_tests(void);
+void run_markdown_tests(void);
+void run_grep_tests(void);
+void run_search_tests(void);
+void run_cli_tests(void);
 
 // Global test statistics
 static int total_tests = 0;
@@ -55,6 +62,13 @@ void print_usage(const char* program_name) {
     printf("  integration    Run integration tests\n");
     printf("  ui             Run UI/UX tests\n");
     printf("  personalization Run personalization system tests\n");
+    printf("  index          Run journal index tests\n");
+    printf("  scanner        Run section scanner tests\n");
+    printf("  escape         Run HTML escaping tests\n");
+    printf("  markdown       Run Markdown renderer tests\n");
+    printf("  cli            Run command-line tests\n");
+    printf("  search         Run full-text search tests\n");
+    printf("  grep           Run trigram grep tests\n");
     printf("  all            Run all test suites (default)\n");
     printf("\nExamples:\n");
     printf("  %s                    # Run all tests\n", program_name);
@@ -126,6 +140,27 @@ int main(int argc, char* argv[]) {
         
         run_personalization_tests();
         update_global_stats();
+        
+        run_index_tests();
+        update_global_stats();
+        
+        run_scanner_tests();
+        update_global_stats();
+        
+        run_escape_tests();
+        update_global_stats();
+        
+        run_markdown_tests();
+        update_global_stats();
+        
+        run_cli_tests();
+        update_global_stats();
+        
+        run_search_tests();
+        update_global_stats();
+        
+        run_grep_tests();
+        update_global_stats();
     }
     else if (strcmp(test_suite, "utils") == 0) {
         run_utils_tests();
@@ -155,6 +190,34 @@ int main(int argc, char* argv[]) {
         run_personalization_tests();
         update_global_stats();
     }
+    else if (strcmp(test_suite, "index") == 0) {
+        run_index_tests();
+        update_global_stats();
+    }
+    else if (strcmp(test_suite, "scanner") == 0) {
+        run_scanner_tests();
+        update_global_stats();
+    }
+    else if (strcmp(test_suite, "escape") == 0) {
+        run_escape_tests();
+        update_global_stats();
+    }
+    else if (strcmp(test_suite, "markdown") == 0) {
+        run_markdown_tests();
+        update_global_stats();
+    }
+    else if (strcmp(test_suite, "cli") == 0) {
+        run_cli_tests();
+        update_global_stats();
+    }
+    else if (strcmp(test_suite, "search") == 0) {
+        run_search_tests();
+        update_global_stats();
+    }
+    else if (strcmp(test_suite, "grep") == 0) {
+        run_grep_tests();
+        update_global_stats();
+    }
     else {
         printf("Unknown test suite: %s\n", test_suite);
         print_usage(argv[0]);
@@ -0,0 +1,220 @@
+#include "test_framework.h"
+#include "../include/ciary.h"
+#include <unistd.h>
+
+void test_section_scanning(void) {
+    TEST_CASE("Section Scanning");
+    
+    const char *text = "# 2024-07-15\n\n## 09:30:00\n\nMorning\n\n## 14:22\n\nAfternoon\n\n## Notes\nLast";
+    section_list_t list;
+    memset(&list, 0, sizeof(list));
+    
+    ASSERT_TRUE(scan_sections(text, strlen(text), &list), "Scanning should succeed");
+    ASSERT_EQ(3, list.count, "Should find three sections");
+    
+    if (list.count == 3) {
+        ASSERT_EQ(9, list.sections[0].hour, "Hour should be parsed");
+        ASSERT_EQ(30, list.sections[0].minute, "Minute should be parsed");
+        ASSERT_EQ(0, list.sections[0].second, "Second should be parsed");
+        ASSERT_EQ(14, (int)list.sections[0].offset, "Offset should point at the header line");
+        ASSERT_EQ((int)(list.sections[1].offset - list.sections[0].offset), (int)list.sections[0].length,
+                  "Section should run up to the next header");
+        ASSERT_EQ(14, list.sections[1].hour, "HH:MM headers should parse");
+        ASSERT_EQ(0, list.sections[1].second, "Missing seconds should default to 0");
+        ASSERT_EQ(-1, list.sections[2].hour, "Non-time headers should be marked");
+        ASSERT_EQ((int)(strlen(text) - list.sections[2].offset), (int)list.sections[2].length,
+                  "Last section should run to the end of the file");
+    }
+    
+    ASSERT_EQ(3, count_sections(text, strlen(text)), "Counting should agree with scanning");
+    ASSERT_EQ(0, count_sections("", 0), "Empty buffer should have no sections");
+    ASSERT_EQ(3, count_words(text, strlen(text)), "Headers should not count as words");
+    
+    free_section_list(&list);
+}
+
+// A "## " line inside ``` fenced code is content, not a new section
+void test_fenced_section_scanning(void) {
+    TEST_CASE("Fenced Section Scanning");
+    
+    const char *text = "## 09:00:00\n\n```\n## 10:00:00\n# 2024-07-16\n```\n\n## 11:00:00\nLater";
+    section_list_t list;
+    memset(&list, 0, sizeof(list));
+    
+    ASSERT_TRUE(scan_sections(text, strlen(text), &list), "Scanning should succeed");
+    ASSERT_EQ(2, list.count, "The fenced header should not start a section");
+    if (list.count == 2) {
+        ASSERT_EQ(9, list.sections[0].hour, "First section should be the 09:00 one");
+        ASSERT_EQ(11, list.sections[1].hour, "Second section should be the 11:00 one");
+        ASSERT_EQ((int)(strstr(text, "## 11") - text), (int)list.sections[0].length,
+                  "The first section should run over the fence to the next real header");
+    }
+    ASSERT_EQ(2, count_sections(text, strlen(text)), "Counting should skip the fenced header too");
+    
+    free_section_list(&list);
+}
+
+void test_long_line_scanning(void) {
+    TEST_CASE("Long Line Scanning");
+    
+    // A paragraph far longer than MAX_LINE_SIZE with "## " right where a
+    // fixed-size line buffer would split it
+    size_t length = MAX_LINE_SIZE * 8;
+    char *text = malloc(length + 64);
+    if (!text) return;
+    
+    size_t pos = (size_t)sprintf(text, "## 10:00:00\n");
+    while (pos < length) {
+        text[pos++] = 'x';
+    }
+    size_t line_start = strlen("## 10:00:00\n");
+    memcpy(text + line_start + (MAX_LINE_SIZE - 1), "## ", 3);
+    memcpy(text + line_start + (MAX_LINE_SIZE - 1) * 2, "## ", 3);
+    pos += (size_t)sprintf(text + pos, "\n## 11:00:00\nend\n");
+    
+    ASSERT_EQ(2, count_sections(text, pos), "Headers inside long lines should not be counted");
+    
+    // Same thing through a file, large enough to be mapped
+    char *dir = create_temp_dir();
+    if (dir) {
+        config_t config;
+        memset(&config, 0, sizeof(config));
+        strncpy(config.journal_directory, dir, sizeof(config.journal_directory) - 1);
+        
+        date_t date = {2024, 7, 15};
+        char path[512];
+        get_entry_path(date, path, &config);
+        FILE *file = fopen(path, "w");
+        if (file) {
+            for (int i = 0; i < 16; i++) {
+                fwrite(text, 1, pos, file);
+            }
+            fclose(file);
+        }
+        
+        ASSERT_EQ(32, count_entries(date, &config), "count_entries should handle long lines");
+        
+        section_list_t list;
+        memset(&list, 0, sizeof(list));
+        ASSERT_TRUE(scan_entry_file(path, &list), "Mapped file should scan");
+        ASSERT_EQ(32, list.count, "Mapped file should have every section");
+        free_section_list(&list);
+        
+        remove_temp_dir(dir);
+    }
+    
+    free(text);
+}
+
+void test_file_mapping(void) {
+    TEST_CASE("File Mapping");
+    
+    mapped_file_t file;
+    ASSERT_FALSE(map_file("/nonexistent/ciary/file.md", &file), "Missing file should fail");
+    
+    char *dir = create_temp_dir();
+    if (!dir) return;
+    
+    char path[512];
+    snprintf(path, sizeof(path), "%s/empty.md", dir);
+    FILE *handle = fopen(path, "w");
+    if (handle) fclose(handle);
+    
+    ASSERT_TRUE(map_file(path, &file), "Empty file should map");
+    ASSERT_EQ(0, (int)file.length, "Empty file should have no data");
+    unmap_file(&file);
+    
+    snprintf(path, sizeof(path), "%s/small.md", dir);
+    handle = fopen(path, "w");
+    if (handle) {
+        fputs("## 01:02:03\n", handle);
+        fclose(handle);
+    }
+    ASSERT_TRUE(map_file(path, &file), "Small file should be read");
+    ASSERT_FALSE(file.mapped, "Small file should use the read() fallback");
+    ASSERT_EQ(12, (int)file.length, "Small file length should match");
+    unmap_file(&file);
+    
+    remove_temp_dir(dir);
+}
+
+// Straightforward line-by-line reference for find_next_header
+static const char* reference_next_header(const char *data, const char *from, const char *end, int *kind) {
+    for (const char *p = from; p < end; p++) {
+        if (p != data && p[-1] != '\n') continue;
+        if (end - p >= 3 && strncmp(p, "## ", 3) == 0) { *kind = HEADER_SECTION; return p; }
+        if (end - p >= 2 && strncmp(p, "# ", 2) == 0) { *kind = HEADER_DATE; return p; }
+    }
+    *kind = HEADER_NONE;
+    return end;
+}
+
+void test_header_kernels(void) {
+    TEST_CASE("Header Search Kernels");
+    
+    // Mostly text with frequent newlines and hashes, so every block size
+    // and alignment sees both hits and near-misses ("#x", "###")
+    size_t length = 4096;
+    char *text = malloc(length);
+    if (!text) return;
+    unsigned int seed = 12345;
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned int r = (seed >> 16) % 16;
+        text[i] = (r < 2) ? '\n' : (r < 5) ? '#' : (r < 8) ? ' ' : 'a' + r;
+    }
+    
+    const char *original = header_kernel_name();
+    const char *kernels[] = {"scalar", "sse2", "avx2"};
+    
+    for (int k = 0; k < 3; k++) {
+        if (!select_header_kernel(kernels[k])) {
+            printf("⚠ Skipping %s kernel - not supported here\n", kernels[k]);
+            continue;
+        }
+        
+        int mismatches = 0;
+        for (size_t start = 0; start < 64 && !mismatches; start++) {
+            const char *data = text + start;
+            const char *end = text + length - (start % 7);
+            const char *p = data;
+            while (p < end) {
+                int kind, expected_kind;
+                const char *found = find_next_header(data, p, end, &kind);
+                const char *expected = reference_next_header(data, p, end, &expected_kind);
+                if (found != expected || kind != expected_kind) {
+                    mismatches++;
+                    break;
+                }
+                if (kind == HEADER_NONE) break;
+                p = found + 1;
+            }
+        }
+        
+        char message[128];
+        snprintf(message, sizeof(message), "%s kernel should match the reference scan", kernels[k]);
+        ASSERT_EQ(0, mismatches, message);
+    }
+    
+    select_header_kernel(original);
+    ASSERT_STR_EQ(original, header_kernel_name(), "Default kernel should be restored");
+    
+    // Headers right at the start of the buffer have no preceding newline
+    int kind;
+    const char *first = "## 01:00:00\ntext";
+    ASSERT_TRUE(find_next_header(first, first, first + strlen(first), &kind) == first,
+                "Header on the first line should be found");
+    ASSERT_EQ(HEADER_SECTION, kind, "First line should be a section header");
+    
+    free(text);
+}
+
+void run_scanner_tests(void) {
+    TEST_SUITE("Section Scanner");
+    
+    test_section_scanning();
+    test_fenced_section_scanning();
+    test_long_line_scanning();
+    test_file_mapping();
+    test_header_kernels();
+}
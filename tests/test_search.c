@@ -0,0 +1,362 @@
+#define _GNU_SOURCE
+#include "test_framework.h"
+#include "../include/ciary.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+static char* search_test_dir = NULL;
+static config_t search_config;
+
+static void setup_search_test(void) {
+    search_test_dir = create_temp_dir();
+    if (search_test_dir) {
+        memset(&search_config, 0, sizeof(search_config));
+        strncpy(search_config.journal_directory, search_test_dir, sizeof(search_config.journal_directory) - 1);
+    }
+}
+
+static void cleanup_search_test(void) {
+    if (search_test_dir) {
+        remove_temp_dir(search_test_dir);
+        search_test_dir = NULL;
+    }
+}
+
+// Write a day file with an mtime of its own, so rewrites within the same
+// second are still seen as changes
+static void write_day(const char *date, const char *content, time_t mtime) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.md", search_test_dir, date);
+    FILE *file = fopen(path, "w");
+    if (file) {
+        fprintf(file, "# %s\n\n%s", date, content);
+        fclose(file);
+    }
+    struct utimbuf times = {mtime, mtime};
+    utime(path, &times);
+}
+
+// Query and return the number of matches; hits gets up to 8
+static int query(const search_index_t *index, const char *text, search_hit_t *hits) {
+    return search_index_query(index, text, hits, 8);
+}
+
+void test_search_tokenizer(void) {
+    TEST_CASE("Search Tokenizer");
+
+    const char *text = "Hello, WORLD! caf\xc3\xa9 x_2 supercalifragilisticexpialidocious-and-more";
+    const char *p = text;
+    const char *end = text + strlen(text);
+    char token[SEARCH_TOKEN_MAX + 1];
+
+    const char *expected[] = {"hello", "world", "caf\xc3\xa9", "x", "2"};
+    for (int i = 0; i < 5; i++) {
+        search_next_token(&p, end, token);
+        ASSERT_STR_EQ(expected[i], token, "Tokens should be split on punctuation and lower-cased");
+    }
+
+    size_t length = search_next_token(&p, end, token);
+    ASSERT_EQ(SEARCH_TOKEN_MAX, (int)length, "Long words should be cut to SEARCH_TOKEN_MAX bytes");
+    search_next_token(&p, end, token);
+    ASSERT_STR_EQ("and", token, "Cutting a word should skip the rest of it");
+    search_next_token(&p, end, token);
+    length = search_next_token(&p, end, token);
+    ASSERT_EQ(0, (int)length, "End of text should give an empty token");
+}
+
+void test_search_query(void) {
+    TEST_CASE("Search Query");
+    setup_search_test();
+
+    if (search_test_dir == NULL) {
+        printf("⚠ Skipping test - could not create temp directory\n");
+        return;
+    }
+
+    write_day("2024-01-10", "## 08:00:00\n\nCoffee with Sam.\n\n## 20:15:00\n\nRead about trains.\n", 1000);
+    write_day("2024-01-11", "## 09:30:00\n\nMore coffee, then TRAINS to Leeds\n", 1000);
+    write_day("2024-01-12", "## 07:00:00\n\nQuiet day\n", 1000);
+
+    journal_index_t journal;
+    journal_index_init(&journal);
+    journal_index_open(&journal, &search_config);
+
+    search_index_t index;
+    search_index_init(&index);
+    ASSERT_TRUE(search_index_open(&index, &journal, &search_config), "Open should build the index");
+    ASSERT_EQ(3, index.day_count, "Every day file should be indexed");
+    ASSERT_EQ(4, index.section_count, "Every time section should be indexed");
+
+    search_hit_t hits[8];
+    int total = query(&index, "coffee", hits);
+    ASSERT_EQ(2, total, "A word should match each section it occurs in");
+    if (total == 2) {
+        ASSERT_EQ(11, hits[0].date.day, "Newest match should come first");
+        ASSERT_EQ(10, hits[1].date.day, "Older match should follow");
+        const search_section_t *section = &index.sections[hits[1].section];
+        ASSERT_TRUE(section->hour == 8 && section->minute == 0, "Hit should point at its time section");
+    }
+
+    total = query(&index, "Trains", hits);
+    ASSERT_EQ(2, total, "Queries should ignore case");
+
+    total = query(&index, "coffee trains", hits);
+    ASSERT_EQ(1, total, "All words should occur in the same section");
+    if (total == 1) {
+        ASSERT_EQ(11, hits[0].date.day, "Only the section with both words should match");
+    }
+
+    total = query(&index, "coffee bicycles", hits);
+    ASSERT_EQ(0, total, "An unknown word should match nothing");
+    total = query(&index, "  ,.!  ", hits);
+    ASSERT_EQ(0, total, "A query without words should match nothing");
+    total = query(&index, "08", hits);
+    ASSERT_EQ(0, total, "Header times should not be indexed");
+
+    total = search_index_query(&index, "coffee", hits, 1);
+    ASSERT_EQ(2, total, "The total should count hits beyond max_hits");
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", search_test_dir, SEARCH_INDEX_FILE);
+    ASSERT_TRUE(access(path, F_OK) == 0, "Index should be saved next to the journal");
+
+    search_index_free(&index);
+    journal_index_free(&journal);
+    cleanup_search_test();
+}
+
+void test_search_update(void) {
+    TEST_CASE("Incremental Search Update");
+    setup_search_test();
+
+    if (search_test_dir == NULL) {
+        printf("⚠ Skipping test - could not create temp directory\n");
+        return;
+    }
+
+    write_day("2024-03-01", "## 08:00:00\n\nalpha shared\n", 1000);
+    write_day("2024-03-02", "## 08:00:00\n\nbeta shared\n", 1000);
+    write_day("2024-03-03", "## 08:00:00\n\ngamma shared\n", 1000);
+
+    journal_index_t journal;
+    journal_index_init(&journal);
+    journal_index_open(&journal, &search_config);
+    search_index_t index;
+    search_index_init(&index);
+    search_index_open(&index, &journal, &search_config);
+
+    // A saved index loads back as it was
+    search_index_t loaded;
+    search_index_init(&loaded);
+    ASSERT_TRUE(search_index_load(&loaded, &search_config), "Saved index should load");
+    search_hit_t hits[8];
+    int total = query(&loaded, "shared", hits);
+    ASSERT_EQ(3, total, "Loaded index should answer queries");
+    ASSERT_TRUE(search_index_update(&loaded, &journal, &search_config), "Update should succeed");
+    ASSERT_FALSE(loaded.dirty, "An up-to-date index should not be rebuilt");
+    search_index_free(&loaded);
+
+    // Edit one day, delete another, add a new one
+    write_day("2024-03-02", "## 08:00:00\n\ndelta shared\n\n## 09:00:00\n\nepsilon\n", 2000);
+    char path[512];
+    snprintf(path, sizeof(path), "%s/2024-03-03.md", search_test_dir);
+    unlink(path);
+    write_day("2024-03-04", "## 10:00:00\n\nzeta alpha\n", 1000);
+    journal_index_refresh(&journal, &search_config);
+
+    ASSERT_TRUE(search_index_update(&index, &journal, &search_config), "Update should succeed");
+    ASSERT_TRUE(index.dirty, "A changed journal should dirty the index");
+    ASSERT_EQ(3, index.day_count, "Days should follow the journal");
+    ASSERT_EQ(4, index.section_count, "Sections should follow the journal");
+
+    total = query(&index, "beta", hits);
+    ASSERT_EQ(0, total, "Words removed from a day should no longer match");
+    total = query(&index, "gamma", hits);
+    ASSERT_EQ(0, total, "Words from a deleted day should no longer match");
+    total = query(&index, "epsilon", hits);
+    ASSERT_EQ(1, total, "Words added to a day should match");
+    total = query(&index, "alpha", hits);
+    ASSERT_EQ(2, total, "Unchanged days should keep their postings");
+    if (total == 2) {
+        ASSERT_EQ(4, hits[0].date.day, "New day should be found");
+        ASSERT_EQ(1, hits[1].date.day, "Unchanged day should still be found");
+    }
+    total = query(&index, "shared", hits);
+    ASSERT_EQ(2, total, "Postings should be merged across kept and new days");
+
+    for (int i = 0; i < index.term_count; i++) {
+        ASSERT_TRUE(index.terms[i].posting_count > 0, "Terms without postings should be dropped");
+        if (index.terms[i].posting_count == 0) break;
+    }
+
+    // A damaged file is rejected rather than trusted
+    ASSERT_TRUE(search_index_save(&index, &search_config), "Save should succeed");
+    snprintf(path, sizeof(path), "%s/%s", search_test_dir, SEARCH_INDEX_FILE);
+    struct stat st;
+    stat(path, &st);
+    truncate(path, st.st_size / 2);
+    ASSERT_FALSE(search_index_load(&loaded, &search_config), "Truncated index should not load");
+    ASSERT_EQ(0, loaded.day_count, "Failed load should leave an empty index");
+
+    search_index_free(&index);
+    journal_index_free(&journal);
+    cleanup_search_test();
+}
+
+void test_search_rank(void) {
+    TEST_CASE("Ranked Search");
+    setup_search_test();
+
+    if (search_test_dir == NULL) {
+        printf("⚠ Skipping test - could not create temp directory\n");
+        return;
+    }
+
+    // Sections of equal length that differ in how often "kayak" occurs,
+    // plus a long one that mentions it once among filler
+    write_day("2024-04-01", "## 08:00:00\n\nkayak river lunch home\n\n"
+                            "## 12:00:00\n\nkayak kayak kayak river\n", 1000);
+    write_day("2024-04-02", "## 08:00:00\n\nkayak kayak lunch home\n\n"
+                            "## 12:00:00\n\nlunch home river tea\n", 1000);
+    write_day("2024-04-03", "## 08:00:00\n\nkayak one two three four five six seven eight nine ten "
+                            "eleven twelve thirteen fourteen fifteen sixteen\n", 1000);
+
+    journal_index_t journal;
+    journal_index_init(&journal);
+    journal_index_open(&journal, &search_config);
+    search_index_t index;
+    search_index_init(&index);
+    search_index_open(&index, &journal, &search_config);
+
+    search_hit_t hits[8];
+    int total = search_index_rank(&index, "kayak", hits, 8);
+    ASSERT_EQ(4, total, "Every section with the word should match");
+    if (total == 4) {
+        ASSERT_TRUE(hits[0].date.day == 1 && index.sections[hits[0].section].hour == 12,
+                    "More occurrences should rank higher");
+        ASSERT_EQ(2, hits[1].date.day, "Two occurrences should rank next");
+        ASSERT_EQ(3, hits[3].date.day, "A long section should rank below a short one");
+        ASSERT_TRUE(hits[0].score > hits[1].score && hits[1].score > hits[2].score && hits[2].score > hits[3].score,
+                    "Hits should come best first");
+    }
+
+    total = search_index_rank(&index, "kayak tea", hits, 8);
+    ASSERT_EQ(5, total, "Sections with any of the words should match");
+    total = search_index_rank(&index, "river lunch", hits, 8);
+    ASSERT_EQ(4, total, "Ranking should cover every section with a word");
+    if (total == 4) {
+        ASSERT_TRUE(hits[1].score > hits[2].score, "Sections with both words should rank first");
+    }
+
+    total = search_index_rank(&index, "kayak", hits, 2);
+    ASSERT_EQ(4, total, "The total should count hits beyond max_hits");
+    ASSERT_TRUE(hits[0].date.day == 1 && hits[1].date.day == 2, "The bounded heap should keep the best hits");
+
+    total = search_index_rank(&index, "kayak zeppelin", hits, 8);
+    ASSERT_EQ(4, total, "Unknown words should not rule out the others");
+    total = search_index_rank(&index, "zeppelin", hits, 8);
+    ASSERT_EQ(0, total, "Only unknown words should match nothing");
+
+    search_index_t loaded;
+    search_index_init(&loaded);
+    search_index_load(&loaded, &search_config);
+    ASSERT_TRUE(loaded.token_total == index.token_total && index.token_total == 33,
+                "Section lengths should add up after building and loading");
+    search_index_free(&loaded);
+
+    search_index_free(&index);
+    journal_index_free(&journal);
+    cleanup_search_test();
+}
+
+// Poll the search panel the way run_app does until the hits on screen
+// answer the query line
+static int wait_for_panel(app_state_t *state) {
+    for (int i = 0; i < 5000; i++) {
+        search_panel_poll(state);
+        if (!search_panel_waiting(state)) return 1;
+        usleep(1000);
+    }
+    return 0;
+}
+
+static void type_text(app_state_t *state, const char *text) {
+    for (const char *p = text; *p; p++) {
+        handle_search_input(state, (unsigned char)*p);
+    }
+}
+
+void test_search_panel(void) {
+    TEST_CASE("As-You-Type Search Panel");
+    setup_search_test();
+
+    if (search_test_dir == NULL) {
+        printf("⚠ Skipping test - could not create temp directory\n");
+        return;
+    }
+
+    write_day("2024-05-01", "## 08:00:00\n\nCoffee with Sam\n", 1000);
+    write_day("2024-05-02", "## 09:00:00\n\nCoffee again, then a train\n\n## 18:00:00\n\nHome\n", 1000);
+
+    app_state_t state;
+    memset(&state, 0, sizeof(state));
+    state.config = search_config;
+    state.mode = MODE_CALENDAR;
+    journal_index_init(&state.index);
+    journal_index_open(&state.index, &state.config);
+    search_index_init(&state.search);
+    trigram_index_init(&state.trigram);
+
+    open_search_panel(&state);
+    ASSERT_TRUE(state.panel != NULL, "Opening search should create the panel");
+    if (state.panel == NULL) {
+        journal_index_free(&state.index);
+        cleanup_search_test();
+        return;
+    }
+    ASSERT_EQ(MODE_SEARCH, state.mode, "Opening search should switch to search mode");
+
+    // Every keystroke posts a query; only the last one's hits are shown
+    type_text(&state, "coffex");
+    handle_search_input(&state, KEY_BACKSPACE);
+    handle_search_input(&state, 'e');
+    ASSERT_STR_EQ("coffee", state.panel->query, "Typing and backspace should edit the query line");
+    ASSERT_TRUE(wait_for_panel(&state), "The worker should answer the query");
+    ASSERT_EQ(2, state.panel->total, "Hits should match the final query line");
+    ASSERT_TRUE(state.search_loaded, "The worker should have loaded the index");
+
+    // Results of a superseded query never reach the screen
+    type_text(&state, " zzz");
+    ASSERT_TRUE(search_panel_waiting(&state), "An edited query should be waiting for its hits");
+    handle_search_input(&state, 21);  // Ctrl-U
+    ASSERT_FALSE(search_panel_waiting(&state), "An empty query line has nothing to wait for");
+    usleep(20000);
+    search_panel_poll(&state);
+    ASSERT_EQ(0, state.panel->shown, "Late hits for an old query should be dropped");
+
+    type_text(&state, "\"rain\"");
+    ASSERT_TRUE(wait_for_panel(&state), "The worker should answer a fragment query");
+    ASSERT_EQ(1, state.panel->total, "A fragment should match inside words");
+
+    handle_search_input(&state, '\n');
+    ASSERT_EQ(MODE_CALENDAR, state.mode, "Enter should leave search mode");
+    ASSERT_EQ(2, state.selected_date.day, "Enter should select the hit's day");
+
+    search_panel_free(&state);
+    ASSERT_TRUE(state.panel == NULL, "Freeing should stop the worker");
+    trigram_index_free(&state.trigram);
+    search_index_free(&state.search);
+    journal_index_free(&state.index);
+    cleanup_search_test();
+}
+
+void run_search_tests(void) {
+    TEST_SUITE("Full-Text Search");
+
+    test_search_tokenizer();
+    test_search_query();
+    test_search_update();
+    test_search_rank();
+    test_search_panel();
+}
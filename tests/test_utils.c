@@ -123,6 +123,30 @@ void test_is_today() {
     ASSERT_FALSE(is_today(tomorrow), "Tomorrow should not be today");
 }
 
+void test_day_numbers() {
+    TEST_CASE("Day Numbers");
+    
+    date_t epoch = {1970, 1, 1};
+    ASSERT_EQ(0, date_to_days(epoch), "1970-01-01 should be day 0");
+    
+    date_t leap_day = {2024, 2, 29};
+    date_t after_leap = {2024, 3, 1};
+    ASSERT_EQ(1, date_to_days(after_leap) - date_to_days(leap_day), "Leap day should be one day before March 1");
+    
+    date_t start = {1900, 1, 1};
+    date_t end = {3000, 12, 31};
+    int mismatches = 0;
+    date_t walk = start;
+    for (int day = date_to_days(start); day <= date_to_days(end); day++) {
+        date_t converted = days_to_date(day);
+        if (date_compare(converted, walk) != 0 || date_to_days(walk) != day) {
+            mismatches++;
+        }
+        date_add_days(&walk, 1);
+    }
+    ASSERT_EQ(0, mismatches, "Day numbers should round-trip across the supported range");
+}
+
 void run_utils_tests() {
     TEST_SUITE("Utility Functions");
     
@@ -131,4 +155,5 @@ void run_utils_tests() {
     test_day_of_week();
     test_date_compare();
     test_is_today();
+    test_day_numbers();
 }
\ No newline at end of file